@@ -0,0 +1,123 @@
+// Checks that steady frames allocate nothing from the general heap: after
+// a few warmup frames, a frame of scene update, culling, occlusion and
+// render queue building (everything but the GL calls) must not call
+// operator new. Counts every allocation of the process by replacing the
+// global operator new, prints the count per frame, and exits with 1 if
+// a steady frame allocated.
+// Run with: ./allocation_bench [nodeCount]
+
+#include "SceneGraph.hpp"
+#include "SceneNode.hpp"
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+#include "OcclusionBuffer.hpp"
+#include "RenderQueue.hpp"
+#include "Frustum.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static std::atomic<size_t> s_allocations(0);
+
+void* operator new(size_t size) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    size_t nodeCount = (argc > 1) ? (size_t)std::atol(argv[1]) : 20000;
+    const size_t branching = 8;
+    const int warmupFrames = 10;
+    const int measuredFrames = 100;
+
+    JobSystem jobs(2);
+
+    // Group nodes in a grid below a root, every one of them drawn
+    SceneGraph scene;
+    SceneNode* root = new SceneNode(nullptr, "", "", &scene);
+    std::vector<SceneNode*> nodes(1, root);
+    for (size_t parent = 0; nodes.size() < nodeCount; ++parent) {
+        for (size_t c = 0; c < branching && nodes.size() < nodeCount; ++c) {
+            SceneNode* node = new SceneNode(nullptr, "", "", &scene);
+            node->GetLocalTransform().Translate((float)c - 4.0f, 0.0f, -2.0f);
+            scene.SetLocalBounds(node->GetSceneIndex(), AABB(glm::vec3(-0.5f), glm::vec3(0.5f)));
+            nodes[parent]->AddChild(node);
+            nodes.push_back(node);
+        }
+    }
+
+    // A wall as occluder
+    std::vector<glm::vec3> wallPositions = {
+        glm::vec3(-50.0f, -50.0f, -30.0f), glm::vec3(50.0f, -50.0f, -30.0f),
+        glm::vec3(50.0f, 50.0f, -30.0f), glm::vec3(-50.0f, 50.0f, -30.0f)
+    };
+    std::vector<unsigned int> wallIndices = { 0, 1, 2, 0, 2, 3 };
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 512.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum;
+    OcclusionBuffer occlusionBuffer;
+    RenderQueue queue;
+
+    size_t steadyAllocations = 0;
+    for (int frame = 0; frame < warmupFrames + measuredFrames; ++frame) {
+        size_t before = s_allocations.load();
+
+        FrameArena::GetFrame().Reset();
+        root->GetLocalTransform().Rotate(0.01f, 0.0f, 1.0f, 0.0f);
+        scene.UpdateWorldTransforms(&jobs);
+
+        glm::mat4 viewProjection = projection * view;
+        frustum.Extract(viewProjection);
+        CullStats cull = scene.Cull(frustum);
+        occlusionBuffer.Begin(viewProjection);
+        occlusionBuffer.AddOccluder(wallPositions, wallIndices, glm::mat4(1.0f));
+        occlusionBuffer.Rasterize(&jobs);
+        scene.CullOccluded(occlusionBuffer, cull);
+
+        // What SceneNode::Submit does for nodes with an object, with made
+        // up GL names: four programs, half of them instanced
+        queue.Begin(view, projection, 512.0f);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            int index = nodes[i]->GetSceneIndex();
+            if (scene.GetFlags(index) & NodeFlagVisible) {
+                GLuint program = 1 + (GLuint)(i % 4);
+                queue.Push(RenderPassOpaque, program, (program % 2 == 0) ? program + 10 : 0, 1 + (GLuint)(i % 3),
+                           1 + (GLuint)(i % 5), 36, scene.GetWorldTransform(index).GetMatrix());
+            }
+        }
+        queue.Sort();
+        queue.BuildBatches();
+
+        size_t allocations = s_allocations.load() - before;
+        if (frame >= warmupFrames) {
+            steadyAllocations += allocations;
+        }
+        if (frame == 0 || frame == warmupFrames - 1 || frame == warmupFrames + measuredFrames - 1) {
+            std::cout << "frame " << frame << ": " << allocations << " allocations, "
+                      << queue.GetStats().packets << " packets, "
+                      << FrameArena::GetFrame().GetUsed() << " arena bytes\n";
+        }
+    }
+
+    std::cout << "Steady frames: " << steadyAllocations << " allocations in " << measuredFrames << " frames\n";
+    delete root;
+    return steadyAllocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+// Microbenchmarks of the loaders and the scene's CPU hot paths, none of
+// which need an OpenGL context. Inputs are generated into the temp
+// directory, so results do not depend on the working directory or on the
+// assets. Every case runs a few warmup repetitions, then the measured
+// ones, and prints one JSON object per line on stdout:
+//   {"case": ..., "items": ..., "reps": ..., "min_ms": ..., "median_ms": ...,
+//    "mean_ms": ..., "max_ms": ..., "stddev_ms": ..., "ns_per_item": ...}
+// Compare medians (or minimums) between builds; ns_per_item is median
+// based. What the code under test prints is discarded while it runs.
+// Run with: ./micro_bench [reps] [case name filter]
+
+#include "Object.hpp"
+#include "Image.hpp"
+#include "Geometry.hpp"
+#include "Transform.hpp"
+#include "SceneGraph.hpp"
+#include "SceneNode.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Gives the benchmark the OBJ and MTL parsers. Objects are reused rather
+// than deleted, their destructor releases GL names.
+class BenchObject : public Object{
+public:
+    void ParseOBJ(const std::string& filepath) { parseOBJ(filepath); }
+    // Drops the parsed geometry
+    void Reset() { m_geometry = Geometry(); }
+    static bool ReadMTL(const std::string& filepath, std::string& diffuseMap, std::string& normalMap) {
+        return readMTL(filepath, diffuseMap, normalMap);
+    }
+};
+
+// Swallows what the code under test prints
+class NullBuffer : public std::streambuf{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static NullBuffer s_nullBuffer;
+static std::ostream s_results(std::cout.rdbuf());
+static int s_warmupReps = 3;
+static int s_reps = 15;
+static std::string s_filter;
+
+// Runs a case and prints its line
+// @param name: Case name
+// @param items: Units of work per repetition, for ns_per_item
+// @param setup: Prepares a repetition, not timed
+// @param run: The timed work
+static void Measure(const std::string& name, size_t items, const std::function<void()>& setup, const std::function<void()>& run) {
+    if (!s_filter.empty() && name.find(s_filter) == std::string::npos) {
+        return;
+    }
+    std::vector<double> samples;
+    std::streambuf* console = std::cout.rdbuf(&s_nullBuffer);
+    std::streambuf* errors = std::cerr.rdbuf(&s_nullBuffer);
+    for (int rep = 0; rep < s_warmupReps + s_reps; ++rep) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        if (rep >= s_warmupReps) {
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    std::cout.rdbuf(console);
+    std::cerr.rdbuf(errors);
+
+    std::sort(samples.begin(), samples.end());
+    double mean = 0.0;
+    for (double sample : samples) {
+        mean += sample;
+    }
+    mean /= samples.size();
+    double variance = 0.0;
+    for (double sample : samples) {
+        variance += (sample - mean) * (sample - mean);
+    }
+    double median = (samples.size() % 2 == 1) ? samples[samples.size() / 2]
+                                              : 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+    s_results << "{\"case\": \"" << name << "\", \"items\": " << items << ", \"reps\": " << samples.size()
+              << ", \"min_ms\": " << samples.front() << ", \"median_ms\": " << median
+              << ", \"mean_ms\": " << mean << ", \"max_ms\": " << samples.back()
+              << ", \"stddev_ms\": " << std::sqrt(variance / samples.size())
+              << ", \"ns_per_item\": " << median * 1.0e6 / std::max<size_t>(items, 1) << "}" << std::endl;
+}
+
+// Grid of size x size quads, one vertex per corner shared by its quads,
+// as OBJ faces (quads, which the parser splits in two triangles)
+static void WriteGridOBJ(const std::string& path, int size) {
+    std::ofstream file(path);
+    for (int y = 0; y <= size; ++y) {
+        for (int x = 0; x <= size; ++x) {
+            file << "v " << x << " " << 0.1f * ((x * 7 + y * 13) % 5) << " " << y << "\n";
+            file << "vt " << (float)x / size << " " << (float)y / size << "\n";
+            file << "vn 0 1 0\n";
+        }
+    }
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            int a = y * (size + 1) + x + 1;
+            int corners[4] = { a, a + 1, a + size + 2, a + size + 1 };
+            file << "f";
+            for (int corner : corners) {
+                file << " " << corner << "/" << corner << "/" << corner;
+            }
+            file << "\n";
+        }
+    }
+}
+
+// Material library with many materials, each with both texture maps
+static void WriteMTL(const std::string& path, int materials) {
+    std::ofstream file(path);
+    for (int i = 0; i < materials; ++i) {
+        file << "newmtl material" << i << "\n"
+             << "Ns 96.078431\nKa 1.000000 1.000000 1.000000\nKd 0.640000 0.640000 0.640000\n"
+             << "Ks 0.500000 0.500000 0.500000\nd 1.000000\nillum 2\n"
+             << "map_Kd diffuse" << i << ".ppm\nmap_Bump normal" << i << ".ppm\n\n";
+    }
+}
+
+// ASCII PPM in the layout Image::LoadPPM reads, one value per line
+static void WritePPM(const std::string& path, int width, int height) {
+    std::ofstream file(path);
+    file << "P3\n# micro_bench\n" << width << " " << height << "\n255\n";
+    for (int i = 0; i < width * height * 3; ++i) {
+        file << (i * 37) % 256 << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    s_reps = (argc > 1) ? std::max(1, std::atoi(argv[1])) : s_reps;
+    s_filter = (argc > 2) ? argv[2] : "";
+
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "micro_bench_data";
+    if (!std::filesystem::create_directories(directory, error) && error) {
+        std::cerr << "Could not create " << directory << ": " << error.message() << std::endl;
+        return 1;
+    }
+    const std::string objPath = (directory / "grid.obj").string();
+    const std::string mtlPath = (directory / "materials.mtl").string();
+    const std::string ppmPath = (directory / "image.ppm").string();
+    const int gridSize = 128;
+    const int materialCount = 2000;
+    const int imageSize = 256;
+    WriteGridOBJ(objPath, gridSize);
+    WriteMTL(mtlPath, materialCount);
+    WritePPM(ppmPath, imageSize, imageSize);
+    const size_t gridQuads = (size_t)gridSize * gridSize;
+    const size_t gridVertices = (size_t)(gridSize + 1) * (gridSize + 1);
+
+    // Loaders
+    BenchObject* object = new BenchObject();
+    Measure("parse_obj", gridQuads,
+            [&]() { object->Reset(); },
+            [&]() { object->ParseOBJ(objPath); });
+
+    Geometry loaded = object->getGeometry();
+    Geometry geometry;
+    Measure("geometry_gen", gridVertices,
+            [&]() { geometry = loaded; },
+            [&]() { geometry.Gen(); });
+    object->Reset();
+
+    Measure("parse_mtl", materialCount,
+            []() {},
+            [&]() {
+                std::string diffuseMap, normalMap;
+                BenchObject::ReadMTL(mtlPath, diffuseMap, normalMap);
+            });
+
+    Image* image = nullptr;
+    Measure("load_ppm", (size_t)imageSize * imageSize,
+            [&]() { delete image; image = new Image(ppmPath); },
+            [&]() { image->LoadPPM(true); });
+    delete image;
+
+    // The lookup parseOBJ does for every face corner: each grid vertex is
+    // referenced by up to four quads
+    std::vector<VertexKey> corners;
+    for (int y = 0; y < gridSize; ++y) {
+        for (int x = 0; x < gridSize; ++x) {
+            unsigned int a = y * (gridSize + 1) + x;
+            unsigned int quad[4] = { a, a + 1, a + gridSize + 2, a + gridSize + 1 };
+            for (unsigned int corner : quad) {
+                corners.push_back(VertexKey{ corner, corner, corner });
+            }
+        }
+    }
+    std::map<VertexKey, unsigned int> vertexMap;
+    Measure("vertex_dedup", corners.size(),
+            [&]() { vertexMap.clear(); },
+            [&]() {
+                for (const VertexKey& key : corners) {
+                    if (vertexMap.find(key) == vertexMap.end()) {
+                        unsigned int index = (unsigned int)vertexMap.size();
+                        vertexMap[key] = index;
+                    }
+                }
+            });
+
+    // Transform composition: a chain of parent * local products, and the
+    // Translate / Rotate / Scale that build a local transform
+    const size_t transformCount = 100000;
+    std::vector<Transform> locals(transformCount);
+    for (size_t i = 0; i < transformCount; ++i) {
+        locals[i].Translate(1.0f, 0.0f, 0.5f);
+        locals[i].Rotate(0.01f * (i % 7), 0.0f, 1.0f, 0.0f);
+    }
+    Transform world;
+    Measure("transform_compose", transformCount,
+            [&]() { world.LoadIdentity(); },
+            [&]() {
+                for (size_t i = 0; i < transformCount; ++i) {
+                    world = world * locals[i];
+                }
+            });
+    Transform built;
+    Measure("transform_build", transformCount,
+            [&]() { built.LoadIdentity(); },
+            [&]() {
+                for (size_t i = 0; i < transformCount; ++i) {
+                    built.Translate(0.001f, 0.0f, 0.0f);
+                    built.Rotate(0.001f, 0.0f, 1.0f, 0.0f);
+                    built.Scale(1.0f, 1.0f, 1.0f);
+                }
+            });
+
+    // Synthetic hierarchy, breadth first with eight children per node,
+    // sharing an Object without GL resources. scene_world_transforms turns
+    // the root before every repetition, so the pass recomputes the world
+    // transform of every node: the worst case of a frame's scene update.
+    const size_t nodeCount = 100000;
+    const size_t branching = 8;
+    SceneGraph scene;
+    Object* sharedObject = new Object();
+    SceneNode* root = new SceneNode(sharedObject, "", "", &scene);
+    std::vector<SceneNode*> nodes(1, root);
+    for (size_t parent = 0; nodes.size() < nodeCount; ++parent) {
+        for (size_t c = 0; c < branching && nodes.size() < nodeCount; ++c) {
+            SceneNode* node = new SceneNode(sharedObject, "", "", &scene);
+            node->GetLocalTransform().Translate(1.0f, 0.0f, 0.5f);
+            node->GetLocalTransform().Rotate(0.1f, 0.0f, 1.0f, 0.0f);
+            nodes[parent]->AddChild(node);
+            nodes.push_back(node);
+        }
+    }
+    scene.UpdateWorldTransforms();
+
+    Measure("scene_world_transforms", nodeCount,
+            [&]() { root->GetLocalTransform().Rotate(0.01f, 0.0f, 1.0f, 0.0f); },
+            [&]() { scene.UpdateWorldTransforms(); });
+
+    delete root;
+    std::filesystem::remove_all(directory, error);
+    return 0;
+}
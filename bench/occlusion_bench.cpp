@@ -0,0 +1,124 @@
+// Measures the CPU occlusion buffer on a synthetic scene: a terrain grid
+// and a row of walls as occluders, and a field of props around them.
+// Reports rasterization and test times, and the share of props rejected.
+// Run with: ./occlusion_bench [propCount]
+
+#include "OcclusionBuffer.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// Milliseconds since start
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Appends a quad of two triangles
+static void AddQuad(std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices,
+                    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    unsigned int first = (unsigned int)positions.size();
+    positions.push_back(a);
+    positions.push_back(b);
+    positions.push_back(c);
+    positions.push_back(d);
+    unsigned int quad[] = { 0, 1, 2, 0, 2, 3 };
+    for (int i = 0; i < 6; ++i) {
+        indices.push_back(first + quad[i]);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t propCount = (argc > 1) ? (size_t)std::atol(argv[1]) : 20000;
+    const int passes = 100;
+
+    // Occluders: a hilly terrain grid and walls across the view
+    std::vector<glm::vec3> terrainPositions, wallPositions;
+    std::vector<unsigned int> terrainIndices, wallIndices;
+    const int gridSize = 32;
+    const float cell = 16.0f;
+    for (int z = 0; z < gridSize; ++z) {
+        for (int x = 0; x < gridSize; ++x) {
+            auto height = [](float px, float pz) { return 2.0f * std::sin(px * 0.05f) * std::cos(pz * 0.05f) - 2.0f; };
+            float x0 = (x - gridSize / 2) * cell, z0 = -z * cell;
+            float x1 = x0 + cell, z1 = z0 - cell;
+            AddQuad(terrainPositions, terrainIndices,
+                    glm::vec3(x0, height(x0, z0), z0), glm::vec3(x1, height(x1, z0), z0),
+                    glm::vec3(x1, height(x1, z1), z1), glm::vec3(x0, height(x0, z1), z1));
+        }
+    }
+    for (int w = 0; w < 8; ++w) {
+        float x0 = -120.0f + w * 32.0f;
+        AddQuad(wallPositions, wallIndices,
+                glm::vec3(x0, -2.0f, -60.0f), glm::vec3(x0 + 28.0f, -2.0f, -60.0f),
+                glm::vec3(x0 + 28.0f, 12.0f, -60.0f), glm::vec3(x0, 12.0f, -60.0f));
+    }
+
+    // Props: small boxes scattered over the terrain, in front of and behind the walls
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> spreadX(-250.0f, 250.0f);
+    std::uniform_real_distribution<float> spreadZ(-500.0f, -5.0f);
+    std::uniform_real_distribution<float> size(0.5f, 3.0f);
+    std::vector<AABB> props(propCount);
+    for (size_t i = 0; i < propCount; ++i) {
+        glm::vec3 base(spreadX(random), -2.0f, spreadZ(random));
+        float half = size(random);
+        props[i] = AABB(base - glm::vec3(half, 0.0f, half), base + glm::vec3(half, 2.0f * half, half));
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 512.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 4.0f, 10.0f), glm::vec3(0.0f, 2.0f, -50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+    Frustum frustum;
+    frustum.Extract(viewProjection);
+
+    OcclusionBuffer buffer;
+    JobSystem& jobs = JobSystem::Get();
+    JobSystem* modes[] = { nullptr, &jobs };
+    const char* modeNames[] = { "calling thread", "job system" };
+
+    size_t inFrustum = 0, occluded = 0;
+    for (int mode = 0; mode < 2; ++mode) {
+        double rasterizeMs = 0.0, testMs = 0.0;
+        for (int pass = 0; pass < passes; ++pass) {
+            // Occluder vertices are projected into the frame arena
+            FrameArena::GetFrame().Reset();
+            auto start = std::chrono::steady_clock::now();
+            buffer.Begin(viewProjection);
+            buffer.AddOccluder(terrainPositions, terrainIndices, glm::mat4(1.0f));
+            buffer.AddOccluder(wallPositions, wallIndices, glm::mat4(1.0f));
+            buffer.Rasterize(modes[mode]);
+            rasterizeMs += ElapsedMs(start);
+
+            start = std::chrono::steady_clock::now();
+            inFrustum = 0;
+            occluded = 0;
+            for (size_t i = 0; i < propCount; ++i) {
+                if (!frustum.Intersects(props[i])) {
+                    continue;
+                }
+                ++inFrustum;
+                if (buffer.IsOccluded(props[i])) {
+                    ++occluded;
+                }
+            }
+            testMs += ElapsedMs(start);
+        }
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Rasterize on " << modeNames[mode] << " (" << jobs.GetThreadCount() << " threads available): "
+                  << rasterizeMs / passes << " ms, " << buffer.GetTriangleCount() << " triangles, "
+                  << buffer.GetWidth() << "x" << buffer.GetHeight() << "\n";
+        std::cout << "Test " << propCount << " props: " << testMs / passes << " ms\n";
+    }
+    std::cout << std::setprecision(1) << "Props in frustum: " << inFrustum << ", occluded: " << occluded
+              << " (" << (inFrustum > 0 ? 100.0 * occluded / inFrustum : 0.0) << "% of draws rejected)\n";
+    return 0;
+}
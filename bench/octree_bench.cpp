@@ -0,0 +1,134 @@
+// Measures LooseOctree insert, update and query throughput at 10k to 1M items.
+// Run with: ./octree_bench [maxItems]
+
+#include "LooseOctree.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// Milliseconds since start
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Prints one result line: operations per second
+static void Report(const char* name, size_t items, size_t operations, double ms) {
+    std::cout << std::setw(9) << items << "  " << std::left << std::setw(22) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(2) << ms << " ms"
+              << std::setw(14) << std::setprecision(0) << operations / (ms / 1000.0) << " /s\n";
+}
+
+int main(int argc, char** argv) {
+    size_t maxItems = (argc > 1) ? (size_t)std::atol(argv[1]) : 1000000;
+    const float worldHalfSize = 1000.0f;
+    const size_t queryCount = 1000;
+    const size_t frustumCount = 100;
+    const size_t nearestCount = 8;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-worldHalfSize, worldHalfSize);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    JobSystem& jobs = JobSystem::Get();
+    std::cout << "items      operation                    time          throughput\n";
+
+    for (size_t items = 10000; items <= maxItems; items *= 10) {
+        std::vector<AABB> boxes(items);
+        for (size_t i = 0; i < items; ++i) {
+            glm::vec3 center(position(random), position(random), position(random));
+            glm::vec3 half(size(random));
+            boxes[i] = AABB(center - half, center + half);
+        }
+
+        // About one leaf cell per item at this density
+        int depth = 1;
+        for (size_t cells = 8; cells < items; cells *= 8) {
+            ++depth;
+        }
+        LooseOctree octree(glm::vec3(0.0f), worldHalfSize, depth);
+        std::vector<int> handles(items);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < items; ++i) {
+            handles[i] = octree.Insert(boxes[i], (int)i);
+        }
+        Report("insert", items, items, ElapsedMs(start));
+
+        // Every item moves a little, as in an animated scene
+        for (size_t i = 0; i < items; ++i) {
+            glm::vec3 offset(step(random), step(random), step(random));
+            boxes[i] = AABB(boxes[i].min + offset, boxes[i].max + offset);
+        }
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < items; ++i) {
+            octree.Update(handles[i], boxes[i]);
+        }
+        Report("update", items, items, ElapsedMs(start));
+
+        // Query shapes
+        std::vector<OctreeQuery> boxQueries(queryCount), sphereQueries(queryCount), nearestQueries(queryCount);
+        for (size_t q = 0; q < queryCount; ++q) {
+            glm::vec3 center(position(random), position(random), position(random));
+            boxQueries[q].type = OctreeQuery::Box;
+            boxQueries[q].box = AABB(center - glm::vec3(25.0f), center + glm::vec3(25.0f));
+            sphereQueries[q].type = OctreeQuery::Sphere;
+            sphereQueries[q].sphere.center = center;
+            sphereQueries[q].sphere.radius = 25.0f;
+            nearestQueries[q].type = OctreeQuery::Nearest;
+            nearestQueries[q].point = center;
+            nearestQueries[q].count = nearestCount;
+        }
+        std::vector<Frustum> frustums(frustumCount);
+        std::vector<OctreeQuery> frustumQueries(frustumCount);
+        for (size_t q = 0; q < frustumCount; ++q) {
+            glm::vec3 eye(position(random), position(random), position(random));
+            float yaw = angle(random);
+            glm::vec3 direction(std::cos(yaw), 0.0f, std::sin(yaw));
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+            frustums[q].Extract(projection * glm::lookAt(eye, eye + direction, glm::vec3(0.0f, 1.0f, 0.0f)));
+            frustumQueries[q].type = OctreeQuery::FrustumVolume;
+            frustumQueries[q].frustum = &frustums[q];
+        }
+
+        std::vector<std::vector<int>> results;
+        const std::vector<OctreeQuery>* batches[] = { &boxQueries, &sphereQueries, &frustumQueries, &nearestQueries };
+        const char* names[] = { "query box", "query sphere", "query frustum", "query 8 nearest" };
+        for (int b = 0; b < 4; ++b) {
+            start = std::chrono::steady_clock::now();
+            octree.QueryBatch(*batches[b], results, nullptr);
+            Report(names[b], items, batches[b]->size(), ElapsedMs(start));
+        }
+
+        // The same box queries spread over all threads
+        start = std::chrono::steady_clock::now();
+        octree.QueryBatch(boxQueries, results, &jobs);
+        Report("query box (parallel)", items, boxQueries.size(), ElapsedMs(start));
+
+        // Full scan, what every query cost before
+        start = std::chrono::steady_clock::now();
+        size_t scanned = 0;
+        for (size_t q = 0; q < 100; ++q) {
+            const AABB& query = boxQueries[q].box;
+            for (size_t i = 0; i < items; ++i) {
+                if (boxes[i].min.x <= query.max.x && boxes[i].max.x >= query.min.x &&
+                    boxes[i].min.y <= query.max.y && boxes[i].max.y >= query.min.y &&
+                    boxes[i].min.z <= query.max.z && boxes[i].max.z >= query.min.z) {
+                    ++scanned;
+                }
+            }
+        }
+        Report("query box (full scan)", items, 100, ElapsedMs(start));
+        std::cout << "           cells " << octree.GetCellCount() << ", scan matches " << scanned << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Measures Renderer::RecordCommands on a scene of visible nodes, recorded
+// on the calling thread alone and then on every thread of the JobSystem,
+// and checks that both produce the same packets.
+// Nodes have an Object without GL resources, so no context is needed.
+// Run with: ./record_bench [nodeCount]
+
+#include "Renderer.hpp"
+#include "SceneGraph.hpp"
+#include "SceneNode.hpp"
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Gives the benchmark the queue's packets
+class BenchRenderer : public Renderer{
+public:
+    BenchRenderer(unsigned int w, unsigned int h) : Renderer(w, h) {}
+    // Sorted packet keys of the last recording
+    std::vector<uint64_t> GetSortedKeys() {
+        m_queue.Sort();
+        std::vector<uint64_t> keys;
+        for (const DrawPacket& packet : m_queue.GetCommandList().GetPackets()) {
+            keys.push_back(packet.key);
+        }
+        return keys;
+    }
+};
+
+// Average milliseconds of RecordCommands over the measured passes
+static double MeasureRecord(BenchRenderer& renderer, int warmupPasses, int measuredPasses) {
+    double totalMs = 0.0;
+    for (int pass = 0; pass < warmupPasses + measuredPasses; ++pass) {
+        auto start = std::chrono::steady_clock::now();
+        renderer.RecordCommands();
+        auto end = std::chrono::steady_clock::now();
+        if (pass >= warmupPasses) {
+            totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+    }
+    return totalMs / measuredPasses;
+}
+
+int main(int argc, char** argv) {
+    size_t nodeCount = (argc > 1) ? (size_t)std::atol(argv[1]) : 100000;
+    const int warmupPasses = 5;
+    const int measuredPasses = 50;
+
+    // A grid of nodes in front of the camera, sharing four objects
+    SceneGraph scene;
+    std::vector<Object*> objects;
+    for (int i = 0; i < 4; ++i) {
+        objects.push_back(new Object());
+    }
+    SceneNode* root = new SceneNode(nullptr, "", "", &scene);
+    size_t side = 1;
+    while (side * side < nodeCount) {
+        ++side;
+    }
+    for (size_t i = 0; i < nodeCount; ++i) {
+        SceneNode* node = new SceneNode(objects[i % objects.size()], "", "", &scene);
+        float x = ((float)(i % side) / side - 0.5f) * 40.0f;
+        float y = ((float)(i / side) / side - 0.5f) * 40.0f;
+        node->GetLocalTransform().Translate(x, y, -60.0f);
+        scene.SetLocalBounds(node->GetSceneIndex(), AABB(glm::vec3(-0.1f), glm::vec3(0.1f)));
+        root->AddChild(node);
+    }
+
+    BenchRenderer renderer(1280, 720);
+    renderer.setRoot(root);
+    renderer.Update();
+    renderer.SwapSnapshots();
+
+    renderer.SetParallelRecording(false);
+    double serialMs = MeasureRecord(renderer, warmupPasses, measuredPasses);
+    std::vector<uint64_t> serialKeys = renderer.GetSortedKeys();
+
+    renderer.SetParallelRecording(true);
+    double parallelMs = MeasureRecord(renderer, warmupPasses, measuredPasses);
+    size_t lists = renderer.GetStats().commandLists;
+    std::vector<uint64_t> parallelKeys = renderer.GetSortedKeys();
+
+    std::cout << "Command recording: " << serialKeys.size() << " visible nodes of " << nodeCount
+              << ", " << measuredPasses << " passes\n";
+    std::cout << "serial     " << serialMs << " ms\n";
+    std::cout << "parallel   " << parallelMs << " ms on " << lists << " lists ("
+              << JobSystem::Get().GetThreadCount() << " threads), speedup " << serialMs / parallelMs << "\n";
+
+    bool same = (serialKeys == parallelKeys);
+    std::cout << (same ? "Packets match" : "Packets differ") << std::endl;
+    delete root;
+    for (Object* object : objects) {
+        delete object;
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+// Measures how SceneGraph::UpdateWorldTransforms scales with the number of
+// threads, from 1 up to every hardware thread, on a synthetic scene.
+// Run with: ./scene_update_bench [nodeCount] [branching]
+
+#include "SceneGraph.hpp"
+#include "SceneNode.hpp"
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    size_t nodeCount = (argc > 1) ? (size_t)std::atol(argv[1]) : 250000;
+    size_t branching = (argc > 2) ? (size_t)std::atol(argv[2]) : 8;
+    const int warmupPasses = 5;
+    const int measuredPasses = 50;
+
+    // Breadth first tree of group nodes, every node offset from its parent
+    SceneGraph scene;
+    SceneNode* root = new SceneNode(nullptr, "", "", &scene);
+    std::vector<SceneNode*> nodes(1, root);
+    for (size_t parent = 0; nodes.size() < nodeCount; ++parent) {
+        for (size_t c = 0; c < branching && nodes.size() < nodeCount; ++c) {
+            SceneNode* node = new SceneNode(nullptr, "", "", &scene);
+            node->GetLocalTransform().Translate(1.0f, 0.0f, 0.5f);
+            node->GetLocalTransform().Rotate(0.1f, 0.0f, 1.0f, 0.0f);
+            nodes[parent]->AddChild(node);
+            nodes.push_back(node);
+        }
+    }
+    scene.UpdateWorldTransforms();
+
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads == 0) {
+        hardwareThreads = 1;
+    }
+    std::cout << "Scene update scaling: " << nodeCount << " nodes, branching " << branching
+              << ", " << measuredPasses << " passes per thread count\n";
+    std::cout << "threads   ms/pass   speedup\n";
+
+    double singleThreadMs = 0.0;
+    for (unsigned int threads = 1; threads <= hardwareThreads; ++threads) {
+        JobSystem jobs((int)threads - 1);
+        double totalMs = 0.0;
+        for (int pass = 0; pass < warmupPasses + measuredPasses; ++pass) {
+            // Moving the root makes every world transform out of date
+            root->GetLocalTransform().Rotate(0.01f, 0.0f, 1.0f, 0.0f);
+
+            auto start = std::chrono::steady_clock::now();
+            scene.UpdateWorldTransforms(&jobs);
+            auto end = std::chrono::steady_clock::now();
+            if (pass >= warmupPasses) {
+                totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+        double ms = totalMs / measuredPasses;
+        if (threads == 1) {
+            singleThreadMs = ms;
+        }
+        std::cout << std::setw(7) << threads << std::setw(10) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(2) << singleThreadMs / ms << "x\n";
+    }
+
+    delete root;
+    return 0;
+}
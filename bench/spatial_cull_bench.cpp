@@ -0,0 +1,173 @@
+// Checks the SceneGraph's octree path against its hierarchical culling and
+// measures both. Two identical generated trees are built, one of them with
+// SceneGraph::EnableSpatialIndex. Every round turns the same nodes of both,
+// updates them and culls them with the same frustum: the nodes marked
+// visible must be the same. Picking through the octree is checked against
+// a test of every node's bounds.
+// Nodes share an Object without geometry, so no GL context is needed; they
+// get unit bounds and are made cullable by hand. The Object is not deleted,
+// its destructor releases GL names.
+// Exits with 1 if the octree path disagrees.
+// Run with: ./spatial_cull_bench [nodeCount]
+
+#include "SceneGraph.hpp"
+#include "SceneNode.hpp"
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// A tree shaped like StressScene's: breadth first, children on a ring
+// around their parent, closer at each level
+static SceneNode* BuildTree(SceneGraph& scene, Object* object, size_t nodeCount, int branching,
+                            std::vector<SceneNode*>& nodes) {
+    int depth = 1;
+    for (size_t levelNodes = 1, total = 1; total < nodeCount; ++depth) {
+        levelNodes *= branching;
+        total += levelNodes;
+    }
+    const AABB unitBounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+    SceneNode* root = new SceneNode(object, "", "", &scene);
+    scene.SetLocalBounds(root->GetSceneIndex(), unitBounds);
+    scene.SetCullable(root->GetSceneIndex(), true);
+    nodes.assign(1, root);
+    std::vector<SceneNode*> level(1, root);
+    std::vector<SceneNode*> nextLevel;
+    for (int l = 1; l < depth && nodes.size() < nodeCount; ++l) {
+        float radius = 3.0f * std::pow(2.0f, (float)(depth - 1 - l));
+        nextLevel.clear();
+        for (SceneNode* parent : level) {
+            for (int c = 0; c < branching && nodes.size() < nodeCount; ++c) {
+                float angle = 6.2831853f * (c + 0.5f * l) / branching;
+                SceneNode* child = new SceneNode(object, "", "", &scene);
+                child->GetLocalTransform().Translate(radius * std::cos(angle), (l % 2 == 0 ? 0.5f : -0.5f) * radius,
+                                                     radius * std::sin(angle));
+                scene.SetLocalBounds(child->GetSceneIndex(), unitBounds);
+                scene.SetCullable(child->GetSceneIndex(), true);
+                parent->AddChild(child);
+                nextLevel.push_back(child);
+                nodes.push_back(child);
+            }
+        }
+        level.swap(nextLevel);
+    }
+    return root;
+}
+
+// Entry distance of a ray into a box
+// @return false if the ray misses it
+static bool RayHits(const glm::vec3& origin, const glm::vec3& direction, const AABB& box, float& distance) {
+    float tMin = 0.0f;
+    float tMax = FLT_MAX;
+    for (int a = 0; a < 3; ++a) {
+        float inverse = 1.0f / direction[a];
+        float t0 = (box.min[a] - origin[a]) * inverse;
+        float t1 = (box.max[a] - origin[a]) * inverse;
+        tMin = std::max(tMin, std::min(t0, t1));
+        tMax = std::min(tMax, std::max(t0, t1));
+    }
+    distance = tMin;
+    return tMin <= tMax;
+}
+
+int main(int argc, char** argv) {
+    size_t nodeCount = (argc > 1) ? (size_t)std::atol(argv[1]) : 100000;
+    const int branching = 8;
+    const int rounds = 40;
+
+    Object* object = new Object();
+    SceneGraph hierarchical;
+    SceneGraph indexed;
+    std::vector<SceneNode*> hierarchicalNodes;
+    std::vector<SceneNode*> indexedNodes;
+    SceneNode* hierarchicalRoot = BuildTree(hierarchical, object, nodeCount, branching, hierarchicalNodes);
+    SceneNode* indexedRoot = BuildTree(indexed, object, nodeCount, branching, indexedNodes);
+    hierarchical.UpdateWorldTransforms();
+    indexed.UpdateWorldTransforms();
+    AABB sceneBounds;
+    for (size_t i = 0; i < indexedNodes.size(); ++i) {
+        sceneBounds.Merge(indexed.GetWorldBounds(indexedNodes[i]->GetSceneIndex()));
+    }
+    glm::vec3 center = (sceneBounds.min + sceneBounds.max) * 0.5f;
+    glm::vec3 extent = sceneBounds.max - sceneBounds.min;
+    float halfSize = 0.5f * std::max(extent.x, std::max(extent.y, extent.z));
+    indexed.EnableSpatialIndex(center, halfSize, 8);
+
+    // One node in 10 moves, as with StressScene's default dynamic share
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 4.0f * halfSize);
+    double hierarchicalMs = 0.0;
+    double indexedMs = 0.0;
+    size_t mismatches = 0;
+    size_t pickMismatches = 0;
+    size_t visibleTotal = 0;
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 1; i < hierarchicalNodes.size(); i += 10) {
+            hierarchicalNodes[i]->GetLocalTransform().Rotate(0.05f, 0.0f, 1.0f, 0.0f);
+            indexedNodes[i]->GetLocalTransform().Rotate(0.05f, 0.0f, 1.0f, 0.0f);
+        }
+        hierarchical.UpdateWorldTransforms();
+        indexed.UpdateWorldTransforms();
+
+        // A camera circling inside the scene, looking at points around its
+        // center, so part of the scene is behind it or out of its sides
+        float angle = 6.2831853f * round / rounds;
+        glm::vec3 eye = center + glm::vec3(std::cos(angle), 0.3f, std::sin(angle)) * (0.5f * halfSize);
+        glm::vec3 target = center + glm::vec3(std::sin(3.0f * angle), 0.0f, std::cos(2.0f * angle)) * (0.3f * halfSize);
+        Frustum frustum;
+        frustum.Extract(projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        auto start = std::chrono::steady_clock::now();
+        CullStats hierarchicalStats = hierarchical.Cull(frustum);
+        auto middle = std::chrono::steady_clock::now();
+        indexed.Cull(frustum);
+        auto end = std::chrono::steady_clock::now();
+        hierarchicalMs += std::chrono::duration<double, std::milli>(middle - start).count();
+        indexedMs += std::chrono::duration<double, std::milli>(end - middle).count();
+        visibleTotal += hierarchicalStats.visible;
+
+        for (size_t i = 0; i < hierarchicalNodes.size(); ++i) {
+            bool a = (hierarchical.GetFlags(hierarchicalNodes[i]->GetSceneIndex()) & NodeFlagVisible) != 0;
+            bool b = (indexed.GetFlags(indexedNodes[i]->GetSceneIndex()) & NodeFlagVisible) != 0;
+            mismatches += (a != b) ? 1 : 0;
+        }
+
+        // The first node along the view direction, against every node
+        glm::vec3 direction = glm::normalize(target - eye);
+        float nearest = FLT_MAX;
+        for (SceneNode* node : indexedNodes) {
+            float distance;
+            if (RayHits(eye, direction, indexed.GetWorldBounds(node->GetSceneIndex()), distance)) {
+                nearest = std::min(nearest, distance);
+            }
+        }
+        SceneNode* picked = indexed.Pick(eye, direction);
+        float pickedDistance = FLT_MAX;
+        if (picked != nullptr) {
+            RayHits(eye, direction, indexed.GetWorldBounds(picked->GetSceneIndex()), pickedDistance);
+        }
+        if ((picked == nullptr) != (nearest == FLT_MAX) ||
+            std::fabs(pickedDistance - nearest) > 1.0e-3f * std::max(1.0f, nearest)) {
+            ++pickMismatches;
+        }
+    }
+
+    std::cout << "Spatial index culling: " << hierarchicalNodes.size() << " nodes, " << rounds << " frusta, "
+              << visibleTotal / rounds << " visible on average\n";
+    std::cout << "hierarchical   " << hierarchicalMs / rounds << " ms per cull\n";
+    std::cout << "octree         " << indexedMs / rounds << " ms per cull ("
+              << indexed.GetSpatialIndex()->GetCellCount() << " cells)\n";
+    bool same = (mismatches == 0 && pickMismatches == 0);
+    std::cout << (same ? "Visible sets and picks match"
+                       : "Mismatch: " + std::to_string(mismatches) + " visibility flags, " +
+                         std::to_string(pickMismatches) + " picks") << std::endl;
+    delete hierarchicalRoot;
+    delete indexedRoot;
+    return same ? 0 : 1;
+}
@@ -1,6 +1,10 @@
 # Run with: python3 build.py
+# Benchmarks: python3 build.py bench (one executable per ./bench/*.cpp)
+# GL state checks: python3 build.py validate (see include/GLState.hpp)
+import glob
 import os
 import platform
+import sys
 
 # (1)==================== COMMON CONFIGURATION OPTIONS ======================= #
 COMPILER="g++ -g -std=c++17"   # The compiler
@@ -16,7 +20,7 @@ LIBRARIES=""            # What libraries
 if platform.system()=="Linux":
     ARGUMENTS="-D LINUX"
     INCLUDE_DIR="-I ./include/ -I ./../common/thirdparty/glm/"
-    LIBRARIES="-lSDL2 -ldl"
+    LIBRARIES="-lSDL2 -ldl -pthread"
 elif platform.system()=="Darwin":
     ARGUMENTS="-D MAC"
     INCLUDE_DIR="-I ./include/ -I/Library/Frameworks/SDL2.framework/Headers -I./../common/thirdparty/old/glm"
@@ -29,10 +33,23 @@ elif platform.system()=="Windows":
 # ====================== Platform specific configuration ===================== #
 
 # (3)====================== Building the Executable ========================== #
-compileString=COMPILER+" "+ARGUMENTS+" "+SOURCE+" -o "+EXECUTABLE+" "+" "+INCLUDE_DIR+" "+LIBRARIES
 print("===============================================================================")
 print("====================== Compiling on: "+platform.system()+" =============================")
 print("===============================================================================")
+if len(sys.argv)>1 and sys.argv[1]=="validate":
+    ARGUMENTS+=" -D GLSTATE_VALIDATE"
+elif len(sys.argv)>1 and sys.argv[1]=="bench":
+    # Every benchmark links the engine sources, minus the program's main
+    engineSources=[f for f in glob.glob("./src/*.cpp") if os.path.basename(f)!="main.cpp"]
+    exit_code=0
+    for bench in sorted(glob.glob("./bench/*.cpp")):
+        benchExecutable=os.path.splitext(os.path.basename(bench))[0]
+        compileString=COMPILER+" -O2 -D NDEBUG "+ARGUMENTS+" "+bench+" "+" ".join(engineSources)+" -o "+benchExecutable+" "+INCLUDE_DIR+" "+LIBRARIES
+        print("Building "+benchExecutable)
+        if os.system(compileString)!=0:
+            exit_code=1
+    exit(exit_code)
+compileString=COMPILER+" "+ARGUMENTS+" "+SOURCE+" -o "+EXECUTABLE+" "+" "+INCLUDE_DIR+" "+LIBRARIES
 exit_code = os.system(compileString)
 exit(0 if exit_code==0 else 1)
 # ========================= Building the Executable ========================== #
@@ -0,0 +1,41 @@
+#ifndef AURORACOMPUTE_HPP
+#define AURORACOMPUTE_HPP
+
+#include <glad/glad.h>
+#include <string>
+
+#include "Shader.hpp"
+
+// AuroraCompute evaluates the aurora with a compute shader (OpenGL 4.3)
+// into a sky image laid out in the skybox's texture coordinates.
+// The image is then sampled by skybox_composite_frag.glsl.
+class AuroraCompute{
+public:
+    // Constructor
+    AuroraCompute();
+    // Destructor
+    ~AuroraCompute();
+    // Load and compile the compute shader
+    void Init(const std::string& computeShader);
+    // (Re)allocates the sky image when the size changes
+    void Resize(int width, int height);
+    // Evaluate the aurora for every texel of the sky image
+    void Dispatch(float iTime, float resolutionX, float resolutionY, float mouseX, float mouseY, int auroraSteps);
+    // Bind the finished sky image for sampling
+    void BindImage(unsigned int slot) const;
+    // Returns true once Init has been called
+    bool IsInitialized() const { return m_initialized; }
+
+private:
+    // Must match local_size_x/y in aurora_comp.glsl
+    static const int s_tileSize = 16;
+    // The compute program
+    Shader m_computeShader;
+    // Sky image written by the compute shader
+    GLuint m_imageID{0};
+    int m_width{0};
+    int m_height{0};
+    bool m_initialized{false};
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+// Bounding volumes used for culling and spatial queries
+
+#include <cfloat>
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+// Axis aligned bounding box. A default constructed box is empty.
+struct AABB{
+    glm::vec3 min{FLT_MAX, FLT_MAX, FLT_MAX};
+    glm::vec3 max{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    AABB() {}
+    AABB(const glm::vec3& minCorner, const glm::vec3& maxCorner) : min(minCorner), max(maxCorner) {}
+
+    // True until a point or box was added
+    bool IsEmpty() const { return min.x > max.x; }
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    // Half size along every axis
+    glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+    // Grow to contain a point
+    void Expand(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    // Grow to contain another box
+    void Merge(const AABB& other) {
+        if (other.IsEmpty()) {
+            return;
+        }
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    // The box around this box after a transform (Arvo's method)
+    // @param m: Model matrix
+    AABB Transformed(const glm::mat4& m) const {
+        if (IsEmpty()) {
+            return AABB();
+        }
+        glm::vec3 center = glm::vec3(m * glm::vec4(GetCenter(), 1.0f));
+        glm::vec3 extents = GetExtents();
+        glm::vec3 newExtents;
+        for (int row = 0; row < 3; ++row) {
+            newExtents[row] = std::fabs(m[0][row]) * extents.x +
+                              std::fabs(m[1][row]) * extents.y +
+                              std::fabs(m[2][row]) * extents.z;
+        }
+        return AABB(center - newExtents, center + newExtents);
+    }
+};
+
+// Bounding sphere
+struct BoundingSphere{
+    glm::vec3 center{0.0f, 0.0f, 0.0f};
+    float radius{0.0f};
+};
+
+#endif
@@ -35,6 +35,9 @@ public:
     // Returns the Z 'view' direction
     float GetViewZDirection();
     glm::vec3 GetPosition() const { return m_eyePosition; }
+    glm::vec3 GetViewDirection() const { return m_viewDirection; }
+    // Set the direction the camera looks in
+    void SetViewDirection(const glm::vec3& direction) { m_viewDirection = direction; }
     
 private:
 
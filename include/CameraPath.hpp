@@ -0,0 +1,92 @@
+#ifndef CAMERAPATH_HPP
+#define CAMERAPATH_HPP
+
+// CameraPath records where the camera was on every frame, with the input
+// that moved it there, and plays it back. A recording is a compact binary
+// file: a header with the simulation step, then per frame the simulation
+// time, the camera eye and view direction, and the input events applied
+// that frame (times relative to the start of the recording).
+// Playback does not replay the events through Input. It puts the camera
+// exactly where it was on each frame and advances the time by one fixed
+// step per frame, so two runs of the same file render the same frames,
+// whatever the frame rate, and their timing reports can be compared.
+// The events are kept for reference (and for tools that want them).
+//
+// Layout, little endian as written by the machine that recorded it:
+//   char   magic[4]      "ACPT"
+//   uint32 version
+//   double simulationStep
+//   uint32 frameCount    0 until EndRecording, Load reads to the end
+//   frameCount times:
+//     double time
+//     float  eye[3]
+//     float  direction[3]
+//     uint16 eventCount
+//     eventCount times:
+//       uint8  type
+//       float  timeMs    since the start of the recording
+//       int32  x, y, key
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Camera.hpp"
+#include "InputQueue.hpp"
+
+// One recorded frame
+struct CameraPathFrame{
+    // Simulation time the frame was rendered at
+    double time;
+    glm::vec3 eye;
+    glm::vec3 direction;
+    // The input applied that frame, time relative to the recording start
+    std::vector<InputEvent> events;
+};
+
+class CameraPath{
+public:
+    // Constructor
+    CameraPath();
+    // Destructor, finishes a recording still open
+    ~CameraPath();
+
+    // Opens a file to record to. False if it could not be created.
+    bool BeginRecording(const std::string& filename, double simulationStep);
+    bool IsRecording() const { return m_recording; }
+    // Adds an input event to the frame being recorded
+    void RecordEvent(const InputEvent& event);
+    // Writes the frame: the camera as it will be rendered, and the events
+    // recorded since the last frame
+    void RecordFrame(double time, const Camera& camera);
+    // Completes the header and closes the file
+    void EndRecording();
+
+    // Reads a recording for playback. False if it is missing or invalid.
+    bool Load(const std::string& filename);
+    size_t GetFrameCount() const { return m_frames.size(); }
+    double GetSimulationStep() const { return m_simulationStep; }
+    const CameraPathFrame& GetFrame(size_t index) const { return m_frames[index]; }
+    // Puts the camera where it was on a frame
+    void Apply(size_t index, Camera& camera) const;
+
+private:
+    static const unsigned int s_version = 1;
+    // Frames Load reads at most, about 19 hours at 60 frames per second
+    static const size_t s_maxFrames = 1 << 22;
+
+    std::vector<CameraPathFrame> m_frames;
+    double m_simulationStep;
+    // Recording state
+    std::ofstream m_file;
+    std::string m_filename;
+    bool m_recording;
+    unsigned int m_recordedFrames;
+    double m_startTime;
+    std::vector<InputEvent> m_pendingEvents;
+};
+
+#endif
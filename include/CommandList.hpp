@@ -0,0 +1,91 @@
+#ifndef COMMANDLIST_HPP
+#define COMMANDLIST_HPP
+
+// CommandList records draw packets: the state a draw needs (program,
+// texture, vertex array), where its mesh is, its world matrix, and the
+// sort key. Recording makes no GL calls, so several lists can be filled
+// at once on job workers (see Renderer::RecordCommands) and appended to
+// the RenderQueue afterwards, which sorts and replays them on the GL
+// thread. The RenderQueue records its own packets through one as well.
+// Packets live in a FrameArena, which must not be reset before the list
+// and the queue it was appended to are done with them.
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "FrameArena.hpp"
+#include "MeshPool.hpp"
+
+class SceneNode;
+
+// Render passes, in execution order
+enum RenderPass : unsigned int {
+    RenderPassBackground = 0, // the sky, drawn before everything else
+    RenderPassOpaque = 1
+};
+
+// One draw
+struct DrawPacket{
+    uint64_t key;
+    GLuint program;
+    // Program reading the model matrix from attributes, 0 if the draw can't be instanced
+    GLuint instancedProgram;
+    GLuint texture;
+    GLuint vertexArray;
+    GLsizei indexCount;
+    // Indirect packets: where the mesh is in its MeshPool
+    bool indirect;
+    GLuint firstIndex;
+    GLint baseVertex;
+    // World matrix, owned by the frame's snapshot and stable for the frame
+    const glm::mat4* model;
+    // Set for custom packets, which call node->DrawCustom()
+    SceneNode* node;
+};
+
+class CommandList{
+public:
+    // Packets of one frame, in the arena
+    typedef std::vector<DrawPacket, ArenaAllocator<DrawPacket>> PacketArray;
+
+    // Constructor, records into the frame's arena until Begin says otherwise
+    CommandList();
+
+    // Drops the packets of the last frame and starts recording
+    // @param view: View matrix, used for the depth part of the keys
+    // @param farPlane: Distance mapped to the largest depth key
+    // @param indirectEnabled: Whether nodes may push indirect packets
+    // @param arena: Where the packets are allocated
+    void Begin(const glm::mat4& view, float farPlane, bool indirectEnabled, FrameArena* arena);
+    // Adds a draw of an indexed triangle mesh
+    void Push(RenderPass pass, GLuint program, GLuint instancedProgram, GLuint texture, GLuint vertexArray, GLsizei indexCount, const glm::mat4& model);
+    // Adds a draw of a mesh in a MeshPool, drawn indirectly. Its program
+    // reads the world matrix from storage buffer 0 at index drawIndex
+    // (attribute 4), see shaders/vert_indirect.glsl.
+    void PushIndirect(RenderPass pass, GLuint program, GLuint texture, const MeshPool& pool, const MeshRange& mesh, const glm::mat4& model);
+    // Adds a node that issues its own GL calls
+    void PushCustom(RenderPass pass, SceneNode* node);
+
+    // Whether the queue draws pooled meshes indirectly this frame
+    bool IsIndirectEnabled() const { return m_indirectEnabled; }
+    const PacketArray& GetPackets() const { return m_packets; }
+    size_t GetSize() const { return m_packets.size(); }
+
+    // Builds a key from its fields
+    static uint64_t MakeKey(RenderPass pass, GLuint program, GLuint texture, GLuint vertexArray, float depth);
+
+private:
+    // The queue sorts its own list's packets in place
+    friend class RenderQueue;
+
+    glm::mat4 m_view;
+    float m_farPlane;
+    bool m_indirectEnabled;
+    PacketArray m_packets;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FIXEDPOOL_HPP
+#define FIXEDPOOL_HPP
+
+// FixedPool hands out blocks of one size from chunks of many blocks, with
+// freed blocks kept on a free list for reuse. Chunks are never moved or
+// released before the pool, so a block's address is a stable handle for
+// its whole life, and blocks of one kind stay packed together instead of
+// being spread over the heap. SceneNode and Object allocate through it
+// (see their operator new and AllocateSized), and after a scene reached its size, creating
+// and deleting nodes allocates nothing from the general heap.
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+class FixedPool{
+public:
+    // Constructor, no memory is taken before the first Allocate
+    // @param blockSize: Bytes per block, rounded up to s_alignment
+    // @param blocksPerChunk: Blocks added at once when the pool is full
+    FixedPool(size_t blockSize, size_t blocksPerChunk = 256);
+    // Destructor, releases every chunk
+    ~FixedPool();
+
+    // Returns a free block, adding a chunk if there is none
+    void* Allocate();
+    // Returns a block to the pool
+    void Free(void* block);
+
+    size_t GetBlockSize() const { return m_blockSize; }
+    // Blocks allocated and not freed, and blocks in all chunks
+    size_t GetLiveCount() const { return m_live; }
+    size_t GetCapacity() const { return m_chunks.size() * m_blocksPerChunk; }
+
+    // The pool shared by every class whose blocks round up to the same size,
+    // nullptr once s_maxPools sizes are taken. The pools live until the
+    // program exits.
+    static FixedPool* ForSize(size_t size);
+    // A block of size bytes from the pool of that size, or from the general
+    // heap if there is none. For class specific operator new and delete.
+    static void* AllocateSized(size_t size);
+    // Returns a block AllocateSized gave out for the same size
+    static void FreeSized(void* block, size_t size);
+
+private:
+    // Alignment of every block
+    static const size_t s_alignment = 16;
+    // Most distinct block sizes ForSize serves
+    static const int s_maxPools = 16;
+
+    // A free block stores the next free block in its first bytes
+    struct FreeBlock{
+        FreeBlock* next;
+    };
+
+    // Adds a chunk of blocks to the free list
+    void AddChunk();
+
+    size_t m_blockSize;
+    size_t m_blocksPerChunk;
+    std::vector<char*> m_chunks;
+    FreeBlock* m_freeList;
+    size_t m_live;
+    // Nodes and objects may be created by jobs
+    std::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef FLIGHTRECORDER_HPP
+#define FLIGHTRECORDER_HPP
+
+// FlightRecorder keeps the last seconds of profiler zones while the program
+// runs, to explain hitches that are gone before anyone attaches a profiler.
+// Every thread writes the zones it closes (see PROFILE_SCOPE) to a ring of
+// its own, without locks; the oldest are overwritten. The GL thread ends
+// every frame with EndFrame. A frame longer than the threshold dumps the
+// window before it to a Chrome trace file (like Profiler's): the zones of
+// every thread, a track of frames, per-frame counters of uploads, shader
+// compiles and allocations, and what triggered the dump. After a dump the
+// recorder waits a window's length before the next one.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Counted whether or not the recorder is enabled, they are only atomics
+enum class FlightCounter{
+    // Bytes sent to the GPU: buffer and texture uploads, streamed data
+    UploadBytes,
+    ShaderCompiles,
+    // Heap blocks taken by the engine's pools and arenas, GPU buffers grown
+    Allocations,
+    Count
+};
+
+class FlightRecorder{
+public:
+    // The engine wide recorder
+    static FlightRecorder& Get();
+    // True while zones are recorded
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    // Adds to a counter
+    static void Count(FlightCounter counter, uint64_t amount = 1) {
+        s_counters[(int)counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    // Adds a zone to the calling thread's ring, lock free
+    static void Record(const char* name, int64_t start, int64_t end);
+
+    // Starts recording
+    // @param thresholdMs: Frame time that triggers a dump
+    // @param windowSeconds: Time before the slow frame that is dumped
+    // @param filePrefix: Dumps are written to <prefix>_<frame>.json
+    void Enable(double thresholdMs, double windowSeconds, const std::string& filePrefix);
+    void Disable();
+    // Names the calling thread's track in dumps
+    void SetThreadName(const std::string& name);
+    // Called by the GL thread at the end of every frame. Dumps the window
+    // if the frame took longer than the threshold.
+    // @return true if a dump was written
+    bool EndFrame();
+
+private:
+    FlightRecorder();
+
+    // Zones per thread ring, a power of two
+    static const size_t s_ringCapacity = 1 << 15;
+    // Frames kept for the frame track and counters
+    static const size_t s_frameCapacity = 2048;
+    // Frames after Enable before a slow frame triggers a dump, loading
+    // and the first frames are always slow
+    static const uint64_t s_armFrames = 30;
+
+    // Fields are atomics so a dump can read a slot its thread overwrites
+    struct Slot{
+        std::atomic<const char*> name;
+        std::atomic<int64_t> start;
+        std::atomic<int64_t> end;
+    };
+    // Written by its thread only. head counts every zone ever recorded.
+    struct Ring{
+        Slot slots[s_ringCapacity];
+        std::atomic<uint64_t> head;
+        // Set when the thread starts, under m_ringsMutex
+        std::string name;
+        int id;
+    };
+    struct FrameRecord{
+        int64_t start;
+        int64_t end;
+        // Counter totals at the end of the frame
+        uint64_t counters[(int)FlightCounter::Count];
+    };
+    // A zone copied out of a ring
+    struct Zone{
+        const char* name;
+        int64_t start;
+        int64_t end;
+        int tid;
+    };
+
+    // The calling thread's ring, created on first use
+    static Ring* GetRing();
+    // Copies the zones of every ring that end after since
+    void CollectZones(int64_t since, std::vector<Zone>& zones);
+    // Writes the window ending with the slow frame
+    bool Dump(const FrameRecord& slowFrame, uint64_t frameNumber);
+
+    static std::atomic<bool> s_enabled;
+    static std::atomic<uint64_t> s_counters[(int)FlightCounter::Count];
+
+    std::mutex m_ringsMutex;
+    std::vector<Ring*> m_rings;
+
+    double m_thresholdMs{50.0};
+    double m_windowSeconds{5.0};
+    std::string m_filePrefix{"flight"};
+
+    // Frames, GL thread only
+    FrameRecord m_frames[s_frameCapacity];
+    uint64_t m_frameCount{0};
+    int64_t m_lastFrameEnd{0};
+    int64_t m_nextDumpAllowed{0};
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+// FrameArena is a linear allocator for data that only lives for one frame
+// (render queue packets, temporary arrays). Allocating bumps an offset,
+// nothing is freed individually, and Reset at the start of the next frame
+// releases everything at once. Destructors are never run, so only store
+// trivially destructible data in it.
+// When a frame needs more than the block holds, the rest comes from
+// overflow blocks and the next Reset replaces the block by one large
+// enough for that frame; once the arena has seen the largest frame it
+// never allocates from the heap again.
+// Allocate may be called from several threads at once, Reset may not.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+class FrameArena{
+public:
+    // Constructor
+    // @param capacity: Bytes of the initial block
+    FrameArena(size_t capacity = 1024 * 1024);
+    // Destructor
+    ~FrameArena();
+
+    // The arena of the frame being updated, reset by Renderer::Update
+    // (the render side has its own, see Renderer)
+    static FrameArena& GetFrame();
+
+    // Returns size bytes aligned to alignment, valid until the next Reset
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    // Uninitialized room for count elements of T
+    template <typename T>
+    T* AllocateArray(size_t count) { return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+    // Releases everything allocated since the last Reset
+    void Reset();
+
+    // Bytes allocated since the last Reset, and held by the block
+    size_t GetUsed() const { return m_used.load(std::memory_order_relaxed); }
+    size_t GetCapacity() const { return m_capacity; }
+    // Overflow blocks taken from the heap since the last Reset
+    size_t GetOverflowCount() const { return m_overflow.size(); }
+
+private:
+    char* m_block;
+    size_t m_capacity;
+    std::atomic<size_t> m_offset;
+    // Bytes handed out, the overflow included
+    std::atomic<size_t> m_used;
+    // Allocations that did not fit in the block
+    std::mutex m_overflowMutex;
+    std::vector<char*> m_overflow;
+};
+
+// Allocator for standard containers backed by a FrameArena. Deallocation
+// does nothing: the memory is reclaimed by the arena's Reset, so a
+// container using it must be dropped (or reassigned) before then.
+template <typename T>
+class ArenaAllocator{
+public:
+    typedef T value_type;
+    // A container moved or swapped takes the arena of its source along
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator(FrameArena* arena = nullptr) : m_arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+    T* allocate(size_t count) { return m_arena->AllocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* GetArena() const { return m_arena; }
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.GetArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.GetArena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FRAMEGOVERNOR_HPP
+#define FRAMEGOVERNOR_HPP
+
+#include <string>
+
+// One step on the quality ladder the governor moves along
+struct QualityTier{
+    const char* name;
+    // Fraction of the screen resolution the sky is rendered at
+    float skyResolutionScale;
+    // Number of ray steps the aurora integrates
+    int auroraSteps;
+};
+
+// FrameGovernor adapts rendering quality to a frame time budget.
+// It smooths the measured CPU and GPU frame times and moves one quality
+// tier down when the slower of the two stays over budget, or one tier up
+// when there is comfortable headroom for a long while. Different margins
+// and a cooldown after each change keep it from oscillating.
+class FrameGovernor{
+public:
+    // Constructor
+    // @param budgetMs: Target frame time in milliseconds, <= 0 disables the governor
+    FrameGovernor(double budgetMs = 1000.0 / 60.0);
+    // Set the target frame time, <= 0 disables the governor
+    void SetBudget(double budgetMs);
+    double GetBudget() const { return m_budgetMs; }
+    // Feed the measurements of one frame and possibly change tier
+    // @param cpuMs: CPU time of the frame
+    // @param gpuMs: GPU time of a recent frame, negative if none was available
+    void Update(double cpuMs, double gpuMs);
+    // The tier to render the next frame at
+    const QualityTier& GetTier() const;
+    int GetTierIndex() const { return m_tier; }
+    // Disable the governor and render at one tier (clamped to the ladder)
+    void SetFixedTier(int tier);
+    // Index of the tier with this name, -1 if there is none
+    static int FindTier(const std::string& name);
+    // Smoothed frame times
+    double GetSmoothedCpuMs() const { return m_smoothedCpuMs; }
+    double GetSmoothedGpuMs() const { return m_smoothedGpuMs; }
+    // Human readable description of the last tier change
+    const std::string& GetLastDecision() const { return m_lastDecision; }
+
+private:
+    // Exponential moving average of a measurement
+    static double Smooth(double smoothed, double sample, bool first);
+
+    double m_budgetMs;
+    int m_tier;
+    double m_smoothedCpuMs{0.0};
+    double m_smoothedGpuMs{0.0};
+    bool m_hasCpuSample{false};
+    bool m_hasGpuSample{false};
+    // Consecutive frames over budget / with headroom
+    int m_overBudgetFrames{0};
+    int m_underBudgetFrames{0};
+    // Frames to wait after a change before deciding again
+    int m_cooldownFrames{0};
+    std::string m_lastDecision;
+};
+
+#endif
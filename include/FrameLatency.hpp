@@ -0,0 +1,72 @@
+#ifndef FRAMELATENCY_HPP
+#define FRAMELATENCY_HPP
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// FrameLatency keeps the driver from queueing frames ahead of the GPU, and
+// measures how long input takes to reach the screen. A fence follows every
+// swap. Before a frame issues its GL work, BeginFrame waits until fewer
+// than the limit of frames are still in flight, so the input a frame
+// reads is at most that many frames old when it is shown.
+// Each frame carries the arrival time of the oldest input it reflects.
+// When its fence is seen signaled, the frame has finished on the GPU and
+// (give or take the compositor) is on screen. The time from the input to
+// then is the input to present latency.
+class FrameLatency{
+public:
+    // Most frames the limit may be set to
+    static const int s_maxFramesInFlight = 4;
+
+    // Constructor
+    FrameLatency();
+    // Destructor, deletes the fences Finish left (needs the context)
+    ~FrameLatency();
+
+    // Frames allowed in flight, 1 to s_maxFramesInFlight
+    void SetMaxFramesInFlight(int frames);
+    // Notes input the next presented frame reflects
+    // @param time: FramePacer::Now() when the input arrived
+    void AddInput(double time);
+    // Waits until a frame may be started
+    void BeginFrame();
+    // Places the fence of the frame just swapped
+    void EndFrame();
+    // Waits for every frame in flight, before the context goes away
+    void Finish();
+
+    // Latency of the frames retired since the last reset
+    double GetAverageMs() const { return m_samples > 0 ? m_totalMs / m_samples : 0.0; }
+    double GetMaxMs() const { return m_maxMs; }
+    // Time BeginFrame spent waiting since the last reset
+    double GetWaitMs() const { return m_waitMs; }
+    void Reset();
+
+private:
+    // A swapped frame the GPU may still be working on
+    struct Frame{
+        GLsync fence;
+        // Oldest input it reflects, negative if none
+        double inputTime;
+    };
+
+    // Removes the oldest frame once its fence is signaled, waiting for it
+    // if wait is set. Returns false if it was not signaled.
+    bool Retire(bool wait);
+
+    Frame m_frames[s_maxFramesInFlight];
+    // Oldest frame in flight, and number of frames in flight
+    int m_head;
+    int m_count;
+    int m_limit;
+    // Oldest input since the last EndFrame, negative if none
+    double m_pendingInput;
+    // Measurements since the last reset
+    size_t m_samples;
+    double m_totalMs;
+    double m_maxMs;
+    double m_waitMs;
+};
+
+#endif
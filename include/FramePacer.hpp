@@ -0,0 +1,64 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+// FramePacer starts frames at a steady rate and records how steady they
+// really were. Wait holds the frame until its deadline. It sleeps while
+// the deadline is further away than sleeping tends to overshoot, then
+// spins on the high resolution clock for the rest. Deadlines advance by
+// the target period rather than from the frame's actual start, so a late
+// frame does not shift all the following ones. Without a target (vsync
+// or no cap) Wait returns at once.
+// BeginFrame measures the period since the last frame and adds how far it
+// was from the target (from the previous period, without a target) to a
+// jitter histogram.
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+class FramePacer{
+public:
+    // Buckets of the jitter histogram
+    static const int s_bucketCount = 7;
+
+    // Constructor, no target: Wait does not wait
+    FramePacer();
+
+    // Frame period to hold, <= 0 for none
+    void SetTargetMs(double targetMs) { m_targetMs = targetMs; }
+    double GetTargetMs() const { return m_targetMs; }
+
+    // Call at the start of each frame
+    // @return Seconds since the last call, 0 on the first
+    double BeginFrame();
+    // Sleeps, then spins, until the next frame's deadline
+    void Wait();
+
+    // Frames in the histogram since the last reset
+    size_t GetFrameCount() const { return m_frames; }
+    // Prints the jitter histogram on one line
+    void PrintJitter(std::ostream& out) const;
+    void ResetJitter();
+
+    // High resolution time in seconds from an arbitrary origin
+    static double Now();
+
+private:
+    // Bucket i holds [s_bucketLimits[i - 1], s_bucketLimits[i]) ms, the
+    // last one is open ended
+    static const double s_bucketLimits[s_bucketCount - 1];
+
+    double m_targetMs;
+    // Start of the last frame, and when the next one is due
+    double m_lastFrame;
+    double m_deadline;
+    // Last measured period, the reference without a target
+    double m_lastPeriodMs;
+    // Estimate of how late a 1 ms sleep wakes up
+    double m_sleepOvershootMs;
+    size_t m_buckets[s_bucketCount];
+    size_t m_frames;
+    double m_worstJitterMs;
+};
+
+#endif
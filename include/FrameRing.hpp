@@ -0,0 +1,88 @@
+#ifndef FRAMERING_HPP
+#define FRAMERING_HPP
+
+// FrameRing is one buffer for the data written every frame (instance
+// matrices, indirect commands, uniform blocks). It is created with
+// glBufferStorage and stays mapped (persistent, coherent), so writes are
+// plain memcpys with no glBufferData/glBufferSubData that could make the
+// driver wait for the GPU. The buffer is split into s_regionCount regions
+// used in turn, one per frame; a fence placed after a frame's draws keeps
+// its region from being written again before the GPU has read it. Waiting
+// on that fence is the only place the CPU can stall, and it is measured.
+// Needs OpenGL 4.4; without it IsAvailable() is false and callers upload
+// the way they did before.
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+class FrameRing{
+public:
+    // Frames the buffer is split into: one being written, up to two in flight
+    static const int s_regionCount = 3;
+
+    // A suballocation of the current region
+    struct Allocation{
+        // Where to write, valid until the end of the frame
+        void* data;
+        // Buffer and byte offset to bind or point attributes at
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    // Constructor, the buffer is created by the first BeginFrame
+    // @param regionSize: Bytes available to each frame
+    FrameRing(GLsizeiptr regionSize = 4 * 1024 * 1024);
+    // Destructor
+    ~FrameRing();
+
+    // True when the context supports persistent mapping
+    bool IsAvailable() const;
+
+    // Moves to the next region, waiting for the GPU if it still reads it.
+    // A region that overflowed last frame is first reallocated larger.
+    void BeginFrame();
+    // Suballocates the current region
+    // @param size: Bytes needed
+    // @param alignment: Offset alignment, see GetUniformAlignment and GetStorageAlignment
+    // @param allocation: Receives the range
+    // @return false if the region is full (or the ring unavailable)
+    bool Allocate(GLsizeiptr size, GLsizeiptr alignment, Allocation& allocation);
+    // Fences the current region, after the frame's last draw reading it
+    void EndFrame();
+
+    // Offset alignments of glBindBufferRange for uniform and storage buffers
+    GLsizeiptr GetUniformAlignment() const { return m_uniformAlignment; }
+    GLsizeiptr GetStorageAlignment() const { return m_storageAlignment; }
+
+    // Milliseconds BeginFrame waited on the GPU this frame
+    double GetStallMs() const { return m_stallMs; }
+    // Bytes allocated this frame, and available per frame
+    GLsizeiptr GetUsed() const { return m_offset; }
+    GLsizeiptr GetRegionSize() const { return m_regionSize; }
+
+private:
+    // Creates and maps the buffer, and queries the alignments
+    void Create();
+    // Waits for every region, then unmaps and deletes the buffer
+    void Destroy();
+    // Waits until the fence of a region is signaled, then deletes it
+    // @return Milliseconds waited
+    double Wait(int region);
+
+    GLuint m_buffer;
+    char* m_mapped;
+    GLsizeiptr m_regionSize;
+    int m_region;
+    GLsizeiptr m_offset;
+    GLsync m_fences[s_regionCount];
+    GLsizeiptr m_uniformAlignment;
+    GLsizeiptr m_storageAlignment;
+    // Bytes the current frame asked for, including what did not fit
+    GLsizeiptr m_requested;
+    bool m_overflowed;
+    double m_stallMs;
+};
+
+#endif
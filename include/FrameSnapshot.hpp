@@ -0,0 +1,68 @@
+#ifndef FRAMESNAPSHOT_HPP
+#define FRAMESNAPSHOT_HPP
+
+// FrameSnapshot is everything Renderer::Render needs from one Update: the
+// camera, the visible nodes with a copy of their world matrices, and the
+// sky's per-frame inputs. The Renderer keeps two of them. Update fills one
+// while Render draws the other, so the simulation of the next frame can run
+// on another thread (see SimulationThread) while this one is drawn. Update
+// makes no GL calls, and Render does not read the scene graph.
+
+#include <cstddef>
+#include <vector>
+
+#include "SceneGraph.hpp"
+
+#include "glm/mat4x4.hpp"
+
+class SceneNode;
+
+// A node that passed culling, and its world matrix at the time
+struct VisibleNode{
+    SceneNode* node;
+    glm::mat4 world;
+};
+
+// A GpuCulling instance whose node moved
+struct GpuInstanceUpdate{
+    int instance;
+    glm::mat4 world;
+};
+
+// Inputs of the sky pass, captured by SkyboxNode::Update
+struct SkyFrame{
+    // Seconds since the start of the program
+    float iTime{0.0f};
+    float resolutionX{0.0f};
+    float resolutionY{0.0f};
+    float mouseX{0.0f};
+    float mouseY{0.0f};
+    // Quality picked by the FrameGovernor
+    float resolutionScale{1.0f};
+    int auroraSteps{50};
+};
+
+struct FrameSnapshot{
+    // Number of the Update that wrote it, 0 before the first one
+    unsigned int frame{0};
+    // Camera of the frame
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    // Nodes with an object that passed culling, in scene order. Draw
+    // packets point at these matrices, so the vector must not change
+    // while the snapshot is drawn.
+    std::vector<VisibleNode> visible;
+    // Moved nodes of the GPU driven path, applied by Render before it culls
+    std::vector<GpuInstanceUpdate> gpuInstances;
+    SkyFrame sky;
+
+    // Measurements of the Update, copied to FrameStats by Render
+    size_t worldTransformsRecomputed{0};
+    CullStats cull;
+    size_t frameArenaBytes{0};
+    double updateMs{0.0};
+    // Part of updateMs spent culling (frustum and occlusion)
+    double cullMs{0.0};
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef FRAMESTATS_HPP
+#define FRAMESTATS_HPP
+
+#include <iostream>
+#include <string>
+
+// FrameStats collects the measurements and decisions of the current frame.
+// SDLGraphicsProgram averages them and prints a line once per second.
+struct FrameStats{
+    // CPU time spent on update and render submission
+    double cpuFrameMs{0.0};
+    // GPU time of the render pass (from a few frames ago)
+    double gpuFrameMs{0.0};
+    // CPU time of Renderer::Update and Renderer::Render. When pipelined
+    // they overlap, and a frame takes about the larger of the two.
+    double updateMs{0.0};
+    double renderMs{0.0};
+    bool pipelined{false};
+    // Part of updateMs spent on frustum and occlusion culling
+    double cullMs{0.0};
+
+    // World transforms recomputed by the scene graph this frame
+    size_t worldTransformsRecomputed{0};
+    // Frustum culling of this frame: nodes with geometry drawn and skipped,
+    // and subtrees rejected without visiting their nodes
+    size_t nodesVisible{0};
+    size_t nodesCulled{0};
+    size_t subtreesRejected{0};
+    // Occlusion culling of this frame: visible draws tested against the
+    // occlusion buffer, and how many of them were hidden
+    size_t occlusionTested{0};
+    size_t occluded{0};
+    // Render queue of this frame: draw packets, and GL state changes
+    // (program, texture, vertex array) in scene order against after sorting
+    size_t drawPackets{0};
+    size_t stateChangesUnsorted{0};
+    size_t stateChangesSorted{0};
+    // Draw calls issued, and how many of them were instanced draws
+    // covering how many packets
+    size_t drawCalls{0};
+    size_t instancedDraws{0};
+    size_t instances{0};
+    // Triangles drawn from the render queue (custom draws not counted)
+    size_t triangles{0};
+    // glMultiDrawElementsIndirect calls of this frame
+    size_t indirectDraws{0};
+    // CPU time spent recording the draw packets, and the command lists
+    // they were recorded into (1 when recorded on the GL thread alone)
+    double recordMs{0.0};
+    size_t commandLists{0};
+    // CPU time spent issuing the render queue's GL calls
+    double submitMs{0.0};
+    // Per-frame buffer data written (instance matrices, indirect commands),
+    // and time spent waiting for the GPU to release the ring region
+    size_t uploadBytes{0};
+    double ringStallMs{0.0};
+    // Bytes of transient data the last frame took from the frame arena
+    size_t frameArenaBytes{0};
+    // Instances handed to the GPU culling path (culled and drawn on the GPU)
+    size_t gpuCullInstances{0};
+    // Binds and enables of the render pass sent to OpenGL, and skipped by
+    // GLState because they would not have changed anything
+    size_t glCallsIssued{0};
+    size_t glCallsElided{0};
+
+    // Time from input arriving to the GPU finishing the first frame that
+    // shows it, average and worst, and the average time per frame spent
+    // waiting for the frames in flight limit
+    double inputLatencyMs{0.0};
+    double inputLatencyMaxMs{0.0};
+    double framesInFlightWaitMs{0.0};
+
+    // Quality the frame was rendered at (see FrameGovernor)
+    int qualityTier{0};
+    float skyResolutionScale{1.0f};
+    int auroraSteps{0};
+    // Last decision the governor made, empty if it never changed quality
+    std::string governorDecision;
+
+    // Print a one line summary
+    // @param out: Stream to print to
+    // @param fps: Frames per second over the reporting interval
+    void Print(std::ostream& out, double fps) const {
+        out << "[Stats] fps " << fps
+            << " | cpu " << cpuFrameMs << " ms"
+            << " | gpu " << gpuFrameMs << " ms"
+            << " | update " << updateMs << " ms (cull " << cullMs << ") render " << renderMs << " ms"
+            << (pipelined ? " (pipelined)" : " (serial)")
+            << " | world transforms recomputed " << worldTransformsRecomputed
+            << " | nodes visible " << nodesVisible << " culled " << nodesCulled
+            << " (subtrees rejected " << subtreesRejected << ")"
+            << " | occluded " << occluded << " of " << occlusionTested
+            << " (" << (occlusionTested > 0 ? 100.0 * occluded / occlusionTested : 0.0) << "%)"
+            << " | packets " << drawPackets << " draw calls " << drawCalls
+            << " triangles " << triangles
+            << " (instanced " << instancedDraws << " for " << instances << " packets, indirect " << indirectDraws << ")"
+            << " record " << recordMs << " ms (" << commandLists << " lists)"
+            << " submit " << submitMs << " ms"
+            << " | frame arena " << frameArenaBytes << " bytes"
+            << " | uploaded " << uploadBytes << " bytes, ring stall " << ringStallMs << " ms"
+            << " | gpu culled instances " << gpuCullInstances
+            << " state changes " << stateChangesSorted
+            << " (unsorted " << stateChangesUnsorted << ")"
+            << " | gl calls " << glCallsIssued << " (elided " << glCallsElided << ")"
+            << " | input latency " << inputLatencyMs << " ms (worst " << inputLatencyMaxMs << ")"
+            << " frames in flight wait " << framesInFlightWaitMs << " ms"
+            << " | quality tier " << qualityTier
+            << " (sky scale " << skyResolutionScale << ", aurora steps " << auroraSteps << ")";
+        if (!governorDecision.empty()) {
+            out << " | governor: " << governorDecision;
+        }
+        out << "\n";
+    }
+};
+
+#endif
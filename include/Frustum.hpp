@@ -0,0 +1,45 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+// Frustum holds the six planes of a camera's view volume, extracted from
+// its projection x view matrix. The planes are stored structure of arrays
+// (all x, all y, ...) so a box is tested against four planes per SSE
+// instruction; two padding planes that accept everything round them up
+// to eight.
+
+#include "glm/glm.hpp"
+
+#include "Bounds.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define FRUSTUM_USE_SSE 1
+#endif
+
+class Frustum{
+public:
+    // Number of planes stored, the six frustum planes plus padding
+    static const int s_planeCount = 8;
+
+    // Constructor: a frustum that contains everything
+    Frustum();
+    // Extracts the planes (Gribb and Hartmann)
+    // @param viewProjection: projection x view matrix of the camera
+    void Extract(const glm::mat4& viewProjection);
+
+    // False if the box is completely outside of one plane.
+    // Boxes crossing a corner of the frustum may be kept (conservative).
+    bool Intersects(const AABB& box) const;
+    // False if the sphere is completely outside of one plane
+    bool Intersects(const BoundingSphere& sphere) const;
+    // Plane i (0 to 5) as (a, b, c, d), inside where a x + b y + c z + d >= 0
+    glm::vec4 GetPlane(int i) const { return glm::vec4(m_planeX[i], m_planeY[i], m_planeZ[i], m_planeW[i]); }
+
+private:
+    // Plane i is m_planeX[i] * x + m_planeY[i] * y + m_planeZ[i] * z + m_planeW[i] >= 0 inside
+    alignas(16) float m_planeX[s_planeCount];
+    alignas(16) float m_planeY[s_planeCount];
+    alignas(16) float m_planeZ[s_planeCount];
+    alignas(16) float m_planeW[s_planeCount];
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef GLEXTENSIONS_HPP
+#define GLEXTENSIONS_HPP
+
+// The bundled glad loader only covers OpenGL 3.3. GLExtensions loads the
+// handful of newer entry points the engine uses for its optional paths
+// (compute shaders, image load/store, indirect multi-draw, persistent
+// buffer mapping) and reports which of them are usable
+// on the current context. Declarations follow glad's naming so they compile
+// away cleanly if glad is ever regenerated for a newer version.
+
+#include <glad/glad.h>
+
+#ifndef GL_VERSION_4_0
+#define GL_VERSION_4_0 1
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_DRAW_INDIRECT_BUFFER_BINDING 0x8F43
+#endif
+
+#ifndef GL_VERSION_4_2
+#define GL_VERSION_4_2 1
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_IMAGE_BINDING_NAME 0x8F3A
+#define GL_IMAGE_BINDING_LEVEL 0x8F3B
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+GLAPI PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture;
+#define glBindImageTexture glad_glBindImageTexture
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+GLAPI PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier;
+#define glMemoryBarrier glad_glMemoryBarrier
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+GLAPI PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D;
+#define glTexStorage2D glad_glTexStorage2D
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_VERSION_4_3 1
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BUFFER_BINDING 0x90D3
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+GLAPI PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute;
+#define glDispatchCompute glad_glDispatchCompute
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+GLAPI PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+#endif
+
+#ifndef GL_VERSION_4_4
+#define GL_VERSION_4_4 1
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+GLAPI PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+#endif
+
+class GLExtensions{
+public:
+    // Loads the entry points above.
+    // Must be called after gladLoadGLLoader, with the context current.
+    static void Load(GLADloadproc load);
+    // Returns the version of the current context, e.g. 43 for OpenGL 4.3
+    static int GetContextVersion();
+    // True when compute shaders and image load/store can be used
+    static bool HasComputeShaders();
+    // True when glMultiDrawElementsIndirect and shader storage buffers can be used
+    static bool HasMultiDrawIndirect();
+    // True when buffers can be mapped persistently with glBufferStorage
+    static bool HasBufferStorage();
+
+private:
+    static int s_contextVersion;
+    static bool s_hasComputeShaders;
+    static bool s_hasMultiDrawIndirect;
+    static bool s_hasBufferStorage;
+};
+
+#endif
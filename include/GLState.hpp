@@ -0,0 +1,115 @@
+#ifndef GLSTATE_HPP
+#define GLSTATE_HPP
+
+// GLState is the engine's single way to bind objects and enable
+// capabilities. It remembers what is bound and skips calls that would not
+// change anything, counting issued and elided calls per frame.
+// State starts unknown (the first call of each kind is always issued) and
+// can be forgotten with Invalidate() after code outside of the engine
+// touched OpenGL. Objects must be deleted through GLState as well, so that
+// a recycled name is not mistaken for the deleted object.
+// With GLSTATE_VALIDATE defined (python3 build.py validate), every elided
+// call checks that OpenGL really is in the remembered state and asserts
+// otherwise: a mismatch means some code bound or enabled something behind
+// GLState. The checks are synchronous GL queries, so they are off unless
+// asked for; timings taken with them on mean little.
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+class GLState{
+public:
+    // glUseProgram
+    static void UseProgram(GLuint program);
+    // glBindVertexArray. The element array buffer binding belongs to the
+    // vertex array, so it is unknown again after a change.
+    static void BindVertexArray(GLuint vertexArray);
+    // glBindBuffer, other targets than the tracked ones are always issued
+    static void BindBuffer(GLenum target, GLuint buffer);
+    // glBindBufferBase, also binds the generic binding of target
+    static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    // glBindBufferRange, always issued: ranges of one buffer change every frame
+    static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // glActiveTexture
+    static void ActiveTexture(GLenum unit);
+    // glBindTexture on the active unit, only GL_TEXTURE_2D is tracked
+    static void BindTexture(GLenum target, GLuint texture);
+    // glBindImageTexture
+    static void BindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+    // glBindFramebuffer, GL_FRAMEBUFFER binds both read and draw
+    static void BindFramebuffer(GLenum target, GLuint framebuffer);
+    // glBindRenderbuffer
+    static void BindRenderbuffer(GLenum target, GLuint renderbuffer);
+    // glEnable / glDisable
+    static void Enable(GLenum capability);
+    static void Disable(GLenum capability);
+    // glViewport
+    static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deletes objects, unbinding them from the remembered state
+    static void DeleteProgram(GLuint program);
+    static void DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    static void DeleteBuffers(GLsizei count, const GLuint* buffers);
+    static void DeleteTextures(GLsizei count, const GLuint* textures);
+    static void DeleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+    static void DeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers);
+
+    // Remembered bindings, queried from OpenGL if unknown
+    static GLuint GetDrawFramebuffer();
+    static void GetViewport(GLint viewport[4]);
+
+    // Forgets everything, the next call of each kind is issued
+    static void Invalidate();
+    // Starts a new frame: resets the counters (and validates the whole
+    // remembered state with GLSTATE_VALIDATE)
+    static void BeginFrame();
+    // Calls issued to OpenGL and skipped since BeginFrame
+    static size_t GetIssued() { return s_issued; }
+    static size_t GetElided() { return s_elided; }
+
+private:
+    // Remembered value of a binding nobody knows
+    static const GLuint s_unknown = 0xFFFFFFFFu;
+    static const int s_textureUnits = 16;
+    static const int s_bufferTargets = 9;
+    static const int s_indexedBindings = 8;
+    static const int s_capabilities = 8;
+    static const int s_imageUnits = 8;
+
+    // Slot of a tracked buffer target, -1 if not tracked
+    static int BufferSlot(GLenum target);
+    // Slot of a capability, a free slot is taken on first use
+    static int CapabilitySlot(GLenum capability);
+    // Counts an elided call, checking the real state when validating
+    static void Elided(GLenum binding, GLuint expected);
+    static void ElidedIndexed(GLenum binding, GLuint index, GLuint expected);
+    static void ElidedCapability(GLenum capability, bool expected);
+    // Asserts every known binding matches OpenGL
+    static void Validate();
+
+    static GLuint s_program;
+    static GLuint s_vertexArray;
+    static GLuint s_buffers[s_bufferTargets];
+    static GLuint s_storageBuffers[s_indexedBindings];
+    static GLuint s_uniformBuffers[s_indexedBindings];
+    static GLuint s_activeUnit;
+    static GLuint s_textures[s_textureUnits];
+    static GLuint s_images[s_imageUnits];
+    static GLint s_imageLevels[s_imageUnits];
+    static GLenum s_imageAccess[s_imageUnits];
+    static GLenum s_imageFormats[s_imageUnits];
+    static GLuint s_readFramebuffer;
+    static GLuint s_drawFramebuffer;
+    static GLuint s_renderbuffer;
+    static GLenum s_capabilityNames[s_capabilities];
+    // 0 disabled, 1 enabled, s_unknown
+    static GLuint s_capabilityStates[s_capabilities];
+    static GLint s_viewport[4];
+    static bool s_viewportKnown;
+
+    static size_t s_issued;
+    static size_t s_elided;
+};
+
+#endif
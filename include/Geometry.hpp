@@ -4,6 +4,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include "Bounds.hpp"
+
 // store vertice and triangle information
 class Geometry{
 public:
@@ -31,6 +33,12 @@ public:
 	unsigned int* GetIndicesDataPtr();
 	// Retrieve the number of vertices
 	size_t GetVertexCount() const;
+	// Object space bounds, computed by Gen()
+	const AABB& GetBounds() const { return m_bounds; }
+	const BoundingSphere& GetBoundingSphere() const { return m_boundingSphere; }
+	// Vertex positions and triangle indices, e.g. for CPU rasterization
+	const std::vector<glm::vec3>& GetPositions() const { return m_vertexPositions; }
+	const std::vector<unsigned int>& GetIndices() const { return m_indices; }
 
 private:
 	// m_bufferData stores all of the vertexPositons, coordinates, normals, etc.
@@ -45,6 +53,10 @@ private:
 
 	// The indices for a indexed-triangle mesh
 	std::vector<unsigned int> m_indices;
+
+	// Bounds of m_vertexPositions
+	AABB m_bounds;
+	BoundingSphere m_boundingSphere;
 };
 
 
@@ -0,0 +1,148 @@
+#ifndef GPUCULLING_HPP
+#define GPUCULLING_HPP
+
+// GpuCulling is a GPU driven path for large sets of instances of pooled
+// meshes (see MeshPool). The instances' world bounds and matrices are
+// uploaded once and only changed instances are uploaded again. Every frame
+// a compute shader (cull_comp.glsl) tests each instance against the view
+// frustum and against a max-depth pyramid of the previous frame's depth
+// buffer (Hi-Z), and appends the visible ones to their mesh's instance
+// list, counting them in the mesh's indirect draw command with an atomic
+// add. All instances are then drawn with one glMultiDrawElementsIndirect,
+// so the CPU cost does not depend on the number of instances.
+// Needs OpenGL 4.3 (compute shaders, storage buffers, indirect multi-draw),
+// which Mesa's llvmpipe provides for testing without a GPU.
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Bounds.hpp"
+#include "FrameRing.hpp"
+#include "MeshPool.hpp"
+#include "Shader.hpp"
+
+class GpuCulling{
+public:
+    // Constructor, GL resources are created in Init and on first use
+    GpuCulling();
+    // Destructor
+    ~GpuCulling();
+
+    // Compiles the shaders
+    // @param cullShader, depthPyramidShader: compute shaders
+    // @param vertShader, fragShader: shaders drawing the instances, the
+    //                                vertex shader as vert_indirect.glsl
+    // @return false if the context lacks compute shaders or indirect multi-draw
+    bool Init(const std::string& cullShader, const std::string& depthPyramidShader,
+              const std::string& vertShader, const std::string& fragShader);
+    bool IsInitialized() const { return m_initialized; }
+
+    // Adds an instance of a mesh of pool
+    // @param mesh: Where the mesh is in the pool
+    // @param model: World matrix
+    // @param localBounds: Bounds of the mesh in object space
+    // @return Index of the instance
+    int AddInstance(const MeshRange& mesh, const glm::mat4& model, const AABB& localBounds);
+    // Moves an instance, only changed instances are uploaded again
+    void SetInstanceTransform(int instance, const glm::mat4& model);
+    // Removes every instance
+    void Clear();
+    // The pool the instances' meshes live in, and the texture they are drawn with
+    void SetMeshPool(const MeshPool* pool) { m_pool = pool; }
+    void SetTexture(GLuint texture) { m_texture = texture; }
+    // Ring per-frame updates are staged in and copied from on the GPU,
+    // nullptr to update with glBufferSubData
+    void SetFrameRing(FrameRing* ring) { m_ring = ring; }
+
+    // Culls the instances and writes the indirect draw commands
+    // @param viewProjection: projection x view matrix of this frame
+    void Cull(const glm::mat4& viewProjection);
+    // Draws the visible instances with one glMultiDrawElementsIndirect
+    void Draw(const glm::mat4& view, const glm::mat4& projection);
+    // Builds the depth pyramid from the bound framebuffer's depth buffer,
+    // for the occlusion test of the next frame's Cull
+    // @param width, height: Size of the framebuffer
+    void BuildDepthPyramid(int width, int height);
+
+    size_t GetInstanceCount() const { return m_matrices.size(); }
+    size_t GetMeshCount() const { return m_meshes.size(); }
+
+private:
+    // Must match local_size_x in cull_comp.glsl
+    static const GLuint s_cullGroupSize = 64;
+    // Must match local_size_x/y in depth_pyramid_comp.glsl
+    static const GLuint s_pyramidTileSize = 8;
+    // Attribute the instance index is read from, as in vert_indirect.glsl
+    static const GLuint s_instanceAttribute = 4;
+
+    // Layout of an instance in cull_comp.glsl (std430)
+    struct GpuInstance{
+        glm::vec4 boundsMin; // xyz, w unused
+        glm::vec4 boundsMax; // xyz, w unused
+        GLuint mesh;
+        GLuint padding[3];
+    };
+
+    // Layout glMultiDrawElementsIndirect reads
+    struct DrawElementsIndirectCommand{
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Uploads the instances, and rebuilds the commands when the set changed
+    void Upload();
+    // (Re)allocates the depth copy and the pyramid at a new size
+    void ResizeDepthPyramid(int width, int height);
+    // Creates a buffer of size bytes if needed and fills it
+    static void Allocate(GLenum target, GLuint& buffer, GLsizeiptr size, const void* data);
+    // Replaces part of a buffer the GPU may still be reading: staged in the
+    // ring and copied by the GPU in order, instead of glBufferSubData
+    void Write(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+    bool m_initialized;
+    Shader m_cullShader;
+    Shader m_depthPyramidShader;
+    Shader m_drawShader;
+    const MeshPool* m_pool;
+    FrameRing* m_ring;
+    GLuint m_texture;
+
+    // CPU copies of the instances, indexed like the GPU buffers
+    std::vector<GpuInstance> m_instances;
+    std::vector<glm::mat4> m_matrices;
+    std::vector<AABB> m_localBounds;
+    // One command per distinct mesh, instanceCount 0. The instance list of
+    // mesh i starts at baseInstance and has room for all its instances.
+    std::vector<DrawElementsIndirectCommand> m_meshes;
+    // Instances changed since the last upload: [m_dirtyBegin, m_dirtyEnd)
+    size_t m_dirtyBegin;
+    size_t m_dirtyEnd;
+    // Instances were added or removed, everything is uploaded again
+    bool m_structureChanged;
+
+    GLuint m_instanceBuffer;     // binding 1, GpuInstance
+    GLuint m_matrixBuffer;       // binding 0, world matrices
+    GLuint m_commandBuffer;      // binding 2, and the indirect buffer
+    GLuint m_visibleBuffer;      // binding 3, and attribute 4 of the pool's vertex array
+
+    // Depth of the last frame, and its max-depth pyramid (R32F, all levels)
+    GLuint m_depthTexture;
+    GLuint m_depthPyramid;
+    int m_pyramidWidth;
+    int m_pyramidHeight;
+    int m_pyramidLevels;
+    // The pyramid holds a frame, rendered with this projection x view
+    bool m_hasDepthPyramid;
+    glm::mat4 m_pyramidViewProjection;
+    // View projection of the frame being drawn, becomes m_pyramidViewProjection
+    glm::mat4 m_viewProjection;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef GPUTIMER_HPP
+#define GPUTIMER_HPP
+
+#include <glad/glad.h>
+
+// GpuTimer measures the GPU time of the commands issued between Begin and
+// End with GL_TIME_ELAPSED queries. A few queries are kept in flight so a
+// result can be read a couple of frames later without stalling the GPU.
+class GpuTimer{
+public:
+    // Constructor
+    GpuTimer();
+    // Destructor
+    ~GpuTimer();
+    // Start timing. Only one GpuTimer may be between Begin and End at a time.
+    void Begin();
+    // Stop timing
+    void End();
+    // Retrieves the oldest finished measurement without blocking.
+    // Returns false if no measurement is ready yet.
+    bool Poll(double& milliseconds);
+    // Blocks until the most recent measurement is available and returns it
+    double WaitElapsedMs();
+
+private:
+    // Number of queries in flight
+    static const int s_queryCount = 4;
+    GLuint m_queries[s_queryCount];
+    // Next query to begin
+    int m_head{0};
+    // Queries that have ended but have not been read yet
+    int m_pending{0};
+    bool m_created{false};
+};
+
+#endif
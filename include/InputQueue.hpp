@@ -0,0 +1,72 @@
+#ifndef INPUTQUEUE_HPP
+#define INPUTQUEUE_HPP
+
+// InputQueue takes SDL's input events as SDL receives them. An event
+// filter stamps each one with the high resolution clock and pushes a
+// compact InputEvent into a lock-free SpscQueue. The GL thread drains it
+// whenever it is about to use the camera: at the top of the frame, and
+// again right before the draw (the late latch, see
+// SDLGraphicsProgram::Loop). SDL may run the filter on a thread of its
+// own, and the queue lets that thread hand events over without a lock.
+// The arrival time is what input to present latency is measured from.
+// SDL only pumps window events on the thread that created the window, so
+// that thread still calls Pump; the filter is what decouples the rest.
+
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else
+    #include <SDL.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+
+#include "SpscQueue.hpp"
+
+// What happened
+enum InputEventType {
+    InputEventQuit,
+    InputEventMouseMotion, // x, y: new mouse position
+    InputEventKeyDown      // key: SDL keycode
+};
+
+struct InputEvent{
+    InputEventType type;
+    // FramePacer::Now() when SDL received the event
+    double time;
+    int x;
+    int y;
+    SDL_Keycode key;
+};
+
+class InputQueue{
+public:
+    // Constructor, events are only taken after Install
+    InputQueue();
+    // Destructor, removes the filter
+    ~InputQueue();
+
+    // Routes SDL's input events into this queue
+    void Install();
+    // Lets SDL deliver pending events to the filter, and discards the
+    // events the program does not handle. GL thread only.
+    void Pump();
+    // Takes the oldest event. False if there is none.
+    bool Pop(InputEvent& event) { return m_events.Pop(event); }
+    // Events dropped because the queue was full
+    size_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Events between two drains, a frame of fast mouse motion fits easily
+    static const size_t s_capacity = 1024;
+
+    // SDL event filter: queues the events the program handles and keeps
+    // them out of SDL's own queue
+    static int SDLCALL Filter(void* userdata, SDL_Event* event);
+
+    SpscQueue<InputEvent, s_capacity> m_events;
+    std::atomic<size_t> m_dropped;
+    bool m_installed;
+};
+
+#endif
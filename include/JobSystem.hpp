@@ -0,0 +1,134 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+// JobSystem is a work-stealing thread pool shared by the whole engine.
+// Every worker owns a deque: it pushes and pops its own jobs at the back,
+// and idle workers steal from the front of the others. The thread that
+// created the JobSystem (the GL thread) takes part as worker 0 whenever it
+// waits on a counter, and also has a queue of jobs that must run on it
+// because they touch OpenGL. Other threads that queue jobs (the simulation
+// thread) call RegisterThread to get a queue of their own. The GL thread
+// and registered threads only run their own jobs while they wait, so they
+// never pick up each other's batches; the workers steal from every queue.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work
+typedef std::function<void()> Job;
+
+// JobCounter counts the unfinished jobs of a batch.
+// Waiting on it is how jobs depend on each other.
+class JobCounter{
+public:
+    JobCounter() : m_count(0) {}
+    // True once every job of the batch finished
+    bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> m_count;
+};
+
+class JobSystem{
+public:
+    // Constructor
+    // @param workerCount: Number of worker threads besides the calling
+    //                     thread, -1 for one per remaining hardware thread
+    JobSystem(int workerCount = -1);
+    // Destructor: finishes queued jobs and joins the workers
+    ~JobSystem();
+    // The engine wide job system, created on first use by the GL thread
+    static JobSystem& Get();
+
+    // Queue a job. If a counter is given it is incremented now and
+    // decremented when the job finished.
+    void Run(Job job, JobCounter* counter = nullptr);
+    // Runs jobs until the counter reaches zero
+    void Wait(JobCounter& counter);
+    // Calls body(begin, end) on chunks of at most grainSize indices of
+    // [begin, end), spread over all threads, and returns once all finished.
+    // The body is called through a pointer, so no std::function is built.
+    template <typename Body>
+    void ParallelFor(size_t begin, size_t end, size_t grainSize, const Body& body) {
+        ParallelFor(begin, end, grainSize, &CallBody<Body>, &body);
+    }
+    // Same, with the body as a function and the context passed to it
+    void ParallelFor(size_t begin, size_t end, size_t grainSize,
+                     void (*body)(const void* context, size_t begin, size_t end), const void* context);
+
+    // Queue a job that must run on the GL thread (see PumpMainThread)
+    void RunOnMainThread(Job job);
+    // Runs the jobs queued with RunOnMainThread. Called by the GL thread.
+    void PumpMainThread();
+    // True on the thread that created the JobSystem
+    bool IsMainThread() const { return std::this_thread::get_id() == m_mainThreadId; }
+    // Gives the calling thread a queue of its own. For threads other than
+    // the GL thread and the workers that queue jobs and wait on them.
+    // @return false if every queue for such threads is taken, the thread
+    //         then shares the GL thread's queue
+    bool RegisterThread();
+
+    // Number of threads a batch is spread over: the workers and the
+    // thread that queued it
+    unsigned int GetThreadCount() const { return (unsigned int)m_workers.size() + 1; }
+
+private:
+    typedef std::pair<Job, JobCounter*> QueuedJob;
+
+    // Queues for registered threads, after those of the workers
+    static const unsigned int s_registeredQueues = 2;
+
+    // One double ended queue per thread, index 0 belongs to the GL thread.
+    // A ring over a vector that only grows, so that steady frames do not
+    // allocate the way std::deque does when its ends move.
+    struct WorkQueue{
+        std::mutex mutex;
+        std::vector<QueuedJob> slots;
+        // Oldest job, and number of jobs
+        size_t head{0};
+        size_t count{0};
+
+        void PushBack(Job&& job, JobCounter* counter);
+        // False if the queue is empty
+        bool PopBack(QueuedJob& job);
+        bool PopFront(QueuedJob& job);
+    };
+
+    // Calls a ParallelFor body of type Body
+    template <typename Body>
+    static void CallBody(const void* context, size_t begin, size_t end) {
+        (*static_cast<const Body*>(context))(begin, end);
+    }
+
+    // Loop of the worker threads
+    void WorkerLoop(unsigned int index);
+    // Pops a job from the own queue, or steals one if steal is set. False
+    // if none found.
+    bool TryRunJob(unsigned int index, bool steal);
+    // Index of the calling thread's queue
+    unsigned int GetThreadIndex() const;
+
+    std::vector<WorkQueue*> m_queues;
+    std::vector<std::thread> m_workers;
+    std::thread::id m_mainThreadId;
+    // Registered threads so far
+    std::atomic<unsigned int> m_registeredThreads;
+
+    // Jobs queued but not started, to let idle workers sleep
+    std::atomic<int> m_queuedJobs;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_stopping{false};
+
+    // Jobs for the GL thread
+    std::mutex m_mainThreadMutex;
+    std::vector<Job> m_mainThreadJobs;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef LOOSEOCTREE_HPP
+#define LOOSEOCTREE_HPP
+
+// LooseOctree is a spatial index of bounding boxes.
+// Every cell's loose bounds are twice its size, so an item is stored in the
+// deepest cell whose size is at least the item's, at the cell containing
+// its center, and never has to be split or stored twice. Moving an item is
+// usually a bounds update in place, or one unlink and link.
+// Items are referred to by the handle Insert returns, queries report the
+// user data attached to them (the SceneGraph uses its node indices).
+// Queries are const: any number of threads may query at once, as long as
+// no thread inserts, updates or removes meanwhile.
+
+#include <cstddef>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Bounds.hpp"
+
+class Frustum;
+class JobSystem;
+
+// One query of a batch (see LooseOctree::QueryBatch)
+struct OctreeQuery{
+    enum Type {
+        Box,         // items intersecting box
+        Sphere,      // items intersecting sphere
+        FrustumVolume, // items intersecting *frustum
+        Nearest      // the count items nearest to point, nearest first
+    };
+    Type type{Box};
+    AABB box;
+    BoundingSphere sphere;
+    const Frustum* frustum{nullptr};
+    glm::vec3 point{0.0f, 0.0f, 0.0f};
+    size_t count{1};
+};
+
+class LooseOctree{
+public:
+    // Handle of no item
+    static const int s_invalidHandle = -1;
+
+    // Constructor
+    // @param center, halfSize: The cube covered by the root cell. Items
+    //                          outside of it are kept in a list that every
+    //                          query tests.
+    // @param maxDepth: Depth of the smallest cells
+    LooseOctree(const glm::vec3& center = glm::vec3(0.0f), float halfSize = 1024.0f, int maxDepth = 8);
+
+    // Adds an item and returns its handle
+    int Insert(const AABB& bounds, int userData);
+    // Moves an item to new bounds
+    void Update(int handle, const AABB& bounds);
+    // Removes an item, its handle may be reused by the next Insert
+    void Remove(int handle);
+    // Removes all items and cells
+    void Clear();
+    void SetUserData(int handle, int userData) { m_items[handle].userData = userData; }
+    int GetUserData(int handle) const { return m_items[handle].userData; }
+    const AABB& GetBounds(int handle) const { return m_items[handle].bounds; }
+    // Number of items
+    size_t GetSize() const { return m_itemCount; }
+    // Number of cells allocated so far
+    size_t GetCellCount() const { return m_cells.size(); }
+
+    // Queries append the user data of the matching items to results
+    void QueryAABB(const AABB& box, std::vector<int>& results) const;
+    void QuerySphere(const BoundingSphere& sphere, std::vector<int>& results) const;
+    void QueryFrustum(const Frustum& frustum, std::vector<int>& results) const;
+    // The k items whose bounds are nearest to point, nearest first
+    void QueryNearest(const glm::vec3& point, size_t k, std::vector<int>& results) const;
+    // The first item a ray hits (for picking)
+    // @return false if the ray hits nothing
+    bool QueryRay(const glm::vec3& origin, const glm::vec3& direction, int& userData, float& distance) const;
+    // Runs many queries, spread over the JobSystem's threads if one is given.
+    // results[i] receives the matches of queries[i].
+    void QueryBatch(const std::vector<OctreeQuery>& queries, std::vector<std::vector<int>>& results, JobSystem* jobs) const;
+
+private:
+    // Cell of items that did not fit into the root
+    static const int s_overflowCell = -2;
+
+    struct Cell{
+        glm::vec3 center;
+        float halfSize;
+        int depth;
+        int children[8];
+        // Handles of the items stored in this cell
+        std::vector<int> items;
+    };
+    struct Item{
+        AABB bounds;
+        int userData;
+        int cell;   // s_invalidHandle while the slot is free
+        int slot;   // position in the cell's item list
+    };
+
+    // The cell an item with these bounds belongs to, creating cells as needed
+    int FindCell(const AABB& bounds);
+    void Link(int handle, int cell);
+    void Unlink(int handle);
+    std::vector<int>& GetCellItems(int cell) { return (cell == s_overflowCell) ? m_overflow : m_cells[cell].items; }
+    // Bounds every item of the cell lies in
+    AABB GetLooseBounds(const Cell& cell) const;
+    // Calls visit(handle) for the items of every cell whose loose bounds
+    // pass cellTest, and for the overflow items
+    template <typename CellTest, typename Visit>
+    void Traverse(const CellTest& cellTest, const Visit& visit) const;
+
+    glm::vec3 m_center;
+    float m_halfSize;
+    int m_maxDepth;
+    std::vector<Cell> m_cells;
+    std::vector<Item> m_items;
+    std::vector<int> m_freeItems;
+    std::vector<int> m_overflow;
+    size_t m_itemCount{0};
+};
+
+#endif
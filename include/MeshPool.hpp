@@ -0,0 +1,84 @@
+#ifndef MESHPOOL_HPP
+#define MESHPOOL_HPP
+
+// MeshPool keeps the vertices and indices of many meshes in one vertex
+// buffer and one index buffer behind a single vertex array, instead of a
+// VAO, VBO and EBO per Object. Meshes are suballocated from free ranges of
+// the buffers, and the buffers grow (copied on the GPU) when full.
+// Every mesh of the pool can then be drawn without switching vertex
+// arrays, in particular many of them with one glMultiDrawElementsIndirect
+// call (see RenderQueue). The vertex format is the Object layout:
+// position, color, normal, texcoord (11 floats).
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Where a mesh lives in the pool's buffers
+struct MeshRange{
+    // First vertex, added to every index (the baseVertex of a draw)
+    GLint baseVertex{0};
+    GLuint vertexCount{0};
+    // First index in the index buffer (the firstIndex of a draw)
+    GLuint firstIndex{0};
+    GLuint indexCount{0};
+};
+
+class MeshPool{
+public:
+    // Constructor, no OpenGL objects are created before the first Add
+    // @param vertexCapacity, indexCapacity: Initial size of the buffers
+    MeshPool(GLuint vertexCapacity = 65536, GLuint indexCapacity = 3 * 65536);
+    // Destructor
+    ~MeshPool();
+
+    // Returns the pool Objects are placed in unless told otherwise
+    static MeshPool& GetDefault();
+
+    // Copies a mesh into the pool
+    // @param vertexData: vertexCount * 11 floats
+    // @param indices: Indices into the mesh's own vertices
+    // @return Where the mesh was placed
+    MeshRange Add(const float* vertexData, GLuint vertexCount, const unsigned int* indices, GLuint indexCount);
+    // Frees a mesh's ranges for later meshes
+    void Remove(const MeshRange& mesh);
+
+    // The vertex array all meshes of the pool are drawn with
+    GLuint GetVertexArray() const { return m_vertexArray; }
+    GLuint GetVertexCapacity() const { return m_vertexCapacity; }
+    GLuint GetIndexCapacity() const { return m_indexCapacity; }
+    // Number of meshes in the pool
+    size_t GetMeshCount() const { return m_meshCount; }
+
+private:
+    // Floats per vertex
+    static const GLuint s_stride = 11;
+
+    // Free space of a buffer, as sorted, non-adjacent [offset, offset + count) ranges
+    struct FreeRange{
+        GLuint offset;
+        GLuint count;
+    };
+    // First fit allocation, returns false if no range is large enough
+    static bool Allocate(std::vector<FreeRange>& freeRanges, GLuint count, GLuint& offset);
+    // Returns a range, merging it with its neighbours
+    static void Free(std::vector<FreeRange>& freeRanges, GLuint offset, GLuint count);
+
+    // Creates the buffers and the vertex array
+    void Create();
+    // Grows a buffer to at least count elements, keeping its contents
+    void Grow(GLenum target, GLuint& buffer, GLuint& capacity, std::vector<FreeRange>& freeRanges, GLuint elementSize, GLuint count);
+    // Points the vertex array's attributes at the vertex buffer
+    void SetupVertexArray();
+
+    GLuint m_vertexArray;
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+    GLuint m_vertexCapacity;
+    GLuint m_indexCapacity;
+    std::vector<FreeRange> m_freeVertices;
+    std::vector<FreeRange> m_freeIndices;
+    size_t m_meshCount;
+};
+
+#endif
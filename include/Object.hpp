@@ -16,6 +16,8 @@
 #include "Texture.hpp"
 #include "Transform.hpp"
 #include "Geometry.hpp"
+#include "MeshPool.hpp"
+#include "FixedPool.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -44,8 +46,11 @@ class Object{
 public:
     // Object Constructor
     Object();
-    // Object destructor
-    ~Object();
+    // Object destructor, virtual so operator delete gets a subclass's size
+    virtual ~Object();
+    // Objects (and derived objects) come from the FixedPool of their size
+    static void* operator new(size_t size) { return FixedPool::AllocateSized(size); }
+    static void operator delete(void* block, size_t size) { FixedPool::FreeSized(block, size); }
     // Load a texture
     void LoadTexture(std::string fileName);
     // Load an OBJ model
@@ -53,7 +58,20 @@ public:
     // How to draw the object
     virtual void Render();
     VertexBufferLayout getVertexBufferLayout() {return m_vertexBufferLayout;}
-    Geometry getGeometry() {return m_geometry;}
+    const Geometry& getGeometry() const {return m_geometry;}
+    // Object space bounds of the loaded geometry
+    const AABB& GetBounds() const { return m_geometry.GetBounds(); }
+    const BoundingSphere& GetBoundingSphere() const { return m_geometry.GetBoundingSphere(); }
+    // GL state a draw of this object needs, for the RenderQueue
+    GLuint GetVertexArray() const { return m_vertexBufferLayout.GetVertexArray(); }
+    GLuint GetDiffuseTexture() const { return m_textureDiffuse.GetID(); }
+    GLsizei GetIndexCount() const { return (GLsizei)m_geometry.GetIndices().size(); }
+    // Copies the loaded geometry into a MeshPool as well, so the object
+    // can be drawn together with the pool's other meshes
+    void AddToMeshPool(MeshPool& pool = MeshPool::GetDefault());
+    // The pool the object was added to, nullptr if none, and where it is in it
+    MeshPool* GetMeshPool() const { return m_meshPool; }
+    const MeshRange& GetMeshRange() const { return m_meshRange; }
 
 protected:
     // one buffer per object.
@@ -63,6 +81,9 @@ protected:
     Texture m_normalMap;
     // Store the objects Geometry
 	Geometry m_geometry;
+    // Copy of the geometry in a shared buffer, see AddToMeshPool
+    MeshPool* m_meshPool{nullptr};
+    MeshRange m_meshRange;
 
     // OBJ loading
     std::string m_filePath;
@@ -71,6 +92,9 @@ protected:
     // Parse functions
     void parseOBJ(const std::string& filepath);
     void parseMTL(const std::string& filepath);
+    // Reads the texture file names of an MTL file without loading them.
+    // False if the file could not be opened.
+    static bool readMTL(const std::string& filepath, std::string& diffuseMap, std::string& normalMap);
     void Bind();
 };
 
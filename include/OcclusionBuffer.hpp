@@ -0,0 +1,76 @@
+#ifndef OCCLUSIONBUFFER_HPP
+#define OCCLUSIONBUFFER_HPP
+
+// OcclusionBuffer is a small depth buffer rendered on the CPU.
+// Designated occluders (large, simple meshes such as terrain and walls)
+// are rasterized into it in horizontal bands on the JobSystem's threads,
+// four pixels per SSE instruction. A pyramid of max depths is then built,
+// and a box is occluded if it is behind the farthest depth of the few
+// pyramid texels covering its screen rectangle.
+// Everything runs on the CPU, no OpenGL context is needed.
+
+#include <cstddef>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Bounds.hpp"
+
+class JobSystem;
+
+class OcclusionBuffer{
+public:
+    // Constructor
+    // @param width, height: Resolution of the depth buffer (width is rounded up to a multiple of 4)
+    OcclusionBuffer(int width = 256, int height = 128);
+
+    // Clears the buffer and the occluders for a new frame
+    // @param viewProjection: projection x view matrix of the camera
+    void Begin(const glm::mat4& viewProjection);
+    // Adds the triangles of an occluder. Triangles crossing the near plane
+    // are dropped, which can only make the buffer occlude less.
+    // @param positions, indices: The occluder's triangle mesh
+    // @param model: Its world transform
+    void AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& model);
+    // Rasterizes the occluders and builds the max-depth pyramid
+    // @param jobs: Threads to rasterize on, nullptr to rasterize here
+    void Rasterize(JobSystem* jobs);
+
+    // True if the box is certainly hidden behind the occluders
+    bool IsOccluded(const AABB& worldBounds) const;
+
+    // Number of occluder triangles of this frame
+    size_t GetTriangleCount() const { return m_triangles.size(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    // Depth in [0, 1] (1 is the far plane), row 0 at the bottom of the screen
+    float GetDepth(int x, int y) const { return m_levels[0][y * m_width + x]; }
+
+private:
+    // Rows of pixels a band job rasterizes
+    static const int s_bandHeight = 16;
+
+    // A triangle set up for rasterization: edge functions and a depth
+    // plane in pixel coordinates
+    struct ScreenTriangle{
+        float edgeA[3], edgeB[3], edgeC[3]; // inside where A x + B y + C >= 0
+        float depthA, depthB, depthC;       // depth = A x + B y + C
+        int minX, maxX, minY, maxY;         // pixel bounding box
+    };
+
+    // Rasterizes all triangles into rows [beginY, endY)
+    void RasterizeBand(int beginY, int endY);
+    // Builds levels 1..n from level 0
+    void BuildPyramid();
+
+    int m_width;
+    int m_height;
+    glm::mat4 m_viewProjection;
+    std::vector<ScreenTriangle> m_triangles;
+    // Level 0 is the depth buffer, every next level halves it, keeping the max
+    std::vector<std::vector<float>> m_levels;
+    std::vector<int> m_levelWidths;
+    std::vector<int> m_levelHeights;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+// Profiler captures what the engine spends its time on over a number of
+// frames and writes it as Chrome trace-event JSON, which Perfetto
+// (ui.perfetto.dev) and chrome://tracing open.
+// CPU zones are scopes marked with PROFILE_SCOPE("Name"). They nest, so a
+// trace shows Update, the culling inside it and the jobs it spread over
+// the workers, each on the track of its thread. Names are kept by pointer
+// and must be string literals. The FlightRecorder keeps them too.
+// GPU zones are marked with PROFILE_GPU_SCOPE("Name") on the GL thread.
+// A GL_TIMESTAMP query at each end lets them nest too. They are read back
+// s_gpuLatency frames later, so reading them does not stall, and shown on
+// a GPU track of the same timeline.
+// Outside a capture, with the flight recorder off, a zone costs two
+// relaxed atomic loads. With PROFILER_DISABLE defined the macros expand
+// to nothing.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FlightRecorder.hpp"
+
+// A zone or a frame marker, times in nanoseconds of Profiler::Now
+struct ProfileEvent{
+    const char* name;
+    int64_t start;
+    // Equal to start for a frame marker
+    int64_t end;
+};
+
+class Profiler{
+public:
+    // The engine wide profiler
+    static Profiler& Get();
+    // Nanoseconds on a steady clock
+    static int64_t Now();
+    // True while a capture runs
+    static bool IsCapturing() { return s_capturing.load(std::memory_order_relaxed); }
+
+    // Starts a capture written to filename once frameCount frames ended,
+    // or EndCapture is called if frameCount is 0
+    void BeginCapture(const std::string& filename, int frameCount);
+    // Ends the capture and writes the trace. Reads the GPU zones still in
+    // flight, so it must be called on the GL thread while the context
+    // exists. False if the trace could not be written.
+    bool EndCapture();
+    // Called by the GL thread once per frame: marks the frame, reads back
+    // the GPU zones of an older frame, and ends the capture after its frames
+    void EndFrame();
+
+    // Names the calling thread's track
+    void SetThreadName(const std::string& name);
+    // Adds a CPU zone of the calling thread
+    void RecordCpu(const char* name, int64_t start, int64_t end);
+    // Opens and closes a GPU zone, GL thread only
+    void BeginGpu(const char* name);
+    void EndGpu();
+
+    // Writes an event of a trace: a zone, or an instant if end equals start
+    // @param zero: Time the trace starts at
+    static void WriteTraceEvent(std::ostream& out, const ProfileEvent& event, int tid, int64_t zero);
+
+private:
+    Profiler();
+
+    // The zones of one thread. Only its thread appends, the mutex is there
+    // for the writer and is never contended during a capture.
+    struct ThreadBuffer{
+        std::mutex mutex;
+        std::vector<ProfileEvent> events;
+        std::string name;
+        int id;
+    };
+    // A GPU zone waiting for its queries
+    struct GpuZone{
+        const char* name;
+        unsigned int beginQuery;
+        unsigned int endQuery;
+    };
+    // The GPU zones of one frame, and the query names it reuses
+    struct GpuFrame{
+        std::vector<GpuZone> zones;
+        std::vector<unsigned int> queries;
+        size_t usedQueries{0};
+    };
+
+    // The calling thread's buffer, created on first use
+    ThreadBuffer* GetThreadBuffer();
+    // Issues a timestamp query in the current GPU frame
+    unsigned int QueryTimestamp();
+    // Moves a frame's finished zones to the GPU track
+    // @param wait: Block for results instead of dropping unfinished zones
+    void ReadGpuFrame(GpuFrame& frame, bool wait);
+    // Writes the trace
+    bool WriteTrace(const std::string& filename);
+
+    static std::atomic<bool> s_capturing;
+    // Frames a GPU zone is read back after
+    static const int s_gpuLatency = 3;
+    // Zones kept per thread and capture, the rest are dropped
+    static const size_t s_maxEventsPerThread = 1 << 20;
+
+    std::mutex m_threadsMutex;
+    std::vector<ThreadBuffer*> m_threads;
+
+    std::string m_filename;
+    int m_captureFrames{0};
+    int m_capturedFrames{0};
+    int64_t m_captureStart{0};
+    std::atomic<size_t> m_dropped{0};
+
+    // GPU zones: a ring of frames, the open zones of the current frame, and
+    // the offset from the GL clock to Now, measured on the first GPU zone
+    GpuFrame m_gpuFrames[s_gpuLatency + 1];
+    int m_gpuFrame{0};
+    std::vector<size_t> m_gpuOpen;
+    std::vector<ProfileEvent> m_gpuEvents;
+    bool m_gpuCalibrated{false};
+    int64_t m_gpuOffset{0};
+};
+
+// Times a scope into the capture and the flight recorder
+class ProfileScope{
+public:
+    explicit ProfileScope(const char* name)
+        : m_name(name), m_start((Profiler::IsCapturing() || FlightRecorder::IsEnabled()) ? Profiler::Now() : -1) {}
+    ~ProfileScope() {
+        if (m_start >= 0) {
+            int64_t end = Profiler::Now();
+            if (Profiler::IsCapturing()) {
+                Profiler::Get().RecordCpu(m_name, m_start, end);
+            }
+            if (FlightRecorder::IsEnabled()) {
+                FlightRecorder::Record(m_name, m_start, end);
+            }
+        }
+    }
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+// Names the calling thread's track in captures and flight recorder dumps
+inline void ProfileThreadName(const std::string& name) {
+    Profiler::Get().SetThreadName(name);
+    FlightRecorder::Get().SetThreadName(name);
+}
+
+// Times the GL commands of a scope into the capture
+class GpuProfileScope{
+public:
+    explicit GpuProfileScope(const char* name) { Profiler::Get().BeginGpu(name); }
+    ~GpuProfileScope() { Profiler::Get().EndGpu(); }
+};
+
+#ifndef PROFILER_DISABLE
+    #define PROFILE_CONCAT_INNER(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+    #define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+    #define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+    #define PROFILE_THREAD_NAME(name) ProfileThreadName(name)
+#else
+    #define PROFILE_SCOPE(name) ((void)0)
+    #define PROFILE_GPU_SCOPE(name) ((void)0)
+    #define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+
+// RenderQueue collects the frame's draws as small packets instead of
+// issuing them during the scene traversal. Every packet has a 64 bit key
+//   pass (2 bits) | program (14) | texture (16) | vertex array (16) | depth (16)
+// and the packets are radix sorted by it, so draws sharing a program,
+// texture and vertex array end up next to each other and are submitted
+// without rebinding. Within a state group opaque draws go front to back.
+// Nodes that draw themselves (the skybox) push a custom packet, which is
+// executed by calling SceneNode::DrawCustom in its place in the order.
+// Sorting also brings the draws of one mesh together: a run of packets
+// with the same program, texture and vertex array whose nodes have an
+// instanced program is drawn with one glDrawElementsInstanced, reading
+// the world matrices from an instance buffer filled once per frame.
+// With indirect draws enabled, packets of meshes in a MeshPool share the
+// pool's vertex array, and each run of them with the same program and
+// texture is drawn with one glMultiDrawElementsIndirect (their keys order
+// by mesh instead of depth, so each mesh is one command). The shader reads
+// the world matrices from the same buffer, bound as a storage buffer.
+// Packets are recorded by CommandLists, the queue's own (Push) and any
+// recorded elsewhere and appended (Append), so the recording can be spread
+// over job workers while the sorting and the GL calls stay on one thread.
+// Packets live in a FrameArena (the frame's, unless told otherwise): the
+// arena must be reset between frames, and Begin reserves as many packets
+// as the last frame had, so steady frames allocate nothing from the heap.
+// Given a FrameRing, the instance matrices and commands are written into
+// its mapped memory instead of being uploaded with glBufferData.
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "CommandList.hpp"
+#include "FrameArena.hpp"
+#include "FrameRing.hpp"
+#include "MeshPool.hpp"
+
+// Counters of the last Execute
+struct RenderQueueStats{
+    size_t packets{0};
+    // GL state changes (program, texture, vertex array) in traversal order,
+    // skipping only repeats of the previous packet's state
+    size_t stateChangesUnsorted{0};
+    // GL state changes actually issued after sorting
+    size_t stateChangesSorted{0};
+    // glDraw* calls issued, instanced ones included
+    size_t drawCalls{0};
+    // Triangles those draws cover (custom draws are not counted)
+    size_t triangles{0};
+    // Instanced draws, and the packets they replaced
+    size_t instancedDraws{0};
+    size_t instances{0};
+    // glMultiDrawElementsIndirect calls, and the packets they drew
+    size_t indirectDraws{0};
+    size_t indirectPackets{0};
+    // CPU time of Execute, in milliseconds
+    double submitMs{0.0};
+    // Bytes of instance matrices and commands written for this frame
+    size_t uploadBytes{0};
+};
+
+class RenderQueue{
+public:
+    // Constructor
+    RenderQueue();
+    // Destructor
+    ~RenderQueue();
+
+    // Starts a new frame. The packets of the last frame are dropped
+    // without touching their memory, which the arena's Reset reclaimed.
+    // @param view: View matrix, used for the depth part of the keys
+    // @param projection: Projection matrix, set on the programs with the view
+    // @param farPlane: Distance mapped to the largest depth key
+    void Begin(const glm::mat4& view, const glm::mat4& projection, float farPlane);
+    // Adds a draw of an indexed triangle mesh
+    void Push(RenderPass pass, GLuint program, GLuint instancedProgram, GLuint texture, GLuint vertexArray, GLsizei indexCount, const glm::mat4& model);
+    // Adds a draw of a mesh in a MeshPool, drawn indirectly. Its program
+    // reads the world matrix from storage buffer 0 at index drawIndex
+    // (attribute 4), see shaders/vert_indirect.glsl.
+    void PushIndirect(RenderPass pass, GLuint program, GLuint texture, const MeshPool& pool, const MeshRange& mesh, const glm::mat4& model);
+    // Adds a node that issues its own GL calls
+    void PushCustom(RenderPass pass, SceneNode* node);
+    // Adds the packets of a list recorded since this Begin, after the ones
+    // already queued. The list's packets must stay valid until Execute.
+    void Append(const CommandList& list);
+    // The list Push records into, for code that records through a CommandList
+    CommandList& GetCommandList() { return m_list; }
+    // Sorts the packets by key
+    void Sort();
+    // Groups the sorted packets into draws and gathers the instance
+    // matrices. Needs no OpenGL, Execute calls it.
+    void BuildBatches();
+    // Issues the packets in order, binding only what changed
+    void Execute();
+
+    // Lets nodes submit indirect packets (needs OpenGL 4.3)
+    void SetIndirectEnabled(bool enabled);
+    bool IsIndirectEnabled() const { return m_indirectEnabled; }
+    // Ring the per-frame data is written to, nullptr (or an unavailable
+    // ring) to upload it with glBufferData
+    void SetFrameRing(FrameRing* ring) { m_ring = ring; }
+    // Arena the packets are allocated from, reset by its owner between frames
+    void SetArena(FrameArena* arena) { m_arena = arena; }
+
+    const RenderQueueStats& GetStats() const { return m_stats; }
+
+private:
+    // Runs shorter than this are drawn one packet at a time
+    static const size_t s_minInstances = 2;
+    // First attribute location of the instance matrix (4 to 7)
+    static const GLuint s_instanceAttribute = 4;
+
+    // Packets of one frame, in the arena
+    typedef CommandList::PacketArray PacketArray;
+
+    // How a batch is drawn
+    enum BatchType {
+        BatchSingle,    // glDrawElements of one packet
+        BatchInstanced, // glDrawElementsInstanced of one mesh
+        BatchIndirect   // glMultiDrawElementsIndirect of pooled meshes
+    };
+
+    // Consecutive packets drawn with one call
+    struct DrawBatch{
+        BatchType type;
+        size_t first;
+        size_t count;
+        // Index of the first matrix in m_instanceMatrices, for instanced batches
+        size_t firstInstance;
+        // Commands in m_commands, for indirect batches
+        size_t firstCommand;
+        size_t commandCount;
+    };
+
+    // Layout glMultiDrawElementsIndirect reads
+    struct DrawElementsIndirectCommand{
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Locations of the matrices a program reads, looked up once
+    struct ProgramUniforms{
+        GLint model;
+        GLint view;
+        GLint projection;
+        // Frame the view and projection were last set in
+        unsigned int frame;
+    };
+
+    // Appends the commands of an indirect run [first, end)
+    void BuildIndirectBatch(size_t first, size_t end);
+    // Uploads size bytes to a buffer, creating it on first use
+    static void Upload(GLenum target, GLuint& buffer, GLsizeiptr size, const void* data);
+    // Places this frame's data in the ring if possible, else uploads it to
+    // buffer. Returns where the data is in allocation.
+    void Stream(GLenum target, GLuint& buffer, GLsizeiptr size, GLsizeiptr alignment, const void* data, FrameRing::Allocation& allocation);
+
+    // Binds program, setting view and projection on first use this frame
+    ProgramUniforms& UseProgram(GLuint program);
+
+    // State changes needed to issue the packets in their current order
+    size_t CountStateChanges() const;
+
+    glm::mat4 m_view;
+    glm::mat4 m_projection;
+    float m_farPlane;
+    unsigned int m_frame;
+    FrameArena* m_arena;
+    // Packets pushed to the queue, and appended ones after them. m_packets
+    // is the list's array, which Sort reorders.
+    CommandList m_list;
+    PacketArray& m_packets;
+    // Scratch buffer of the radix sort
+    PacketArray m_sortBuffer;
+    std::vector<DrawBatch> m_batches;
+    // World matrices of the instanced batches, uploaded once per frame
+    std::vector<glm::mat4> m_instanceMatrices;
+    GLuint m_instanceBuffer;
+    // Indirect draws: commands, and 0, 1, 2, ... read as the draw index
+    // with a divisor of 1, so that baseInstance selects the matrix
+    bool m_indirectEnabled;
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    GLuint m_commandBuffer;
+    GLuint m_drawIndexBuffer;
+    GLuint m_drawIndexCount;
+    // Where this frame's matrices and commands are
+    FrameRing* m_ring;
+    FrameRing::Allocation m_instanceData;
+    FrameRing::Allocation m_commandData;
+    std::unordered_map<GLuint, ProgramUniforms> m_uniforms;
+    RenderQueueStats m_stats;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef RENDERTARGET_HPP
+#define RENDERTARGET_HPP
+
+#include <glad/glad.h>
+
+// RenderTarget is an offscreen framebuffer with a color texture and a
+// depth buffer, used to render at a resolution other than the window's.
+class RenderTarget{
+public:
+    // Constructor
+    RenderTarget();
+    // Destructor
+    ~RenderTarget();
+    // (Re)creates the attachments at the given size
+    void Create(int width, int height);
+    // Bind as the framebuffer to draw into, and set the viewport to match
+    void Bind() const;
+    // Go back to drawing into the window
+    void Unbind() const;
+    // Copy the color attachment into another framebuffer (0 is the window),
+    // scaling it to fill width x height
+    void BlitTo(GLuint framebuffer, int width, int height) const;
+    // Getters
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    GLuint GetColorTexture() const { return m_colorTexture; }
+
+private:
+    // Deletes the framebuffer and its attachments
+    void Destroy();
+
+    GLuint m_framebuffer{0};
+    GLuint m_colorTexture{0};
+    GLuint m_depthBuffer{0};
+    int m_width{0};
+    int m_height{0};
+};
+
+#endif
@@ -16,6 +16,14 @@
 #include <iostream>
 
 #include "Camera.hpp"
+#include "FrameStats.hpp"
+#include "Frustum.hpp"
+#include "OcclusionBuffer.hpp"
+#include "FrameRing.hpp"
+#include "RenderQueue.hpp"
+#include "GpuCulling.hpp"
+#include "FrameArena.hpp"
+#include "FrameSnapshot.hpp"
 
 class SceneNode;
 
@@ -26,19 +34,60 @@ public:
     Renderer(unsigned int w, unsigned int h);
     // Destructor
     ~Renderer();
-    // Update the scene
+    // Update the scene: world transforms, culling and node updates, written
+    // to the update snapshot. Makes no GL calls, so it may run on another
+    // thread (see SimulationThread) while Render draws the other snapshot.
     void Update();
-    // Render the scene
+    // Takes the first camera's view for the next Update. The frame loop
+    // calls it before handing Update to the simulation thread, so that the
+    // camera may move during the update. Update latches it itself if not.
+    void LatchCamera();
+    // Render the latest camera view instead of the one Update culled with
+    void SetLateLatch(bool enabled) { m_lateLatch = enabled; }
+    // Hands the snapshot Update wrote to Render, and gives Update the other
+    // one. Call when neither of them runs.
+    void SwapSnapshots() { m_updateSnapshot ^= 1; }
+    // Render the scene of the last swapped snapshot. GL thread only.
     void Render();
+    // Records the draw packets of the snapshot Render draws into the render
+    // queue. Large snapshots are split over the job workers, each recording
+    // a CommandList, and the lists are appended in order. No GL calls.
+    void RecordCommands();
+    // Record on the job workers (default), or on the calling thread only
+    void SetParallelRecording(bool enabled) { m_parallelRecording = enabled; }
     // Sets the root of our renderer to some node to draw an entire scene graph
     void setRoot(SceneNode* startingNode);
     // Setters for time and mouse position
     void SetStartTime(Uint32 time) { startTime = time; }
     void SetMousePosition(int x, int y) { mouseX = x; mouseY = y; }
+    // Animation time in seconds of the frame to update, set by the frame
+    // loop (interpolated between its fixed simulation steps)
+    void SetTime(double seconds) { m_time = seconds; }
+    double GetTime() const { return m_time; }
     // Getters for time and mouse position
     Uint32 GetStartTime() const { return startTime; }
     int GetMouseX() const { return mouseX; }
     int GetMouseY() const { return mouseY; }
+    // Change the size the renderer draws at (e.g. when rendering offscreen)
+    void SetScreenSize(unsigned int w, unsigned int h) { m_screenWidth = w; m_screenHeight = h; }
+    // Quality of the sky pass, picked by the FrameGovernor
+    void SetSkyQuality(float resolutionScale, int auroraSteps) { m_skyResolutionScale = resolutionScale; m_auroraSteps = auroraSteps; }
+    float GetSkyResolutionScale() const { return m_skyResolutionScale; }
+    int GetAuroraSteps() const { return m_auroraSteps; }
+    // Draw pooled meshes with glMultiDrawElementsIndirect instead of per node
+    void SetIndirectDraws(bool enabled) { m_queue.SetIndirectEnabled(enabled); }
+    // Turns on the GPU driven path for the instances added to GetGpuCulling()
+    void EnableGpuCulling();
+    // Hands the nodes of a subtree whose mesh is in the default MeshPool to
+    // the GPU driven path, which culls and draws them from then on instead
+    // of the RenderQueue. Call between updates, like any scene change.
+    // @return Number of nodes added, 0 unless EnableGpuCulling succeeded
+    size_t AddGpuCulledNodes(SceneNode* root);
+    // Gives every node back to the RenderQueue, before they are deleted
+    void ClearGpuCulledNodes();
+    GpuCulling& GetGpuCulling() { return m_gpuCulling; }
+    // Measurements and counters of the current frame
+    FrameStats& GetStats() { return m_stats; }
     // Getters for screen dimensions
     unsigned int GetScreenWidth() const { return m_screenWidth; }
     unsigned int GetScreenHeight() const { return m_screenHeight; }
@@ -57,15 +106,61 @@ protected:
     SceneNode* m_root;
     // Store the projection matrix for our camera.
     glm::mat4 m_projectionMatrix;
+    // View volume of the first camera, for culling
+    Frustum m_frustum;
+    // CPU depth buffer of the occluders, for occlusion culling
+    OcclusionBuffer m_occlusionBuffer;
+    // Mapped memory the frame's dynamic buffer data is written to
+    FrameRing m_frameRing;
+    // Draw packets of the frame, sorted to minimize state changes
+    RenderQueue m_queue;
+    // View Update culls with, and the view Render draws with
+    glm::mat4 m_updateView{1.0f};
+    bool m_cameraLatched{false};
+    glm::mat4 m_renderView{1.0f};
+    bool m_lateLatch{false};
+    // Lists the workers record into, one per chunk of the visible nodes
+    std::vector<CommandList> m_commandLists;
+    bool m_parallelRecording{true};
+    // Instances culled and drawn entirely on the GPU, the node of each
+    // instance, and whether the next Update sends every instance's matrix
+    GpuCulling m_gpuCulling;
+    std::vector<SceneNode*> m_gpuCulledNodes;
+    bool m_gpuInstancesAdded{false};
+    // Update writes m_snapshots[m_updateSnapshot], Render draws the other
+    FrameSnapshot m_snapshots[2];
+    int m_updateSnapshot{0};
+    // Transient data of Render (the queue's packets). Update uses
+    // FrameArena::GetFrame(), each side resets its own arena.
+    FrameArena m_renderArena;
 
 private:
+    // Fewest visible nodes a worker records, below that one thread is faster
+    static const size_t s_recordGrainSize = 2048;
+    // Field of view Update culls with when the view is latched late. The
+    // camera may turn between the update and the draw, a wider frustum
+    // keeps what comes into view from popping in.
+    static constexpr float s_lateLatchCullFov = 55.0f;
+
+    // Adds the visible nodes with an object of a subtree to the snapshot,
+    // skipping the subtrees the last Cull rejected
+    void GatherVisible(SceneNode* node, FrameSnapshot& snapshot);
+    // Adds the moved GPU culled nodes to the snapshot
+    void GatherGpuInstances(FrameSnapshot& snapshot);
+
     // Screen dimension constants
     int m_screenHeight;
     int m_screenWidth;
     // Time and mouse variables
     Uint32 startTime;
+    double m_time{0.0};
     int mouseX;
     int mouseY;
+    // Sky pass quality
+    float m_skyResolutionScale{1.0f};
+    int m_auroraSteps{50};
+    // Frame measurements and counters
+    FrameStats m_stats;
 };
 
 #endif
@@ -12,43 +12,157 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <utility>
+#include <vector>
 
 #include "SceneNode.hpp"
 #include "Renderer.hpp"
 #include "Object.hpp"
 #include "SkyboxNode.hpp"
 #include "Camera.hpp"
+#include "GLExtensions.hpp"
+#include "RenderTarget.hpp"
+#include "GpuTimer.hpp"
+#include "FrameGovernor.hpp"
+#include "JobSystem.hpp"
+#include "SimulationThread.hpp"
+#include "FramePacer.hpp"
+#include "FrameLatency.hpp"
+#include "InputQueue.hpp"
+#include "CameraPath.hpp"
+#include "StressScene.hpp"
 
 // This class sets up a full graphics program using SDL
 class SDLGraphicsProgram{
 public:
 
-    // Constructor
-    SDLGraphicsProgram(int w, int h);
+    // Constructor, hidden keeps the window hidden (for the benchmark)
+    SDLGraphicsProgram(int w, int h, bool hidden = false);
     // Destructor
     ~SDLGraphicsProgram();
     // Setup OpenGL
     bool InitGL();
+    // Whether SDL, the window and the OpenGL context were created
+    bool IsInitialized() const { return m_initialized; }
     // Loop that runs forever
     void Loop();
     // Get Pointer to Window
     SDL_Window* GetSDLWindow();
     // Helper Function to Query OpenGL information.
     void GetOpenGLVersionInfo();
-    // Helper Function to control user input
+    // Helper Function to control user input: applies the queued input
     void Input(bool& quit, float cameraSpeed);
     // Initialize Scene Graph and objects in the Scene Graph
     void InitSceneGraph();
-    // Update Objects in Scene Graph
-    void UpdateObjectsInScene();
+    // Update Objects in Scene Graph by one fixed simulation step
+    void UpdateObjectsInScene(double stepSeconds);
+    // Select how the skybox evaluates the aurora (applied in InitSceneGraph)
+    void SetAuroraPath(AuroraPath path) { m_auroraPath = path; }
+    // Target frame time the quality governor aims for, <= 0 keeps full quality
+    void SetFrameBudget(double budgetMs) { m_governor.SetBudget(budgetMs); }
+    // Draw pooled meshes with one indirect draw per shader and texture
+    void SetIndirectDraws(bool enabled) { m_renderer->SetIndirectDraws(enabled); }
+    // Cull and draw the renderer's GPU culling instances on the GPU
+    void EnableGpuCulling() { m_renderer->EnableGpuCulling(); }
+    // Update the next frame on a simulation thread while this one renders
+    // (default), or run update and render one after the other
+    void SetPipelined(bool pipelined) { m_pipelined = pipelined; }
+    // Simulation steps per second, the scene advances in steps of this length
+    void SetSimulationRate(double hz) { m_simulationStep = 1.0 / hz; }
+    // Most frames per second, 0 for no limit (ignored with vsync)
+    void SetFrameRateCap(double fps) { m_frameRateCap = fps; }
+    // Pace frames with the display's refresh instead of the limiter
+    void SetVsync(bool enabled) { m_vsync = enabled; }
+    // Apply input again right before the draw and render with that camera
+    void SetLateLatch(bool enabled) { m_lateLatch = enabled; }
+    // Most swapped frames the GPU may still be working on
+    void SetMaxFramesInFlight(int frames) { m_framesInFlight = frames; }
+    // Record the camera and the input of every frame to a file
+    void RecordCameraPath(const std::string& filename) { m_recordPath = filename; }
+    // Play a recorded camera path instead of taking input, one simulation
+    // step per frame, and quit at its end
+    void PlayCameraPath(const std::string& filename) { m_playPath = filename; }
+    // Pin the quality to one governor tier instead of a frame budget
+    void SetQualityTier(int tier) { m_governor.SetFixedTier(tier); }
+    // Render a fixed number of frames offscreen at the window's size and
+    // write a JSON report of frame time percentiles, draw calls, triangles
+    // and startup phases to output (stdout if empty). False if the report
+    // could not be written.
+    bool RunBenchmark(int frames, int warmupFrames, const std::string& output);
+    // Add a generated stress scene under the skybox (see StressScene)
+    void SetStressScene(const StressSceneSettings& settings) { m_stressSettings = settings; m_stress = true; }
+    // Render a stress scene of each node count offscreen and write a CSV
+    // of the update, cull and submit cost and memory per node to output
+    // (stdout if empty). False if it could not be written.
+    bool RunStressSweep(const StressSceneSettings& settings, const std::vector<size_t>& nodeCounts,
+                        int frames, const std::string& output);
+    // Render the sky offscreen with both aurora paths at several
+    // resolutions and print the average GPU time of each
+    void BenchmarkAurora();
 
 private:
+	// What MeasureFrames collects, per measured frame
+	struct FrameSamples{
+	    std::vector<double> cpuMs;
+	    std::vector<double> gpuMs;
+	    std::vector<double> updateMs;
+	    std::vector<double> cullMs;
+	    std::vector<double> recordMs;
+	    std::vector<double> submitMs;
+	    // Sums over the measured frames
+	    double drawCalls{0.0};
+	    double triangles{0.0};
+	    double drawPackets{0.0};
+	    double firstFrameMs{0.0};
+	};
+	// Render frames into the bound framebuffer, one simulation step each,
+	// for RunBenchmark and RunStressSweep
+	void MeasureFrames(int warmupFrames, int frames, FrameSamples& samples);
+	bool m_initialized{false};
+	// Milliseconds each startup phase took, in order
+	std::vector<std::pair<std::string, double>> m_startupPhases;
 	// The Renderer responsible for drawing objects in OpenGL
 	Renderer* m_renderer;
     // The window we'll be rendering to
     SDL_Window* m_window ;
     // OpenGL context
     SDL_GLContext m_openGLContext;
+    // Pipeline the skybox evaluates the aurora with
+    AuroraPath m_auroraPath{AuroraPath::Fragment};
+    // Adapts sky quality to the frame budget
+    FrameGovernor m_governor;
+    // Overlap Renderer::Update and Renderer::Render, see SimulationThread
+    bool m_pipelined{true};
+    // Most simulation steps run in one frame
+    static const int s_maxSteps = 5;
+    // Length of a simulation step in seconds
+    double m_simulationStep{1.0 / 60.0};
+    // Frame pacing, and the jitter histogram printed with the stats
+    FramePacer m_pacer;
+    double m_frameRateCap{60.0};
+    bool m_vsync{false};
+    // Input events, stamped on arrival
+    InputQueue m_input;
+    bool m_lateLatch{true};
+    // Frames in flight limit, and input to present latency
+    FrameLatency m_latency;
+    int m_framesInFlight{2};
+    // Camera path being recorded or played back
+    CameraPath m_cameraPath;
+    std::string m_recordPath;
+    std::string m_playPath;
+    bool m_playing{false};
+    // Generated scene added by InitSceneGraph, or swept by RunStressSweep
+    StressScene m_stressScene;
+    StressSceneSettings m_stressSettings;
+    bool m_stress{false};
+    // Accumulates frame times and prints the stats once per second
+    void ReportStats(double cpuMs, double gpuMs);
+    Uint32 m_statsStartTime{0};
+    int m_statsFrames{0};
+    int m_statsGpuSamples{0};
+    double m_statsCpuMs{0.0};
+    double m_statsGpuMs{0.0};
 };
 
 #endif
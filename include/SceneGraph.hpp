@@ -0,0 +1,177 @@
+#ifndef SCENEGRAPH_HPP
+#define SCENEGRAPH_HPP
+
+// SceneGraph is the storage behind SceneNode.
+// Local and world transforms, parent indices and flags live in parallel
+// arrays kept in topological order (every parent before its children),
+// so all world transforms are computed in one linear pass instead of a
+// pointer-chasing recursion. A SceneNode is a handle holding its index.
+// Only nodes whose local transform changed, or whose parent's world
+// transform changed, are recomputed. Large graphs are updated one depth
+// level at a time, each level split across the JobSystem's threads.
+// Every node also has world space bounds of its own geometry and of its
+// whole subtree, so Cull can reject a subtree with one test. Optionally a
+// LooseOctree of the nodes' world bounds is kept in sync, which then backs
+// culling and answers spatial queries (picking, what is near the camera).
+
+#include <vector>
+#include <cstddef>
+
+#include "Transform.hpp"
+#include "Bounds.hpp"
+#include "LooseOctree.hpp"
+
+class SceneNode;
+class JobSystem;
+class Frustum;
+class OcclusionBuffer;
+
+// Per-node flags stored alongside the transforms
+enum SceneNodeFlags : unsigned int {
+    NodeFlagAlive = 1u << 0,        // Slot holds a node (cleared on removal)
+    NodeFlagReparented = 1u << 1,   // Parent changed since the last pass
+    NodeFlagWorldChanged = 1u << 2, // World transform was recomputed in the last pass
+    NodeFlagHasBounds = 1u << 3,    // Node draws geometry with known bounds
+    NodeFlagBoundsChanged = 1u << 4,// Local bounds changed since the last pass
+    NodeFlagNeverCull = 1u << 5,    // Always drawn (e.g. the skybox)
+    NodeFlagSubtreeNeverCull = 1u << 6, // Node or a descendant is never culled
+    NodeFlagVisible = 1u << 7,      // Last Cull kept the node's own geometry
+    NodeFlagSubtreeVisible = 1u << 8,// Last Cull kept some of the subtree
+    NodeFlagOccluder = 1u << 9      // Rasterized into the OcclusionBuffer
+};
+
+// Result of a culling pass
+struct CullStats{
+    size_t visible{0};          // Nodes with geometry that are drawn
+    size_t culled{0};           // Nodes with geometry that are skipped
+    size_t subtreesRejected{0}; // Subtrees rejected with one test
+    size_t occlusionTested{0};  // Visible nodes tested against the occluders
+    size_t occluded{0};         // ... and found hidden (counted in culled)
+};
+
+class SceneGraph{
+public:
+    // Parent index of root nodes
+    static const int s_noParent = -1;
+    // Below this many nodes the serial pass is faster than handing out jobs
+    static const size_t s_parallelThreshold = 4096;
+    // Nodes per job in the parallel pass
+    static const size_t s_parallelGrainSize = 1024;
+
+    // Constructor
+    SceneGraph();
+    // Destructor
+    ~SceneGraph();
+    // The storage nodes are created in unless told otherwise
+    static SceneGraph& GetDefault();
+
+    // Adds a node without a parent and returns its index
+    int Add(SceneNode* node);
+    // Frees the slot of a node. The slot is reclaimed by the next sort.
+    void Remove(int index);
+    // Attaches a node below another one
+    void SetParent(int child, int parent);
+
+    // Recomputes the world transforms of the nodes that moved, and of
+    // their descendants, in one pass over the arrays.
+    // With a JobSystem, graphs of s_parallelThreshold nodes or more are
+    // updated level by level in parallel.
+    void UpdateWorldTransforms(JobSystem* jobs = nullptr);
+    // Number of world transforms recomputed by the last pass
+    size_t GetRecomputedCount() const { return m_recomputedCount; }
+
+    // Object space bounds of the node's geometry (an empty box for none)
+    void SetLocalBounds(int index, const AABB& bounds);
+    // Nodes that are not cullable are always drawn, and so are their parents
+    void SetCullable(int index, bool cullable);
+    // Marks every node visible or not. Subtrees whose bounds are outside
+    // the frustum are rejected without visiting them. Uses the bounds of
+    // the last UpdateWorldTransforms.
+    CullStats Cull(const Frustum& frustum);
+    // Occluders are rasterized by GatherOccluders
+    void SetOccluder(int index, bool occluder);
+    // Number of live nodes marked as occluder, 0 lets the renderer skip
+    // occlusion culling
+    size_t GetOccluderCount() const { return m_occluderCount; }
+    // Adds the meshes of the occluders that passed the last Cull to the
+    // buffer (after OcclusionBuffer::Begin)
+    // @return The number of occluders added
+    size_t GatherOccluders(OcclusionBuffer& buffer);
+    // Hides the visible nodes the rasterized buffer occludes
+    // @param stats: The result of Cull, updated with the occlusion results
+    void CullOccluded(const OcclusionBuffer& buffer, CullStats& stats);
+    // World space bounds of the node's geometry, and of its subtree
+    const AABB& GetWorldBounds(int index) const { return m_worldBounds[index]; }
+    const AABB& GetSubtreeBounds(int index) const { return m_subtreeBounds[index]; }
+
+    // Keeps a LooseOctree of every cullable node with geometry, updated by
+    // UpdateWorldTransforms. Cull then queries it instead of walking the
+    // graph. Queries report node indices.
+    // @param center, halfSize, maxDepth: See LooseOctree
+    void EnableSpatialIndex(const glm::vec3& center, float halfSize, int maxDepth);
+    // The octree, nullptr unless enabled. Safe to query from any thread
+    // outside of UpdateWorldTransforms.
+    const LooseOctree* GetSpatialIndex() const { return m_spatialIndex; }
+    // The node whose bounds a ray hits first, nullptr if none.
+    // Needs the spatial index.
+    SceneNode* Pick(const glm::vec3& origin, const glm::vec3& direction) const;
+    SceneNode* GetNode(int index) const { return m_nodes[index]; }
+
+    // Accessors by index. Handing out a local transform counts as moving
+    // it: the next UpdateWorldTransforms looks at the dirty flags.
+    Transform& GetLocalTransform(int index) { m_localsTouched = true; return m_localTransforms[index]; }
+    Transform& GetWorldTransform(int index) { return m_worldTransforms[index]; }
+    int GetParent(int index) const { return m_parents[index]; }
+    unsigned int GetFlags(int index) const { return m_flags[index]; }
+    // Number of slots, including freed ones not yet reclaimed
+    size_t GetSize() const { return m_nodes.size(); }
+
+private:
+    // Restores topological (breadth first) order, drops freed slots and
+    // updates the index held by every SceneNode
+    void Sort();
+    // Recomputes the out of date world transforms in [begin, end)
+    // @return The number of world transforms recomputed
+    size_t UpdateRange(size_t begin, size_t end);
+    // Gathers every subtree's bounds into its parent, children first
+    void UpdateSubtreeBounds();
+    // Brings the octree up to date with the nodes' world bounds
+    // @param all: Visit every node, not only the ones that moved
+    void UpdateSpatialIndex(bool all);
+    // Cull using the octree
+    CullStats CullSpatialIndex(const Frustum& frustum);
+    // Marks a node's ancestors as having visible descendants
+    void MarkAncestorsVisible(int index);
+
+    // Parallel arrays, one entry per node
+    std::vector<Transform> m_localTransforms;
+    std::vector<Transform> m_worldTransforms;
+    std::vector<int> m_parents;
+    std::vector<unsigned int> m_flags;
+    std::vector<AABB> m_localBounds;
+    std::vector<AABB> m_worldBounds;
+    std::vector<AABB> m_subtreeBounds;
+    // Octree handle of every node, LooseOctree::s_invalidHandle if not in it
+    std::vector<int> m_spatialHandles;
+    // Back pointers, to keep the handles' indices in sync when sorting
+    std::vector<SceneNode*> m_nodes;
+    // Start of every depth level (breadth first order), plus the end
+    std::vector<size_t> m_levelOffsets;
+    // Set when a parent was attached after its child, or a node removed
+    bool m_needsSort{false};
+    // Cleared by any structural change, the parallel pass re-sorts first
+    bool m_levelsValid{false};
+    // Set when nodes were added, removed or reparented since the last pass
+    bool m_structureChanged{false};
+    // Set when a local transform was handed out since the last pass
+    bool m_localsTouched{false};
+    // Some node still carries NodeFlagWorldChanged from the last pass
+    bool m_hasWorldChangedFlags{false};
+    size_t m_recomputedCount{0};
+    size_t m_occluderCount{0};
+    // Optional spatial index, and the scratch list of its query results
+    LooseOctree* m_spatialIndex{nullptr};
+    std::vector<int> m_queryResults;
+};
+
+#endif
@@ -3,6 +3,9 @@
 
 // SceneNode helps organize a large 3D graphics scene.
 // The traversal of the tree takes place starting from root.
+// Transforms are stored in a SceneGraph, the node is a handle into it.
+// Nodes are allocated from a FixedPool and link their children as a list
+// through the children themselves, so adding a child allocates nothing.
 
 #include <vector>
 #include <memory>
@@ -14,6 +17,10 @@
 #include "Camera.hpp"
 #include "Shader.hpp"
 #include "Renderer.hpp"
+#include "SceneGraph.hpp"
+#include "RenderQueue.hpp"
+#include "FixedPool.hpp"
+#include "FrameSnapshot.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -22,35 +29,91 @@ class Renderer;
 
 class SceneNode{
 public:
-    // A SceneNode is created by taking a pointer to an object
-    SceneNode(Object* ob, std::string vertShader, std::string fragShader);
+    // A SceneNode is created by taking a pointer to an object.
+    // Its transforms are stored in scene, or the default SceneGraph.
+    // Without shader paths it is a group node that compiles nothing.
+    SceneNode(Object* ob, std::string vertShader, std::string fragShader, SceneGraph* scene = nullptr);
     // Destructor destroys all of the children within the node
     virtual ~SceneNode();
+    // Nodes (and derived nodes) come from the FixedPool of their size
+    static void* operator new(size_t size) { return FixedPool::AllocateSized(size); }
+    static void operator delete(void* block, size_t size) { FixedPool::FreeSized(block, size); }
     // Adds a child node to our current node
     void AddChild(SceneNode* n);
-    // Draws the current SceneNode
-    virtual void Draw();
-    // Updates the current SceneNode
-    virtual void Update(glm::mat4 projectionMatrix, Camera* camera, Renderer* renderer);
+    // Records this node's draw packets. Called by Renderer::RecordCommands
+    // for every node of the snapshot's visible list, possibly on a job
+    // worker: no GL calls, and nothing shared is written.
+    // @param world: The node's world matrix, owned by the snapshot
+    virtual void Submit(CommandList& list, const glm::mat4& world, const FrameSnapshot& snapshot);
+    // Draws only this node's object, binding everything it needs.
+    // Called by the RenderQueue for custom packets.
+    virtual void DrawCustom();
+    // Called once per frame by Renderer::Update on the root node only, the
+    // children are not visited (world transforms are already up to date,
+    // see SceneGraph::UpdateWorldTransforms). The SkyboxNode root captures
+    // the sky's inputs here. May run on the simulation thread: no GL calls,
+    // per-frame data the draw needs goes into snapshot.
+    virtual void Update(const glm::mat4& projectionMatrix, Camera* camera, Renderer* renderer, FrameSnapshot& snapshot);
     // Returns the local transformation transform
     // Local is local to an object, where it's center is the origin
     Transform& GetLocalTransform();
     // Returns a SceneNode's world transform
     Transform& GetWorldTransform();
+    // Hands the object's bounds to the SceneGraph. Call again after the
+    // object's geometry was (re)loaded.
+    void RefreshBounds();
+    // Allows instanced draws of this node's object, see RenderQueue
+    // @param instancedVertShader: instanced variant of the node's vertex shader
+    void EnableInstancing(const std::string& instancedVertShader);
+    // Lets the RenderQueue draw this node's pooled mesh indirectly, see
+    // Object::AddToMeshPool and RenderQueue::SetIndirectEnabled
+    // @param indirectVertShader: indirect variant of the node's vertex shader
+    void EnableIndirect(const std::string& indirectVertShader);
+    // Non cullable nodes are always drawn (default: cullable)
+    void SetCullable(bool cullable);
+    // Occluders are rasterized into the OcclusionBuffer to hide the nodes
+    // behind them. Use it for large, simple meshes (terrain, walls).
+    void SetOccluder(bool occluder);
+    // Walks the children: for (c = GetFirstChild(); c; c = c->GetNextSibling())
+    SceneNode* GetFirstChild() const { return m_firstChild; }
+    SceneNode* GetNextSibling() const { return m_nextSibling; }
+    // The object drawn by this node, nullptr for group nodes
+    Object* GetObject() const { return m_object; }
+    // Returns the storage this node lives in
+    SceneGraph* GetScene() const { return m_scene; }
+    // Index of this node in its SceneGraph (kept up to date by the graph)
+    int GetSceneIndex() const { return m_sceneIndex; }
+    void SetSceneIndex(int index) { m_sceneIndex = index; }
+    // Instance of the Renderer's GpuCulling that draws this node, -1 when
+    // the node is drawn through the RenderQueue (see Renderer::AddGpuCulledNodes)
+    int GetGpuInstance() const { return m_gpuInstance; }
+    void SetGpuInstance(int instance) { m_gpuInstance = instance; }
     // one shader per Node
     Shader m_shader;
+    // Instanced variant of m_shader, no program unless EnableInstancing was called
+    Shader m_instancedShader;
+    // Indirect variant of m_shader, no program unless EnableIndirect was called
+    Shader m_indirectShader;
     
 protected:
     // Parent
     SceneNode* m_parent;
-    // Children holds all a pointer to all of the descendents of a particular SceneNode
-    std::vector<SceneNode*> m_children;
+    // Children, in the order they were added: the first one, the last one
+    // (to append), and each child's next sibling
+    SceneNode* m_firstChild{nullptr};
+    SceneNode* m_lastChild{nullptr};
+    SceneNode* m_nextSibling{nullptr};
     // The object stored in the scene graph
     Object* m_object;
-    // Each SceneNode nodes locals transform
-    Transform m_localTransform;
-    // store the world transform
-    Transform m_worldTransform;
+    // Storage of the transforms, and where this node is in it
+    SceneGraph* m_scene;
+    int m_sceneIndex;
+    // Whether culling was allowed, see SetCullable
+    bool m_cullable{true};
+    // See GetGpuInstance
+    int m_gpuInstance{-1};
+    // Fragment shader of m_shader, reused by the instanced variant
+    std::string m_fragShaderPath;
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define SHADER_HPP
 
 #include <string>
+#include <map>
 
 #if defined(LINUX) || defined(MINGW)
     #include <SDL2/SDL.h>
@@ -25,11 +26,17 @@ public:
     std::string LoadShader(const std::string& fname);
     // Create a Shader from a loaded vertex and fragment shader
     void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    // Create a Shader from vertex and fragment shader files. Shaders created
+    // from the same files share one program, so their draws can be batched.
+    void CreateShaderFromFiles(const std::string& vertexPath, const std::string& fragmentPath);
+    // Create a Shader from a loaded compute shader (requires OpenGL 4.3)
+    void CreateComputeShader(const std::string& computeShaderSource);
     // return the shader id
     GLuint GetID() const;
     // Set our uniforms for our shader.
     void SetUniformMatrix4fv(const GLchar* name, const GLfloat* value);
     void SetUniform4f(const GLchar* name, float v0, float v1, float v2, float v3);
+    void SetUniform4fv(const GLchar* name, GLsizei count, const GLfloat* value);
 	void SetUniform3f(const GLchar* name, float v0, float v1, float v2);
     void SetUniform1i(const GLchar* name, int value);
     void SetUniform1f(const GLchar* name, float value);
@@ -45,7 +52,16 @@ private:
     // Logs an error message 
     void Log(const char* system, const char* message);
     // The unique shaderID
-    GLuint m_shaderID;
+    GLuint m_shaderID{0};
+    // Key of the shared program in s_programs, empty if the program is owned
+    std::string m_programKey;
+
+    // A program shared by the Shaders created from the same files
+    struct SharedProgram{
+        GLuint id;
+        int users;
+    };
+    static std::map<std::string, SharedProgram> s_programs;
 };
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef SIMULATIONTHREAD_HPP
+#define SIMULATIONTHREAD_HPP
+
+// SimulationThread runs Renderer::Update on a thread of its own, so the
+// update of the next frame overlaps with the GL thread rendering the
+// current one. The frame loop calls Kick, renders, then Wait and
+// Renderer::SwapSnapshots: a frame then costs about max(update, render)
+// instead of their sum, at the price of showing the scene one frame later.
+// Between Wait and the next Kick the thread is idle, which is when the
+// GL thread may change the scene and the camera (input, new nodes).
+// Without Start, Kick runs the update on the calling thread.
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Renderer;
+
+class SimulationThread{
+public:
+    // Constructor, no thread runs before Start
+    SimulationThread(Renderer* renderer);
+    // Destructor: waits for a running update and joins the thread
+    ~SimulationThread();
+
+    // Starts the thread
+    void Start();
+    // True once Start was called
+    bool IsRunning() const { return m_thread.joinable(); }
+    // Starts the next Renderer::Update and returns at once (or after the
+    // update, when the thread was not started)
+    void Kick();
+    // Waits for the update started by Kick
+    void Wait();
+
+private:
+    // Loop of the thread: waits for a Kick, updates, reports back
+    void ThreadLoop();
+
+    Renderer* m_renderer;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_kicked;
+    std::condition_variable m_done;
+    // An update was kicked and has not finished
+    bool m_pending{false};
+    bool m_stopping{false};
+};
+
+#endif
@@ -3,6 +3,14 @@
 
 #include "SceneNode.hpp"
 #include "Object.hpp"
+#include "AuroraCompute.hpp"
+#include "RenderTarget.hpp"
+
+// Which pipeline evaluates the aurora
+enum class AuroraPath {
+    Fragment, // skybox_frag.glsl evaluates the aurora per fragment
+    Compute   // aurora_comp.glsl writes a sky image that is composited
+};
 
 // SkyboxNode class inherits from SceneNode to represent a skybox in the scene graph.
 class SkyboxNode : public SceneNode {
@@ -16,16 +24,47 @@ public:
     // @param skyboxObject: A pointer to the Object representing the skybox.
     void Init(Object* skyboxObject);
 
+    // Selects how the aurora is evaluated.
+    // Falls back to the fragment path if compute shaders are unavailable.
+    // @param path: The pipeline to use
+    void SetAuroraPath(AuroraPath path);
+    // Returns the pipeline currently in use
+    AuroraPath GetAuroraPath() const { return m_auroraPath; }
+
     // Updates the SkyboxNode.
-    // This method is called every frame to update the skybox's state.
+    // This method is called every frame, as the root, to capture the sky's
+    // inputs (time, resolution, mouse, quality) into the snapshot. No GL
+    // calls.
     // @param projectionMatrix: The projection matrix for rendering.
     // @param camera: A pointer to the Camera used for view calculations.
     // @param renderer: A pointer to the Renderer for rendering operations.
-    void Update(glm::mat4 projectionMatrix, Camera* camera, Renderer* renderer) override;
+    // @param snapshot: The frame being simulated.
+    void Update(const glm::mat4& projectionMatrix, Camera* camera, Renderer* renderer, FrameSnapshot& snapshot) override;
+
+    // Takes the snapshot's sky inputs and records the sky as a custom
+    // background packet
+    void Submit(CommandList& list, const glm::mat4& world, const FrameSnapshot& snapshot) override;
+    // Draws the sky with the selected aurora pipeline, on the GL thread
+    void DrawCustom() override;
+
+private:
+    // Binds shader and sets its matrices, and the fragment path's uniforms
+    void BindSkyShader(Shader& shader);
+    // Fragment path: draws the sky into m_skyTarget and scales it up to the
+    // framebuffer that was bound, when rendering below full resolution
+    void DrawScaled();
 
-    // Draws the SkyboxNode.
-    // This method is called every frame to render the skybox.
-    void Draw() override;
+    // Pipeline evaluating the aurora
+    AuroraPath m_auroraPath{AuroraPath::Fragment};
+    // Compute path: writes the sky image
+    AuroraCompute m_auroraCompute;
+    // Compute path: draws the skybox sampling the sky image
+    Shader m_compositeShader;
+    // Inputs of the frame being drawn, taken from its snapshot in Submit
+    SkyFrame m_sky;
+    glm::mat4 m_projectionMatrix{1.0f};
+    // Fragment path: reduced resolution sky when m_sky.resolutionScale < 1
+    RenderTarget m_skyTarget;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,54 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+// SpscQueue is a bounded lock-free queue for one producer thread and one
+// consumer thread. It is a ring of Capacity slots (a power of two) with a
+// head the consumer advances and a tail the producer advances. Each index
+// is written by one side only, so a push or a pop is a load, a copy and
+// a release store, and neither side ever waits for the other. Head and
+// tail sit on separate cache lines so the two threads do not contend.
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class SpscQueue{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0) {}
+
+    // Producer: adds an item. False (and nothing added) if the queue is full.
+    bool Push(const T& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_slots[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: takes the oldest item. False if the queue is empty.
+    bool Pop(T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_slots[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Items queued, exact only when called by one of the two sides
+    size_t GetSize() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+private:
+    static const size_t s_cacheLine = 64;
+
+    alignas(s_cacheLine) std::atomic<size_t> m_head;
+    alignas(s_cacheLine) std::atomic<size_t> m_tail;
+    alignas(s_cacheLine) T m_slots[Capacity];
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef STRESSSCENE_HPP
+#define STRESSSCENE_HPP
+
+// StressScene builds synthetic scenes to find where the engine stops
+// scaling. It generates a tree breadth first, with a given number of
+// children per node, until the node count or the depth is reached.
+// Every node draws one of the meshes in the mix, and a share of the nodes
+// is dynamic: they turn every simulation step, so their subtrees'
+// world transforms and bounds are recomputed each frame.
+// The meshes are loaded once and shared by the nodes. They, and the nodes
+// unless Clear deletes them, live as long as the program, like the
+// skybox's object, because deleting them needs the GL context.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "SceneNode.hpp"
+#include "Object.hpp"
+
+struct StressSceneSettings{
+    // Nodes generated, the tree stops growing when it has this many
+    size_t nodeCount{10000};
+    // Children per node
+    int branching{8};
+    // Levels including the root, 0 for as many as the node count needs
+    int depth{0};
+    // OBJ files the nodes cycle through
+    std::vector<std::string> meshes{"common/objects/cube.obj"};
+    // Share of the nodes that move, 0 to 1
+    float dynamicRatio{0.1f};
+    // Share of the nodes rasterized into the occlusion buffer, 0 to 1
+    float occluderRatio{0.0f};
+    // Distance between a node and its children at the deepest level,
+    // doubling with every level above
+    float spacing{3.0f};
+    // Seed picking the dynamic nodes, so runs are repeatable
+    unsigned int seed{1};
+    // Cull the scene through an octree (SceneGraph::EnableSpatialIndex)
+    // instead of walking its hierarchy
+    bool spatialIndex{false};
+};
+
+class StressScene{
+public:
+    // Constructor
+    StressScene();
+
+    // Generates a scene in the default SceneGraph. The root is returned
+    // unattached, to be added to a node or given to Renderer::setRoot.
+    // Replaces the scene generated before. Needs the GL context.
+    // @return nullptr if no mesh of the mix could be loaded
+    SceneNode* Generate(const StressSceneSettings& settings);
+    // Turns the dynamic nodes by one simulation step
+    void Update(double stepSeconds);
+    // Deletes the generated nodes. Only for a root not added to another
+    // node (see Renderer::setRoot), SceneNode has no way to detach it.
+    void Clear();
+
+    SceneNode* GetRoot() const { return m_root; }
+    size_t GetNodeCount() const { return m_nodeCount; }
+    size_t GetDynamicCount() const { return m_dynamic.size(); }
+    size_t GetOccluderCount() const { return m_occluderCount; }
+    int GetDepth() const { return m_depth; }
+
+    // Resident memory of the process in bytes, 0 where it is unknown
+    static size_t GetResidentBytes();
+
+private:
+    // Loaded once per file, nullptr if the file is missing
+    Object* GetMesh(const std::string& filepath);
+
+    std::vector<std::pair<std::string, Object*>> m_meshes;
+    SceneNode* m_root;
+    std::vector<SceneNode*> m_dynamic;
+    size_t m_nodeCount;
+    size_t m_occluderCount;
+    int m_depth;
+};
+
+#endif
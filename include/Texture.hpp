@@ -16,14 +16,16 @@ public:
     void LoadTexture(const std::string filepath);
     void Bind(unsigned int slot=0) const;
     void Unbind();
+    // The GL texture name, 0 until a texture was loaded
+    GLuint GetID() const { return m_textureID; }
     bool LoadPPM(const std::string& filepath);
 private:
     // Store a unique ID for the texture
-    GLuint m_textureID;
+    GLuint m_textureID{0};
 	// Filepath to the image loaded
     std::string m_filepath;
     // Store image data inside texture class
-    Image* m_image;
+    Image* m_image{nullptr};
 };
 
 
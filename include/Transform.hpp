@@ -29,6 +29,15 @@ public:
     void ApplyTransform(Transform t);
     // Returns the transformation matrix
     glm::mat4 GetInternalMatrix() const;
+    // Returns the transformation matrix without copying it
+    const glm::mat4& GetMatrix() const { return m_modelTransformMatrix; }
+    // Sets the transformation matrix
+    void SetMatrix(const glm::mat4& m) { m_modelTransformMatrix = m; MarkDirty(); }
+    // True if the matrix changed since ClearDirty was last called.
+    // Writes through GetTransformMatrix's pointer are not tracked.
+    bool IsDirty() const { return m_dirty; }
+    // Marks the current matrix as seen
+    void ClearDirty() { m_dirty = false; }
 
     // Transform multiplicaiton
 	Transform& operator*=(const Transform& t);
@@ -42,8 +51,15 @@ public:
     friend Transform operator+(const Transform& lhs, const Transform& rhs);
 
 private:
+    // Flags this transform as modified
+    void MarkDirty() { m_dirty = true; }
+    // The scene graph writes world matrices without marking them dirty
+    friend class SceneGraph;
+
     // Stores the actual transformation matrix
     glm::mat4 m_modelTransformMatrix;
+    // Set by every modification, cleared by whoever consumes it
+    bool m_dirty{true};
 };
 
 
@@ -16,6 +16,8 @@ public:
     void Bind();
     // Unbind our buffers
     void Unbind();
+    // The vertex array object, for callers that bind it themselves
+    GLuint GetVertexArray() const { return m_VAOId; }
 
     // Creates a vertex and index buffer object
     // Format is: x,y,z
@@ -0,0 +1,204 @@
+#version 430 core
+
+// Compute variant of skybox_frag.glsl.
+// Each workgroup shades a 16x16 tile of the sky image. Everything that does
+// not depend on the pixel (the per-step color ramp, heights and weights, and
+// the time and mouse rotations) is computed once per workgroup into shared
+// memory instead of once per pixel.
+layout(local_size_x = 16, local_size_y = 16) in;
+
+// Output sky image, sampled later by skybox_composite_frag.glsl
+layout(rgba16f, binding = 0) uniform writeonly image2D u_AuroraImage;
+
+// Uniforms
+uniform vec3 iResolution;  // Viewport resolution (pixels)
+uniform float iTime;       // Shader playback time (seconds)
+uniform vec4 iMouse;       // Mouse coordinates
+uniform int u_AuroraSteps; // Ray steps of the aurora (quality tier), at most 50
+
+#define time iTime
+#define AURORA_MAX_STEPS 50
+
+// Per-workgroup tables, filled cooperatively before shading
+shared vec3 s_stepColor[AURORA_MAX_STEPS];  // color ramp along the ray
+shared float s_stepHeight[AURORA_MAX_STEPS]; // height of each sample layer
+shared float s_stepWeight[AURORA_MAX_STEPS]; // exponential decay and fade in
+shared float s_stepJitter[AURORA_MAX_STEPS]; // how much dithering each step gets
+shared mat2 s_noiseRotation;             // mm2(time * spd) used by triNoise2d
+shared mat2 s_pitch;                     // mouse rotation around x
+shared mat2 s_yaw;                       // mouse and time rotation around y
+
+// Creates a 2x2 rotation matrix for rotating vectors
+// in 2D space by angle a.
+mat2 mm2(in float a) {
+    float c = cos(a), s = sin(a);
+    return mat2(c, s, -s, c);
+}
+
+// A fixed rotation matrix for an angle of approximately 17 degrees
+const mat2 m2 = mat2(0.95534, 0.29552, -0.29552, 0.95534);
+
+// Generates a triangle wave pattern between 0.01 and 0.49.
+float tri(in float x) {
+    return clamp(abs(fract(x) - .5), 0.01, 0.49);
+}
+
+// Combines triangle waves in
+// both x and y directions to produce a 2D pattern.
+vec2 tri2(in vec2 p) {
+    return vec2(tri(p.x) + tri(p.y), tri(p.y + tri(p.x)));
+}
+
+// Same as triNoise2d in skybox_frag.glsl, with the time rotation
+// read from shared memory.
+float triNoise2d(in vec2 p) {
+    float z = 1.8; // amplitude
+    float z2 = 2.5; // frequency
+    float rz = 0.; // accumulatedNoise
+    p *= mm2(p.x * 0.06);
+    vec2 bp = p;
+    for (float i = 0.; i < 5.; i++) {
+        vec2 dg = tri2(bp * 1.85) * .75; // displacement
+        dg *= s_noiseRotation;
+        p -= dg / z2; // displacement / frequency
+
+        bp *= 1.3; // basePoint
+        z2 *= .45; // frequency
+        z *= .42; // amplitude
+        p *= 1.21 + (rz - 1.0) * .02;
+
+        rz += tri(p.x + tri(p.y)) * z;
+        p *= -m2;
+    }
+    return clamp(1. / pow(rz * 29., 1.3), 0., .55);
+}
+
+// Generates a pseudo-random value based on a 2D vector n
+float hash21(in vec2 n) {
+    return fract(sin(dot(n, vec2(12.9898, 4.1414))) * 43758.5453);
+}
+
+// ray origin, ray direction, frag coordinate
+vec4 aurora(vec3 ro, vec3 rd, vec2 fragCoord) {
+    vec4 col = vec4(0); // accumulatedColor
+    vec4 avgCol = vec4(0); // averageColor
+
+    // Terms that are constant along the ray
+    float jitter = 0.006 * hash21(fragCoord.xy);
+    float rayScale = 1. / (rd.y * 2. + 0.4);
+
+    int steps = min(u_AuroraSteps, AURORA_MAX_STEPS);
+    for (int i = 0; i < steps; i++) {
+        // Parameter along the ray where sampling occurs
+        float pt = (s_stepHeight[i] - ro.y) * rayScale - jitter * s_stepJitter[i];
+        // Position along the ray
+        vec3 bpos = ro + pt * rd;
+        // Compute noise value
+        float rzt = triNoise2d(bpos.zx);
+        // Color modulation to simulate aurora's color variation
+        vec4 col2 = vec4(s_stepColor[i] * rzt, rzt);
+        // Averaging colors
+        avgCol = mix(avgCol, col2, .5);
+        // Accumulate color with exponential decay
+        col += avgCol * s_stepWeight[i];
+    }
+
+    // Adjust brightness based on ray direction
+    col *= (clamp(rd.y * 15. + .4, 0., 1.));
+
+    return col * 1.8;
+}
+
+// Generates a pseudo-random 3D vector based on input q
+vec3 nmzHash33(vec3 q) {
+    uvec3 p = uvec3(ivec3(q));
+    p = p * uvec3(374761393U, 1103515245U, 668265263U) + p.zxy + p.yzx;
+    p = p.yzx * (p.zxy ^ (p >> 3U));
+    return vec3(p ^ (p >> 16U)) * (1.0 / vec3(0xffffffffU));
+}
+
+// Bright points in the sky with slight variations in color and brightness
+vec3 stars(in vec3 p) {
+    vec3 c = vec3(0.);
+    float res = iResolution.x * 1.;
+
+    for (float i = 0.; i < 4.; i++) {
+        vec3 q = fract(p * (.15 * res)) - 0.5;
+        vec3 id = floor(p * (.15 * res));
+        vec2 rn = nmzHash33(id).xy;
+        float c2 = 1. - smoothstep(0., .6, length(q));
+        c2 *= step(rn.x, .0005 + i * i * 0.001);
+        c += c2 * (mix(vec3(1.0, 0.49, 0.1), vec3(0.75, 0.9, 1.), rn.y) * 0.1 + 0.9);
+        p *= 1.3;
+    }
+    return c * c * .8;
+}
+
+// Background gradient of the sky
+vec3 bg(in vec3 rd) {
+    float sd = dot(normalize(vec3(-0.5, -0.6, 0.9)), rd) * 0.5 + 0.5;
+    sd = pow(sd, 5.);
+    vec3 col = mix(vec3(0.05, 0.1, 0.2), vec3(0.1, 0.05, 0.2), sd);
+    return col * .63;
+}
+
+void main() {
+    // Fill the shared tables, one step per invocation. As in the fragment
+    // path, fewer steps are spread over the same range and weighted up.
+    uint lid = gl_LocalInvocationIndex;
+    int steps = min(u_AuroraSteps, AURORA_MAX_STEPS);
+    float stepScale = float(AURORA_MAX_STEPS) / float(steps);
+    if (lid < uint(steps)) {
+        float i = float(lid) * stepScale;
+        s_stepColor[lid] = sin(1. - vec3(2.15, -.5, 1.2) + i * 0.043) * 0.5 + 0.5;
+        s_stepHeight[lid] = .8 + pow(i, 1.4) * .002;
+        s_stepWeight[lid] = exp2(-i * 0.065 - 2.5) * smoothstep(0., 5., i) * stepScale;
+        s_stepJitter[lid] = smoothstep(0., 15., i);
+    }
+    if (lid == 0u) {
+        s_noiseRotation = mm2(time * 0.06);
+
+        // Mouse interaction
+        vec2 mo = iMouse.xy / iResolution.xy - 0.5;
+        mo = (mo == vec2(-0.5)) ? vec2(-0.1, 0.1) : mo;
+        mo.x *= iResolution.x / iResolution.y;
+        s_pitch = mm2(mo.y);
+        s_yaw = mm2(mo.x + sin(time * 0.05) * 0.2);
+    }
+    memoryBarrierShared();
+    barrier();
+
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(u_AuroraImage);
+    if (pixel.x >= size.x || pixel.y >= size.y) {
+        return;
+    }
+
+    // The image spans the sphere's texture coordinates, so this matches
+    // fragCoord = TexCoords * iResolution.xy in the fragment path.
+    vec2 fragCoord = (vec2(pixel) + 0.5) / vec2(size) * iResolution.xy;
+
+    vec2 q = fragCoord.xy / iResolution.xy;
+    vec2 p = q - 0.5;
+    p.x *= iResolution.x / iResolution.y;
+
+    // Camera setup
+    vec3 ro = vec3(0, 0, -6.7);
+    vec3 rd = normalize(vec3(p, 1.3));
+    rd.yz *= s_pitch;
+    rd.xz *= s_yaw;
+
+    // Fade effect based on ray direction
+    float fade = smoothstep(0.0, 0.01, abs(rd.y)) * 0.1 + 0.9;
+
+    // Background color
+    vec3 col = bg(rd) * fade;
+
+    if (rd.y > 0.0) {
+        vec4 aur = smoothstep(0.0, 1.5, aurora(ro, rd, fragCoord)) * fade;
+        col += stars(rd);
+        col = col * (1.0 - aur.a) + aur.rgb;
+    }
+
+    imageStore(u_AuroraImage, pixel, vec4(col, 1.0));
+}
@@ -0,0 +1,118 @@
+#version 430 core
+
+// GPU culling of GpuCulling's instances, one invocation per instance.
+// An instance is kept if its world bounds intersect the view frustum and
+// are not behind the depth pyramid of the previous frame. Kept instances
+// are appended to their mesh's slice of the visible list, counted by an
+// atomic add on the instanceCount of the mesh's indirect draw command.
+layout(local_size_x = 64) in;
+
+struct Instance {
+    vec4 boundsMin;
+    vec4 boundsMax;
+    uint mesh;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+layout(std430, binding = 2) buffer Commands {
+    DrawCommand commands[];
+};
+layout(std430, binding = 3) writeonly buffer Visible {
+    uint visible[];
+};
+
+uniform vec4 u_FrustumPlanes[6];
+uniform int u_InstanceCount;
+// Max-depth pyramid of the previous frame, and the matrix it was rendered with
+uniform sampler2D u_DepthPyramid;
+uniform mat4 u_PyramidViewProjection;
+uniform int u_HasDepthPyramid;
+uniform int u_PyramidLevels;
+
+// False if the box is completely outside of one plane
+bool InsideFrustum(vec3 boundsMin, vec3 boundsMax)
+{
+    for (int i = 0; i < 6; ++i) {
+        vec4 plane = u_FrustumPlanes[i];
+        // Corner farthest along the plane normal
+        vec3 corner = mix(boundsMin, boundsMax, greaterThanEqual(plane.xyz, vec3(0.0)));
+        if (dot(plane.xyz, corner) + plane.w < 0.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// True if the box is certainly behind the previous frame's depth
+bool Occluded(vec3 boundsMin, vec3 boundsMax)
+{
+    vec2 screenMin = vec2(1.0);
+    vec2 screenMax = vec2(0.0);
+    float nearestDepth = 1.0;
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = vec3((i & 1) != 0 ? boundsMax.x : boundsMin.x,
+                           (i & 2) != 0 ? boundsMax.y : boundsMin.y,
+                           (i & 4) != 0 ? boundsMax.z : boundsMin.z);
+        vec4 clip = u_PyramidViewProjection * vec4(corner, 1.0);
+        // Crossing the near plane: nothing to compare against
+        if (clip.w <= 0.0) {
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 uv = ndc.xy * 0.5 + 0.5;
+        screenMin = min(screenMin, uv);
+        screenMax = max(screenMax, uv);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+    }
+    screenMin = clamp(screenMin, vec2(0.0), vec2(1.0));
+    screenMax = clamp(screenMax, vec2(0.0), vec2(1.0));
+
+    // Level where the rectangle spans at most 2x2 texels
+    vec2 size = vec2(textureSize(u_DepthPyramid, 0));
+    vec2 extent = (screenMax - screenMin) * size;
+    int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+    level = clamp(level, 0, u_PyramidLevels - 1);
+
+    ivec2 levelSize = textureSize(u_DepthPyramid, level);
+    ivec2 first = clamp(ivec2(screenMin * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+    ivec2 last = clamp(ivec2(screenMax * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; ++y) {
+        for (int x = first.x; x <= last.x; ++x) {
+            farthest = max(farthest, texelFetch(u_DepthPyramid, ivec2(x, y), level).r);
+        }
+    }
+    return nearestDepth > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(u_InstanceCount)) {
+        return;
+    }
+
+    Instance instance = instances[index];
+    if (!InsideFrustum(instance.boundsMin.xyz, instance.boundsMax.xyz)) {
+        return;
+    }
+    if (u_HasDepthPyramid != 0 && Occluded(instance.boundsMin.xyz, instance.boundsMax.xyz)) {
+        return;
+    }
+
+    uint slot = atomicAdd(commands[instance.mesh].instanceCount, 1u);
+    visible[commands[instance.mesh].baseInstance + slot] = index;
+}
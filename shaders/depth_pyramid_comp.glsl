@@ -0,0 +1,50 @@
+#version 430 core
+
+// Builds one level of the max-depth pyramid GpuCulling tests against.
+// Level 0 copies the depth buffer, every next level keeps the farthest
+// depth of the texels it covers in the level above. When the level above
+// has an odd width or height, the last texel of a row or column also
+// covers the extra texel, so nothing is dropped.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Depth texture for level 0, the pyramid itself for the others
+uniform sampler2D u_Source;
+uniform int u_SourceLevel;
+// 0: copy u_Source, 1: reduce it
+uniform int u_Reduce;
+
+layout(r32f, binding = 0) uniform writeonly image2D u_Destination;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(u_Destination);
+    if (texel.x >= size.x || texel.y >= size.y) {
+        return;
+    }
+
+    if (u_Reduce == 0) {
+        imageStore(u_Destination, texel, vec4(texelFetch(u_Source, texel, 0).r));
+        return;
+    }
+
+    ivec2 sourceSize = textureSize(u_Source, u_SourceLevel);
+    ivec2 first = texel * 2;
+    // Take the extra row or column at odd edges
+    ivec2 last = first + ivec2(1);
+    if (texel.x == size.x - 1 && (sourceSize.x & 1) == 1) {
+        last.x = sourceSize.x - 1;
+    }
+    if (texel.y == size.y - 1 && (sourceSize.y & 1) == 1) {
+        last.y = sourceSize.y - 1;
+    }
+    last = min(last, sourceSize - ivec2(1));
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; ++y) {
+        for (int x = first.x; x <= last.x; ++x) {
+            depth = max(depth, texelFetch(u_Source, ivec2(x, y), u_SourceLevel).r);
+        }
+    }
+    imageStore(u_Destination, texel, vec4(depth));
+}
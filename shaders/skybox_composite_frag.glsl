@@ -0,0 +1,19 @@
+#version 410 core
+
+// Composites the sky image produced by aurora_comp.glsl onto the skybox
+
+// Uniforms
+uniform sampler2D u_AuroraImage; // Sky image written by the compute pass
+
+// Inputs from vertex shader
+in vec3 fragColor;
+in vec3 fragPos;
+in vec2 TexCoords;
+
+// Output color
+out vec4 FragColor;
+
+void main() {
+    // The sky image is laid out in the sphere's texture coordinates
+    FragColor = vec4(texture(u_AuroraImage, TexCoords).rgb, 1.0);
+}
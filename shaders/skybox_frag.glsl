@@ -4,6 +4,7 @@
 uniform vec3 iResolution;  // Viewport resolution (pixels)
 uniform float iTime;       // Shader playback time (seconds)
 uniform vec4 iMouse;       // Mouse coordinates
+uniform int u_AuroraSteps; // Ray steps of the aurora (quality tier), at most 50
 
 // Inputs from vertex shader
 in vec3 fragColor;
@@ -73,8 +74,13 @@ vec4 aurora(vec3 ro, vec3 rd, vec2 fragCoord) {
     vec4 col = vec4(0); // accumulatedColor
     vec4 avgCol = vec4(0); // averageColor
 
+    // Steps are spread over the same range whatever their count, and
+    // weighted up accordingly, so lower quality tiers keep the same shape
+    float stepScale = 50. / float(u_AuroraSteps);
+
     // Loop to simulate integration along the ray
-    for (float i = 0.; i < 50.; i++) {
+    for (float j = 0.; j < float(u_AuroraSteps); j++) {
+        float i = j * stepScale;
         // Offset for randomness
         float of = 0.006 * hash21(fragCoord.xy) * smoothstep(0., 15., i);
         // Parameter along the ray where sampling occurs
@@ -93,7 +99,7 @@ vec4 aurora(vec3 ro, vec3 rd, vec2 fragCoord) {
         // Averaging colors
         avgCol = mix(avgCol, col2, .5);
         // Accumulate color with exponential decay
-        col += avgCol * exp2(-i * 0.065 - 2.5) * smoothstep(0., 5., i);
+        col += avgCol * exp2(-i * 0.065 - 2.5) * smoothstep(0., 5., i) * stepScale;
     }
 
     // Adjust brightness based on ray direction
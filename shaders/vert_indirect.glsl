@@ -0,0 +1,37 @@
+#version 430 core
+// Variant of vert.glsl for meshes in a MeshPool drawn with
+// glMultiDrawElementsIndirect: the model matrix is read from a storage
+// buffer, at the draw index the RenderQueue feeds through attribute 4
+// (baseInstance of the command + instance).
+// Attribute locations follow the Object vertex layout
+// (position, color, normal, texcoord).
+layout(location=0)in vec3 position;
+layout(location=2)in vec3 normals; // normals
+layout(location=3)in vec2 texCoord; // texture coordinates
+layout(location=4)in uint drawIndex; // index of the world matrix
+
+layout(std430, binding=0) readonly buffer Transforms {
+    mat4 models[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 myNormal;
+out vec3 FragPos;
+out vec2 v_texCoord;
+
+
+void main()
+{
+    mat4 model = models[drawIndex];
+
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+
+    myNormal = normals;
+    // Transform normal into world space
+    FragPos = vec3(model * vec4(position,1.0f));
+
+    // Store the texture coordinates
+    v_texCoord = texCoord;
+}
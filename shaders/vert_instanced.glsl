@@ -0,0 +1,30 @@
+#version 330 core
+// Instanced variant of vert.glsl: the model matrix comes from a per-instance
+// attribute instead of a uniform, so one draw renders every copy of a mesh.
+// Attribute locations follow the Object vertex layout
+// (position, color, normal, texcoord), the instance matrix takes 4 to 7.
+layout(location=0)in vec3 position;
+layout(location=2)in vec3 normals; // normals
+layout(location=3)in vec2 texCoord; // texture coordinates
+layout(location=4)in mat4 instanceModel; // world matrix of the instance
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 myNormal;
+out vec3 FragPos;
+out vec2 v_texCoord;
+
+
+void main()
+{
+
+    gl_Position = projection * view * instanceModel * vec4(position, 1.0f);
+
+    myNormal = normals;
+    // Transform normal into world space
+    FragPos = vec3(instanceModel * vec4(position,1.0f));
+
+    // Store the texture coordinates
+    v_texCoord = texCoord;
+}
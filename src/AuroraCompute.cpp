@@ -0,0 +1,76 @@
+#include "AuroraCompute.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
+
+#include <iostream>
+
+// Constructor: GL resources are created in Init and Resize
+AuroraCompute::AuroraCompute() {}
+
+// Destructor: Deletes the sky image
+AuroraCompute::~AuroraCompute() {
+    if (m_imageID != 0) {
+        GLState::DeleteTextures(1, &m_imageID);
+    }
+}
+
+// Loads and compiles the compute shader
+// @param computeShader: Path to the compute shader file
+void AuroraCompute::Init(const std::string& computeShader) {
+    std::string source = m_computeShader.LoadShader(computeShader);
+    m_computeShader.CreateComputeShader(source);
+    m_initialized = true;
+    std::cout << "AuroraCompute Initialized" << std::endl;
+}
+
+// Allocates the sky image, only when the requested size changed
+// @param width, height: Size of the sky image in texels
+void AuroraCompute::Resize(int width, int height) {
+    if (width == m_width && height == m_height && m_imageID != 0) {
+        return;
+    }
+    // Immutable storage cannot be resized, so start from a new texture
+    if (m_imageID != 0) {
+        GLState::DeleteTextures(1, &m_imageID);
+    }
+    m_width = width;
+    m_height = height;
+
+    glGenTextures(1, &m_imageID);
+    GLState::BindTexture(GL_TEXTURE_2D, m_imageID);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, m_width, m_height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Runs the compute shader over the sky image, one workgroup per 16x16 tile
+// @param iTime: Elapsed time in seconds
+// @param resolutionX, resolutionY: Resolution the aurora is evaluated at
+// @param mouseX, mouseY: Mouse position in pixels
+// @param auroraSteps: Number of ray steps, at most 50
+void AuroraCompute::Dispatch(float iTime, float resolutionX, float resolutionY, float mouseX, float mouseY, int auroraSteps) {
+    m_computeShader.Bind();
+    m_computeShader.SetUniform1f("iTime", iTime);
+    m_computeShader.SetUniform3f("iResolution", resolutionX, resolutionY, 1.0f);
+    m_computeShader.SetUniform4f("iMouse", mouseX, mouseY, 0.0f, 0.0f);
+    m_computeShader.SetUniform1i("u_AuroraSteps", auroraSteps);
+
+    GLState::BindImageTexture(0, m_imageID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    GLuint groupsX = (m_width + s_tileSize - 1) / s_tileSize;
+    GLuint groupsY = (m_height + s_tileSize - 1) / s_tileSize;
+    glDispatchCompute(groupsX, groupsY, 1);
+
+    // Make the image writes visible to the texture fetches of the composite pass
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+// Binds the sky image to a texture slot
+// @param slot: Texture slot to bind to
+void AuroraCompute::BindImage(unsigned int slot) const {
+    GLState::ActiveTexture(GL_TEXTURE0 + slot);
+    GLState::BindTexture(GL_TEXTURE_2D, m_imageID);
+}
@@ -0,0 +1,185 @@
+#include "CameraPath.hpp"
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char s_magic[4] = {'A', 'C', 'P', 'T'};
+
+// Fields are written one at a time, so the file has no padding
+template <typename T>
+void Write(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool Read(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+}
+
+// Constructor
+CameraPath::CameraPath()
+    : m_simulationStep(1.0 / 60.0), m_recording(false), m_recordedFrames(0), m_startTime(0.0) {}
+
+// Destructor
+CameraPath::~CameraPath() {
+    EndRecording();
+}
+
+// Opens a file to record to and writes the header
+// @param filename: File to create
+// @param simulationStep: Length of a simulation step in seconds
+// @return false if the file could not be created
+bool CameraPath::BeginRecording(const std::string& filename, double simulationStep) {
+    EndRecording();
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        std::cout << "Could not create camera path " << filename << std::endl;
+        return false;
+    }
+    m_filename = filename;
+    m_simulationStep = simulationStep;
+    m_recording = true;
+    m_recordedFrames = 0;
+    m_startTime = FramePacer::Now();
+    m_pendingEvents.clear();
+
+    m_file.write(s_magic, sizeof(s_magic));
+    Write(m_file, static_cast<uint32_t>(s_version));
+    Write(m_file, m_simulationStep);
+    // Frame count, completed by EndRecording
+    Write(m_file, static_cast<uint32_t>(0));
+    return true;
+}
+
+// Adds an input event to the frame being recorded
+// @param event: The event as the input queue delivered it
+void CameraPath::RecordEvent(const InputEvent& event) {
+    if (m_recording) {
+        m_pendingEvents.push_back(event);
+    }
+}
+
+// Writes a frame with the events recorded since the last one
+// @param time: Simulation time the frame renders at
+// @param camera: The camera the frame renders with
+void CameraPath::RecordFrame(double time, const Camera& camera) {
+    if (!m_recording) {
+        return;
+    }
+    glm::vec3 eye = camera.GetPosition();
+    glm::vec3 direction = camera.GetViewDirection();
+    Write(m_file, time);
+    for (int i = 0; i < 3; ++i) {
+        Write(m_file, eye[i]);
+    }
+    for (int i = 0; i < 3; ++i) {
+        Write(m_file, direction[i]);
+    }
+    // A frame never holds more events than the input queue, far below this
+    uint16_t count = static_cast<uint16_t>(std::min<size_t>(m_pendingEvents.size(), UINT16_MAX));
+    Write(m_file, count);
+    for (uint16_t i = 0; i < count; ++i) {
+        const InputEvent& event = m_pendingEvents[i];
+        Write(m_file, static_cast<uint8_t>(event.type));
+        Write(m_file, static_cast<float>((event.time - m_startTime) * 1000.0));
+        Write(m_file, static_cast<int32_t>(event.x));
+        Write(m_file, static_cast<int32_t>(event.y));
+        Write(m_file, static_cast<int32_t>(event.key));
+    }
+    m_pendingEvents.clear();
+    ++m_recordedFrames;
+}
+
+// Completes the frame count in the header and closes the file
+void CameraPath::EndRecording() {
+    if (!m_recording) {
+        return;
+    }
+    m_file.seekp(sizeof(s_magic) + sizeof(uint32_t) + sizeof(double));
+    Write(m_file, static_cast<uint32_t>(m_recordedFrames));
+    m_file.close();
+    m_recording = false;
+    std::cout << "Recorded " << m_recordedFrames << " frames to " << m_filename << std::endl;
+}
+
+// Reads a recording
+// @param filename: File written by a recording
+// @return false if it is missing, of another version or cut short
+bool CameraPath::Load(const std::string& filename) {
+    m_frames.clear();
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cout << "Could not open camera path " << filename << std::endl;
+        return false;
+    }
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t frameCount = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, s_magic, sizeof(magic)) != 0 ||
+        !Read(file, version) || version != s_version ||
+        !Read(file, m_simulationStep) || !Read(file, frameCount) || m_simulationStep <= 0.0) {
+        std::cout << filename << " is not a camera path (version " << s_version << ")" << std::endl;
+        return false;
+    }
+
+    // Frames are read up to the end of the file: a recording that was not
+    // ended (the program was killed) still has 0 in the header
+    while (m_frames.size() < s_maxFrames) {
+        CameraPathFrame frame;
+        if (!Read(file, frame.time)) {
+            break;
+        }
+        uint16_t count = 0;
+        bool ok = true;
+        for (int i = 0; i < 3; ++i) {
+            ok = ok && Read(file, frame.eye[i]);
+        }
+        for (int i = 0; i < 3; ++i) {
+            ok = ok && Read(file, frame.direction[i]);
+        }
+        ok = ok && Read(file, count);
+        frame.events.resize(ok ? count : 0);
+        for (uint16_t i = 0; ok && i < count; ++i) {
+            uint8_t type = 0;
+            float timeMs = 0.0f;
+            int32_t x = 0, y = 0, key = 0;
+            ok = Read(file, type) && Read(file, timeMs) && Read(file, x) && Read(file, y) && Read(file, key);
+            InputEvent& event = frame.events[i];
+            event.type = static_cast<InputEventType>(type);
+            event.time = timeMs / 1000.0;
+            event.x = x;
+            event.y = y;
+            event.key = key;
+        }
+        if (!ok) {
+            std::cout << filename << " ends inside frame " << m_frames.size() << ", dropped it" << std::endl;
+            break;
+        }
+        m_frames.push_back(std::move(frame));
+    }
+    if (m_frames.size() == s_maxFrames) {
+        std::cout << filename << " has more than " << s_maxFrames << " frames, the rest is ignored" << std::endl;
+    }
+    if (frameCount != m_frames.size()) {
+        std::cout << filename << " header says " << frameCount << " frames, read " << m_frames.size()
+                  << (frameCount == 0 ? " (recording was not ended)" : "") << std::endl;
+    }
+    std::cout << "Loaded " << m_frames.size() << " frames from " << filename << std::endl;
+    return !m_frames.empty();
+}
+
+// Puts the camera where it was on a frame
+// @param index: The frame
+// @param camera: Camera to move
+void CameraPath::Apply(size_t index, Camera& camera) const {
+    const CameraPathFrame& frame = m_frames[index];
+    camera.SetCameraEyePosition(frame.eye.x, frame.eye.y, frame.eye.z);
+    camera.SetViewDirection(frame.direction);
+}
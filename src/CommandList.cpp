@@ -0,0 +1,95 @@
+#include "CommandList.hpp"
+
+// Constructor
+CommandList::CommandList()
+    : m_view(1.0f), m_farPlane(1.0f), m_indirectEnabled(false),
+      m_packets(ArenaAllocator<DrawPacket>(&FrameArena::GetFrame())) {}
+
+// Starts a new frame, with room for as many packets as the last one had
+// @param view: View matrix, used for the depth part of the keys
+// @param farPlane: Distance mapped to the largest depth key
+// @param indirectEnabled: Whether nodes may push indirect packets
+// @param arena: Where the packets are allocated
+void CommandList::Begin(const glm::mat4& view, float farPlane, bool indirectEnabled, FrameArena* arena) {
+    m_view = view;
+    m_farPlane = farPlane;
+    m_indirectEnabled = indirectEnabled;
+    size_t expected = m_packets.size();
+    m_packets = PacketArray(ArenaAllocator<DrawPacket>(arena));
+    m_packets.reserve(expected);
+}
+
+// Packs the sort key. Only the low bits of the GL names are kept: 14 for
+// the program, 16 for the texture and the vertex array. Names that agree
+// on those bits share a key range and their draws may sort interleaved,
+// which costs binds and splits batches. Draws stay correct, RenderQueue
+// compares the full names when it batches and binds. GL hands out small
+// consecutive names, so that takes over 16384 programs or 65536 textures.
+uint64_t CommandList::MakeKey(RenderPass pass, GLuint program, GLuint texture, GLuint vertexArray, float depth) {
+    uint64_t depthBits = (uint64_t)(glm::clamp(depth, 0.0f, 1.0f) * 65535.0f);
+    return ((uint64_t)(pass & 0x3) << 62) |
+           ((uint64_t)(program & 0x3FFF) << 48) |
+           ((uint64_t)(texture & 0xFFFF) << 32) |
+           ((uint64_t)(vertexArray & 0xFFFF) << 16) |
+           depthBits;
+}
+
+// Adds a draw
+// @param pass: Pass the draw belongs to
+// @param program, texture, vertexArray: GL state the draw needs
+// @param instancedProgram: Instanced variant of program, 0 if there is none
+// @param indexCount: Number of indices to draw
+// @param model: World matrix, must stay valid until RenderQueue::Execute
+void CommandList::Push(RenderPass pass, GLuint program, GLuint instancedProgram, GLuint texture, GLuint vertexArray, GLsizei indexCount, const glm::mat4& model) {
+    float viewDepth = -(m_view * model[3]).z;
+    DrawPacket packet;
+    packet.key = MakeKey(pass, program, texture, vertexArray, viewDepth / m_farPlane);
+    packet.program = program;
+    packet.instancedProgram = instancedProgram;
+    packet.texture = texture;
+    packet.vertexArray = vertexArray;
+    packet.indexCount = indexCount;
+    packet.indirect = false;
+    packet.firstIndex = 0;
+    packet.baseVertex = 0;
+    packet.model = &model;
+    packet.node = nullptr;
+    m_packets.push_back(packet);
+}
+
+// Adds a draw of a pooled mesh. All meshes of the pool share its vertex
+// array, so they sort next to each other for the same program and texture.
+// @param pass: Pass the draw belongs to
+// @param program: Program reading the world matrix from the storage buffer
+// @param texture: Diffuse texture
+// @param pool, mesh: The MeshPool and where the mesh is in it
+// @param model: World matrix, must stay valid until RenderQueue::Execute
+void CommandList::PushIndirect(RenderPass pass, GLuint program, GLuint texture, const MeshPool& pool, const MeshRange& mesh, const glm::mat4& model) {
+    Push(pass, program, 0, texture, pool.GetVertexArray(), (GLsizei)mesh.indexCount, model);
+    DrawPacket& packet = m_packets.back();
+    // Order by mesh instead of depth, so draws of a mesh become the
+    // instances of one command
+    packet.key = (packet.key & ~(uint64_t)0xFFFF) | (mesh.firstIndex & 0xFFFF);
+    packet.indirect = true;
+    packet.firstIndex = mesh.firstIndex;
+    packet.baseVertex = mesh.baseVertex;
+}
+
+// Adds a node that draws itself. Custom packets sort first in their pass.
+// @param pass: Pass the node belongs to
+// @param node: The node, its DrawCustom is called on Execute
+void CommandList::PushCustom(RenderPass pass, SceneNode* node) {
+    DrawPacket packet;
+    packet.key = MakeKey(pass, 0, 0, 0, 0.0f);
+    packet.program = 0;
+    packet.instancedProgram = 0;
+    packet.texture = 0;
+    packet.vertexArray = 0;
+    packet.indexCount = 0;
+    packet.indirect = false;
+    packet.firstIndex = 0;
+    packet.baseVertex = 0;
+    packet.model = nullptr;
+    packet.node = node;
+    m_packets.push_back(packet);
+}
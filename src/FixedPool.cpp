@@ -0,0 +1,109 @@
+#include "FixedPool.hpp"
+#include "FlightRecorder.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+// Constructor
+// @param blockSize: Bytes per block, rounded up to s_alignment
+// @param blocksPerChunk: Blocks added at once when the pool is full
+FixedPool::FixedPool(size_t blockSize, size_t blocksPerChunk)
+    : m_blockSize((blockSize + s_alignment - 1) / s_alignment * s_alignment),
+      m_blocksPerChunk(blocksPerChunk > 0 ? blocksPerChunk : 1), m_freeList(nullptr), m_live(0) {
+    if (m_blockSize < sizeof(FreeBlock)) {
+        m_blockSize = s_alignment;
+    }
+}
+
+// Destructor
+FixedPool::~FixedPool() {
+    for (char* chunk : m_chunks) {
+        std::free(chunk);
+    }
+}
+
+// Carves a new chunk into blocks and puts them on the free list, first
+// block first so that consecutive allocations are adjacent in memory
+void FixedPool::AddChunk() {
+    // malloc aligns for any fundamental type (16 bytes on 64 bit targets)
+    char* chunk = static_cast<char*>(std::malloc(m_blockSize * m_blocksPerChunk));
+    if (chunk == nullptr) {
+        throw std::bad_alloc();
+    }
+    m_chunks.push_back(chunk);
+    FlightRecorder::Count(FlightCounter::Allocations);
+    for (size_t i = m_blocksPerChunk; i-- > 0;) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * m_blockSize);
+        block->next = m_freeList;
+        m_freeList = block;
+    }
+}
+
+// Returns a free block
+void* FixedPool::Allocate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_freeList == nullptr) {
+        AddChunk();
+    }
+    FreeBlock* block = m_freeList;
+    m_freeList = block->next;
+    ++m_live;
+    return block;
+}
+
+// Returns a block to the pool
+// @param block: A block Allocate returned, or nullptr
+void FixedPool::Free(void* block) {
+    if (block == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(m_live > 0);
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = m_freeList;
+    m_freeList = freed;
+    --m_live;
+}
+
+// Returns the pool for blocks of size bytes
+// @param size: Bytes per block
+// @return nullptr if s_maxPools other sizes have a pool already
+FixedPool* FixedPool::ForSize(size_t size) {
+    // Never destroyed: nodes held by globals may be deleted during exit
+    static FixedPool* pools[s_maxPools] = {};
+    static std::mutex* poolsMutex = new std::mutex();
+
+    size_t blockSize = (size + s_alignment - 1) / s_alignment * s_alignment;
+    std::lock_guard<std::mutex> lock(*poolsMutex);
+    for (int i = 0; i < s_maxPools; ++i) {
+        if (pools[i] == nullptr) {
+            pools[i] = new FixedPool(blockSize);
+            return pools[i];
+        }
+        if (pools[i]->GetBlockSize() == blockSize) {
+            return pools[i];
+        }
+    }
+    return nullptr;
+}
+
+// Allocates a block from the pool of its size, or the general heap
+// @param size: Bytes needed
+void* FixedPool::AllocateSized(size_t size) {
+    FixedPool* pool = ForSize(size);
+    return (pool != nullptr) ? pool->Allocate() : ::operator new(size);
+}
+
+// Frees a block from AllocateSized. ForSize gives the same answer for a
+// size every time, so the block goes back where it came from.
+// @param block: The block, or nullptr
+// @param size: The size it was allocated with
+void FixedPool::FreeSized(void* block, size_t size) {
+    FixedPool* pool = ForSize(size);
+    if (pool != nullptr) {
+        pool->Free(block);
+    } else {
+        ::operator delete(block);
+    }
+}
@@ -0,0 +1,251 @@
+#include "FlightRecorder.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+std::atomic<bool> FlightRecorder::s_enabled(false);
+std::atomic<uint64_t> FlightRecorder::s_counters[(int)FlightCounter::Count];
+
+// The calling thread's ring, registered on first use
+static thread_local void* t_ring = nullptr;
+
+// Names of the counters in dumps, in FlightCounter order
+static const char* s_counterNames[(int)FlightCounter::Count] = { "uploadBytes", "shaderCompiles", "allocations" };
+// Name of the frame track's zones
+static const char* s_frameZone = "Frame";
+
+// Constructor
+FlightRecorder::FlightRecorder() {}
+
+// Returns the engine wide recorder
+FlightRecorder& FlightRecorder::Get() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+// Returns the calling thread's ring, creating it the first time. Rings are
+// never deleted, a dump may still read a finished thread's.
+FlightRecorder::Ring* FlightRecorder::GetRing() {
+    if (t_ring == nullptr) {
+        // Value initialized, the slots start zeroed
+        Ring* ring = new Ring();
+        FlightRecorder& recorder = Get();
+        std::lock_guard<std::mutex> lock(recorder.m_ringsMutex);
+        ring->id = (int)recorder.m_rings.size() + 1;
+        ring->name = "Thread " + std::to_string(ring->id);
+        recorder.m_rings.push_back(ring);
+        t_ring = ring;
+    }
+    return static_cast<Ring*>(t_ring);
+}
+
+// Names the calling thread's track in dumps
+// @param name: e.g. "GL thread" or "Worker 1"
+void FlightRecorder::SetThreadName(const std::string& name) {
+    Ring* ring = GetRing();
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    ring->name = name;
+}
+
+// Adds a zone to the calling thread's ring, overwriting the oldest
+// @param name: Zone name, a string literal
+// @param start, end: Times from Profiler::Now
+void FlightRecorder::Record(const char* name, int64_t start, int64_t end) {
+    Ring* ring = GetRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Slot& slot = ring->slots[head & (s_ringCapacity - 1)];
+    // A reader that sees the new fields also sees the head that made the
+    // slot's old zone stale (CollectZones)
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Starts recording
+// @param thresholdMs: Frame time that triggers a dump
+// @param windowSeconds: Time before the slow frame that is dumped
+// @param filePrefix: Dumps are written to <prefix>_<frame>.json
+void FlightRecorder::Enable(double thresholdMs, double windowSeconds, const std::string& filePrefix) {
+    m_thresholdMs = thresholdMs;
+    m_windowSeconds = windowSeconds;
+    m_filePrefix = filePrefix;
+    m_frameCount = 0;
+    m_lastFrameEnd = 0;
+    m_nextDumpAllowed = 0;
+    s_enabled.store(true, std::memory_order_relaxed);
+    std::cout << "FlightRecorder: dumping the last " << windowSeconds << " s to " << filePrefix
+              << "_<frame>.json on frames over " << thresholdMs << " ms" << std::endl;
+}
+
+// Stops recording, what the rings hold is kept
+void FlightRecorder::Disable() {
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+// Records the frame that just ended and dumps the window if it was slow
+// @return true if a dump was written
+bool FlightRecorder::EndFrame() {
+    if (!IsEnabled()) {
+        return false;
+    }
+    int64_t now = Profiler::Now();
+    if (m_lastFrameEnd == 0) {
+        m_lastFrameEnd = now;
+        return false;
+    }
+    FrameRecord& frame = m_frames[m_frameCount % s_frameCapacity];
+    frame.start = m_lastFrameEnd;
+    frame.end = now;
+    for (int i = 0; i < (int)FlightCounter::Count; ++i) {
+        frame.counters[i] = s_counters[i].load(std::memory_order_relaxed);
+    }
+    uint64_t frameNumber = m_frameCount++;
+    m_lastFrameEnd = now;
+
+    double frameMs = (frame.end - frame.start) / 1.0e6;
+    if (frameMs <= m_thresholdMs || m_frameCount <= s_armFrames || now < m_nextDumpAllowed) {
+        return false;
+    }
+    bool written = Dump(frame, frameNumber);
+    // The dump's own time is not the next frame's, and the frames right
+    // after a hitch are often slow too
+    m_lastFrameEnd = Profiler::Now();
+    m_nextDumpAllowed = m_lastFrameEnd + (int64_t)(m_windowSeconds * 1.0e9);
+    return written;
+}
+
+// Copies out the zones of every ring that end after a time. A zone its
+// thread overwrote while it was copied is left out.
+// @param since: Oldest end time kept
+// @param zones: Receives the zones
+void FlightRecorder::CollectZones(int64_t since, std::vector<Zone>& zones) {
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    for (Ring* ring : m_rings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = (head > s_ringCapacity) ? head - s_ringCapacity : 0;
+        size_t begin = zones.size();
+        for (uint64_t i = first; i < head; ++i) {
+            const Slot& slot = ring->slots[i & (s_ringCapacity - 1)];
+            Zone zone;
+            zone.name = slot.name.load(std::memory_order_relaxed);
+            zone.start = slot.start.load(std::memory_order_relaxed);
+            zone.end = slot.end.load(std::memory_order_relaxed);
+            zone.tid = ring->id;
+            zones.push_back(zone);
+        }
+        // Slots below the head seen now, less a ring, and the one being
+        // written, may hold newer zones than the ones read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = ring->head.load(std::memory_order_relaxed);
+        uint64_t valid = (after + 1 > s_ringCapacity) ? after + 1 - s_ringCapacity : 0;
+        size_t stale = (valid > first) ? (size_t)std::min<uint64_t>(valid - first, head - first) : 0;
+        zones.erase(zones.begin() + begin, zones.begin() + begin + stale);
+        // Older than the window
+        zones.erase(std::remove_if(zones.begin() + begin, zones.end(),
+                                   [since](const Zone& zone) { return zone.name == nullptr || zone.end < since; }),
+                    zones.end());
+    }
+}
+
+// Writes the window ending with a slow frame as Chrome trace-event JSON
+// @param slowFrame: The frame that triggered the dump
+// @param frameNumber: Its number since Enable
+// @return false if the file could not be written
+bool FlightRecorder::Dump(const FrameRecord& slowFrame, uint64_t frameNumber) {
+    int64_t windowStart = slowFrame.end - (int64_t)(m_windowSeconds * 1.0e9);
+    std::vector<Zone> zones;
+    CollectZones(windowStart, zones);
+
+    // What the slow frame spent its time on: its longest zones
+    std::vector<const Zone*> longest;
+    for (const Zone& zone : zones) {
+        if (zone.end > slowFrame.start && zone.start < slowFrame.end) {
+            longest.push_back(&zone);
+        }
+    }
+    size_t shown = std::min<size_t>(longest.size(), 3);
+    std::partial_sort(longest.begin(), longest.begin() + shown, longest.end(),
+                      [](const Zone* a, const Zone* b) { return a->end - a->start > b->end - b->start; });
+    const FrameRecord& previous = m_frames[(frameNumber + s_frameCapacity - 1) % s_frameCapacity];
+    std::ostringstream trigger;
+    trigger << "Frame " << frameNumber << " took " << (slowFrame.end - slowFrame.start) / 1.0e6
+            << " ms (threshold " << m_thresholdMs << " ms).";
+    if (shown > 0) {
+        trigger << " Longest zones:";
+        for (size_t i = 0; i < shown; ++i) {
+            trigger << (i > 0 ? "," : "") << " " << longest[i]->name << " " << (longest[i]->end - longest[i]->start) / 1.0e6 << " ms";
+        }
+        trigger << ".";
+    }
+    if (frameNumber > 0) {
+        trigger << " During the frame:";
+        for (int i = 0; i < (int)FlightCounter::Count; ++i) {
+            trigger << (i > 0 ? "," : "") << " " << s_counterNames[i] << " " << slowFrame.counters[i] - previous.counters[i];
+        }
+        trigger << ".";
+    }
+
+    std::string filename = m_filePrefix + "_" + std::to_string(frameNumber) + ".json";
+    std::ofstream file(filename);
+    if (!file) {
+        std::cout << "FlightRecorder: could not write " << filename << std::endl;
+        return false;
+    }
+    // The frame track comes first, counters are process wide tracks
+    const int frameTid = 0;
+    file << "{\"displayTimeUnit\": \"ms\", \"metadata\": {\"trigger\": \"" << trigger.str() << "\", \"thresholdMs\": "
+         << m_thresholdMs << ", \"windowSeconds\": " << m_windowSeconds << "}, \"traceEvents\": [\n"
+         << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"aurorascene\"}}";
+    file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << frameTid
+         << ", \"args\": {\"name\": \"Frames\"}}";
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        for (Ring* ring : m_rings) {
+            file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->id
+                 << ", \"args\": {\"name\": \"" << ring->name << "\"}}";
+            file << ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->id
+                 << ", \"args\": {\"sort_index\": " << ring->id << "}}";
+        }
+    }
+
+    // Frames of the window with their counters, oldest first
+    uint64_t framesKept = std::min<uint64_t>(frameNumber + 1, s_frameCapacity);
+    for (uint64_t f = frameNumber + 1 - framesKept; f <= frameNumber; ++f) {
+        const FrameRecord& frame = m_frames[f % s_frameCapacity];
+        if (frame.end < windowStart) {
+            continue;
+        }
+        Profiler::WriteTraceEvent(file, ProfileEvent{ s_frameZone, frame.start, frame.end }, frameTid, windowStart);
+        // Counters are per frame, the oldest frame kept has no total before it
+        if (f == frameNumber + 1 - framesKept) {
+            continue;
+        }
+        const FrameRecord& before = m_frames[(f - 1) % s_frameCapacity];
+        for (int i = 0; i < (int)FlightCounter::Count; ++i) {
+            char counter[160];
+            std::snprintf(counter, sizeof(counter),
+                          ",\n{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"value\": %llu}}",
+                          s_counterNames[i], (frame.start - windowStart) / 1000.0,
+                          (unsigned long long)(frame.counters[i] - before.counters[i]));
+            file << counter;
+        }
+    }
+    for (const Zone& zone : zones) {
+        Profiler::WriteTraceEvent(file, ProfileEvent{ zone.name, zone.start, zone.end }, zone.tid, windowStart);
+    }
+    // The trigger, at the end of the slow frame
+    char instant[96];
+    std::snprintf(instant, sizeof(instant), ",\n{\"name\": \"Trigger\", \"ph\": \"i\", \"s\": \"g\", \"ts\": %.3f, \"pid\": 1",
+                  (slowFrame.end - windowStart) / 1000.0);
+    file << instant << ", \"tid\": " << frameTid << ", \"args\": {\"description\": \"" << trigger.str() << "\"}}";
+    file << "\n]}" << std::endl;
+
+    std::cout << "FlightRecorder: " << trigger.str() << " Wrote " << zones.size() << " zones to " << filename << std::endl;
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,83 @@
+#include "FrameArena.hpp"
+#include "FlightRecorder.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Constructor
+// @param capacity: Bytes of the initial block
+FrameArena::FrameArena(size_t capacity)
+    : m_block(nullptr), m_capacity(capacity), m_offset(0), m_used(0) {
+    m_block = static_cast<char*>(std::malloc(m_capacity));
+    if (m_block == nullptr) {
+        m_capacity = 0;
+    }
+}
+
+// Destructor
+FrameArena::~FrameArena() {
+    Reset();
+    std::free(m_block);
+}
+
+// Returns the arena of the current frame
+FrameArena& FrameArena::GetFrame() {
+    static FrameArena frameArena;
+    return frameArena;
+}
+
+// Bumps the offset, or takes an overflow block when the block is full
+// @param size: Bytes needed
+// @param alignment: Power of two the address must be a multiple of
+// @return The memory, valid until the next Reset
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    if (size == 0) {
+        size = 1;
+    }
+    m_used.fetch_add(size, std::memory_order_relaxed);
+
+    // Claim [offset, offset + size + padding) with one atomic add, the
+    // padding covers the worst case alignment of the claimed offset
+    size_t claim = size + alignment - 1;
+    size_t offset = m_offset.fetch_add(claim, std::memory_order_relaxed);
+    if (offset + claim <= m_capacity) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(m_block + offset);
+        address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        return reinterpret_cast<void*>(address);
+    }
+
+    // Rare: the frame is larger than any before
+    char* block = static_cast<char*>(std::malloc(claim));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflow.push_back(block);
+    }
+    FlightRecorder::Count(FlightCounter::Allocations);
+    uintptr_t address = reinterpret_cast<uintptr_t>(block);
+    address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    return reinterpret_cast<void*>(address);
+}
+
+// Releases everything, growing the block if the frame overflowed it
+void FrameArena::Reset() {
+    if (!m_overflow.empty()) {
+        for (char* block : m_overflow) {
+            std::free(block);
+        }
+        m_overflow.clear();
+
+        // Room for the whole last frame, with some margin. Silent on the
+        // frame path: growth shows in the allocation counter and GetCapacity.
+        size_t capacity = m_offset.load(std::memory_order_relaxed);
+        capacity += capacity / 2;
+        std::free(m_block);
+        m_block = static_cast<char*>(std::malloc(capacity));
+        m_capacity = (m_block != nullptr) ? capacity : 0;
+        FlightRecorder::Count(FlightCounter::Allocations);
+    }
+    m_offset.store(0, std::memory_order_relaxed);
+    m_used.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,123 @@
+#include "FrameGovernor.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+// Quality ladder, from cheapest to best looking
+static const QualityTier s_tiers[] = {
+    { "low",    0.50f, 20 },
+    { "medium", 0.67f, 30 },
+    { "high",   0.85f, 40 },
+    { "ultra",  1.00f, 50 },
+};
+static const int s_tierCount = sizeof(s_tiers) / sizeof(s_tiers[0]);
+
+// Weight of a new sample in the moving averages
+static const double s_smoothing = 0.1;
+// Go down a tier when the frame is this much over budget...
+static const double s_overBudgetMargin = 0.05;
+static const int s_overBudgetFrames = 10;
+// ...and up a tier only with this much headroom, for much longer
+static const double s_headroomMargin = 0.25;
+static const int s_headroomFrames = 90;
+// Frames to wait after a change, so GPU timings catch up with it
+static const int s_cooldownFrames = 30;
+
+// Constructor: starts at the best tier and lets the budget pull it down
+// @param budgetMs: Target frame time in milliseconds
+FrameGovernor::FrameGovernor(double budgetMs)
+    : m_budgetMs(budgetMs), m_tier(s_tierCount - 1) {}
+
+// Sets the target frame time
+// @param budgetMs: Target frame time in milliseconds, <= 0 disables the governor
+void FrameGovernor::SetBudget(double budgetMs) {
+    m_budgetMs = budgetMs;
+    if (m_budgetMs <= 0.0) {
+        m_tier = s_tierCount - 1;
+    }
+}
+
+// Disables the governor and renders at one tier
+// @param tier: Index on the ladder, 0 is the cheapest
+void FrameGovernor::SetFixedTier(int tier) {
+    m_budgetMs = 0.0;
+    m_tier = std::max(0, std::min(tier, s_tierCount - 1));
+}
+
+// Looks a tier up by name
+// @param name: "low", "medium", "high" or "ultra"
+// @return its index, -1 if there is no such tier
+int FrameGovernor::FindTier(const std::string& name) {
+    for (int i = 0; i < s_tierCount; ++i) {
+        if (name == s_tiers[i].name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Exponential moving average, seeded by the first sample
+double FrameGovernor::Smooth(double smoothed, double sample, bool first) {
+    return first ? sample : smoothed + s_smoothing * (sample - smoothed);
+}
+
+// Feeds the measurements of one frame and moves along the ladder if needed
+// @param cpuMs: CPU time of the frame
+// @param gpuMs: GPU time of a recent frame, negative if none was available
+void FrameGovernor::Update(double cpuMs, double gpuMs) {
+    m_smoothedCpuMs = Smooth(m_smoothedCpuMs, cpuMs, !m_hasCpuSample);
+    m_hasCpuSample = true;
+    if (gpuMs >= 0.0) {
+        m_smoothedGpuMs = Smooth(m_smoothedGpuMs, gpuMs, !m_hasGpuSample);
+        m_hasGpuSample = true;
+    }
+
+    if (m_budgetMs <= 0.0) {
+        return;
+    }
+    if (m_cooldownFrames > 0) {
+        --m_cooldownFrames;
+        return;
+    }
+
+    // CPU and GPU overlap, so the slower of the two bounds the frame
+    double frameMs = std::max(m_smoothedCpuMs, m_smoothedGpuMs);
+    const char* bottleneck = (m_smoothedGpuMs > m_smoothedCpuMs) ? "gpu" : "cpu";
+
+    if (frameMs > m_budgetMs * (1.0 + s_overBudgetMargin)) {
+        ++m_overBudgetFrames;
+        m_underBudgetFrames = 0;
+    } else if (frameMs < m_budgetMs * (1.0 - s_headroomMargin)) {
+        ++m_underBudgetFrames;
+        m_overBudgetFrames = 0;
+    } else {
+        m_overBudgetFrames = 0;
+        m_underBudgetFrames = 0;
+    }
+
+    int newTier = m_tier;
+    if (m_overBudgetFrames >= s_overBudgetFrames && m_tier > 0) {
+        newTier = m_tier - 1;
+    } else if (m_underBudgetFrames >= s_headroomFrames && m_tier < s_tierCount - 1) {
+        newTier = m_tier + 1;
+    }
+    if (newTier == m_tier) {
+        return;
+    }
+
+    std::stringstream decision;
+    decision << (newTier < m_tier ? "lowered" : "raised")
+             << " quality " << s_tiers[m_tier].name << " -> " << s_tiers[newTier].name
+             << " (" << bottleneck << " " << frameMs << " ms, budget " << m_budgetMs << " ms)";
+    m_lastDecision = decision.str();
+
+    m_tier = newTier;
+    m_overBudgetFrames = 0;
+    m_underBudgetFrames = 0;
+    m_cooldownFrames = s_cooldownFrames;
+}
+
+// Returns the tier the next frame should be rendered at
+const QualityTier& FrameGovernor::GetTier() const {
+    return s_tiers[m_tier];
+}
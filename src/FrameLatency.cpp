@@ -0,0 +1,105 @@
+#include "FrameLatency.hpp"
+#include "Profiler.hpp"
+#include "FramePacer.hpp"
+
+#include <algorithm>
+
+const int FrameLatency::s_maxFramesInFlight;
+
+// Constructor
+FrameLatency::FrameLatency()
+    : m_head(0), m_count(0), m_limit(2), m_pendingInput(-1.0) {
+    Reset();
+}
+
+// Destructor
+FrameLatency::~FrameLatency() {
+    while (m_count > 0) {
+        glDeleteSync(m_frames[m_head].fence);
+        m_head = (m_head + 1) % s_maxFramesInFlight;
+        --m_count;
+    }
+}
+
+// Sets how many swapped frames may be unfinished on the GPU
+// @param frames: The limit, clamped to 1 to s_maxFramesInFlight
+void FrameLatency::SetMaxFramesInFlight(int frames) {
+    m_limit = std::max(1, std::min(frames, s_maxFramesInFlight));
+}
+
+// Keeps the oldest input the next frame reflects
+// @param time: FramePacer::Now() when the input arrived
+void FrameLatency::AddInput(double time) {
+    if (m_pendingInput < 0.0 || time < m_pendingInput) {
+        m_pendingInput = time;
+    }
+}
+
+// Retires the frames the GPU finished, then waits for the oldest ones
+// until there is room for one more
+void FrameLatency::BeginFrame() {
+    PROFILE_SCOPE("FramesInFlightWait");
+    while (m_count > 0 && Retire(false)) {
+    }
+    if (m_count >= m_limit) {
+        double start = FramePacer::Now();
+        while (m_count >= m_limit) {
+            Retire(true);
+        }
+        m_waitMs += (FramePacer::Now() - start) * 1000.0;
+    }
+}
+
+// Fences the frame just swapped, with the input it reflects
+void FrameLatency::EndFrame() {
+    if (m_count == s_maxFramesInFlight) {
+        Retire(true);
+    }
+    Frame& frame = m_frames[(m_head + m_count) % s_maxFramesInFlight];
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.inputTime = m_pendingInput;
+    ++m_count;
+    m_pendingInput = -1.0;
+}
+
+// Retires every frame in flight
+void FrameLatency::Finish() {
+    while (m_count > 0) {
+        Retire(true);
+    }
+}
+
+// Removes the oldest frame if the GPU finished it, recording its latency
+// @param wait: Block until it finished
+// @return false if it was not finished (only without wait)
+bool FrameLatency::Retire(bool wait) {
+    Frame& frame = m_frames[m_head];
+    GLenum result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        if (!wait) {
+            return false;
+        }
+        do {
+            result = glClientWaitSync(frame.fence, 0, 1000000); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    if (frame.inputTime >= 0.0) {
+        double latencyMs = (FramePacer::Now() - frame.inputTime) * 1000.0;
+        ++m_samples;
+        m_totalMs += latencyMs;
+        m_maxMs = std::max(m_maxMs, latencyMs);
+    }
+    glDeleteSync(frame.fence);
+    m_head = (m_head + 1) % s_maxFramesInFlight;
+    --m_count;
+    return true;
+}
+
+// Clears the measurements
+void FrameLatency::Reset() {
+    m_samples = 0;
+    m_totalMs = 0.0;
+    m_maxMs = 0.0;
+    m_waitMs = 0.0;
+}
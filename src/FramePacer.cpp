@@ -0,0 +1,103 @@
+#include "FramePacer.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+const double FramePacer::s_bucketLimits[FramePacer::s_bucketCount - 1] = { 0.1, 0.25, 0.5, 1.0, 2.0, 4.0 };
+
+// Constructor
+FramePacer::FramePacer()
+    : m_targetMs(0.0), m_lastFrame(-1.0), m_deadline(0.0), m_lastPeriodMs(0.0),
+      m_sleepOvershootMs(1.0), m_frames(0), m_worstJitterMs(0.0) {
+    ResetJitter();
+}
+
+// Returns the time of the steady clock in seconds
+double FramePacer::Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Measures the period since the last frame and records its jitter
+// @return Seconds since the last call, 0 on the first
+double FramePacer::BeginFrame() {
+    double now = Now();
+    if (m_lastFrame < 0.0) {
+        m_lastFrame = now;
+        m_deadline = now;
+        return 0.0;
+    }
+
+    double periodMs = (now - m_lastFrame) * 1000.0;
+    double referenceMs = (m_targetMs > 0.0) ? m_targetMs : m_lastPeriodMs;
+    if (referenceMs > 0.0) {
+        double jitterMs = std::fabs(periodMs - referenceMs);
+        int bucket = 0;
+        while (bucket < s_bucketCount - 1 && jitterMs >= s_bucketLimits[bucket]) {
+            ++bucket;
+        }
+        ++m_buckets[bucket];
+        ++m_frames;
+        m_worstJitterMs = std::max(m_worstJitterMs, jitterMs);
+    }
+
+    m_lastPeriodMs = periodMs;
+    m_lastFrame = now;
+    return periodMs / 1000.0;
+}
+
+// Waits for the next deadline: sleeps in 1 ms steps while that cannot
+// overshoot it, then spins
+void FramePacer::Wait() {
+    PROFILE_SCOPE("Pacing");
+    if (m_targetMs <= 0.0) {
+        return;
+    }
+
+    m_deadline += m_targetMs / 1000.0;
+    double now = Now();
+    // More than a frame behind: start over from now instead of rushing
+    // frames out to catch up
+    if (now > m_deadline + m_targetMs / 1000.0) {
+        m_deadline = now;
+        return;
+    }
+
+    while ((m_deadline - now) * 1000.0 > 1.0 + m_sleepOvershootMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        double woke = Now();
+        // Follow the worst recent overshoot, forgetting it slowly
+        double overshootMs = (woke - now) * 1000.0 - 1.0;
+        m_sleepOvershootMs = std::max(overshootMs, m_sleepOvershootMs * 0.99);
+        now = woke;
+    }
+    while (Now() < m_deadline) {
+        std::this_thread::yield();
+    }
+}
+
+// Prints the share of frames per jitter bucket
+// @param out: Stream to print to
+void FramePacer::PrintJitter(std::ostream& out) const {
+    out << "[Jitter] " << m_frames << " frames";
+    for (int i = 0; i < s_bucketCount; ++i) {
+        out << " | ";
+        if (i < s_bucketCount - 1) {
+            out << "<" << s_bucketLimits[i];
+        } else {
+            out << ">=" << s_bucketLimits[i - 1];
+        }
+        out << " ms " << (m_frames > 0 ? 100.0 * m_buckets[i] / m_frames : 0.0) << "%";
+    }
+    out << " | worst " << m_worstJitterMs << " ms\n";
+}
+
+// Clears the histogram
+void FramePacer::ResetJitter() {
+    for (int i = 0; i < s_bucketCount; ++i) {
+        m_buckets[i] = 0;
+    }
+    m_frames = 0;
+    m_worstJitterMs = 0.0;
+}
@@ -0,0 +1,158 @@
+#include "FrameRing.hpp"
+#include "Profiler.hpp"
+#include "FlightRecorder.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// Constructor
+// @param regionSize: Bytes available to each frame
+FrameRing::FrameRing(GLsizeiptr regionSize)
+    : m_buffer(0), m_mapped(nullptr), m_regionSize(regionSize), m_region(0), m_offset(0),
+      m_uniformAlignment(256), m_storageAlignment(256), m_requested(0), m_overflowed(false), m_stallMs(0.0) {
+    for (int i = 0; i < s_regionCount; ++i) {
+        m_fences[i] = nullptr;
+    }
+}
+
+// Destructor
+FrameRing::~FrameRing() {
+    if (m_buffer != 0) {
+        Destroy();
+    }
+}
+
+// True when the context supports persistent mapping
+bool FrameRing::IsAvailable() const {
+    return GLExtensions::HasBufferStorage();
+}
+
+// Creates the buffer for all regions and maps it for good
+void FrameRing::Create() {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_uniformAlignment = std::max<GLsizeiptr>(alignment, 16);
+    alignment = 0;
+    if (GLExtensions::HasMultiDrawIndirect()) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    }
+    m_storageAlignment = std::max<GLsizeiptr>(alignment, 16);
+    // Offsets are aligned within a region, so regions must start aligned
+    GLsizeiptr regionAlignment = std::max(m_uniformAlignment, m_storageAlignment);
+    m_regionSize = (m_regionSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_buffer);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, m_regionSize * s_regionCount, nullptr, flags);
+    m_mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_regionSize * s_regionCount, flags);
+    if (m_mapped == nullptr) {
+        std::cout << "FrameRing: could not map " << m_regionSize * s_regionCount << " bytes" << std::endl;
+    }
+}
+
+// Waits for every region, then unmaps and deletes the buffer
+void FrameRing::Destroy() {
+    for (int i = 0; i < s_regionCount; ++i) {
+        m_stallMs += Wait(i);
+    }
+    if (m_mapped != nullptr) {
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        m_mapped = nullptr;
+    }
+    GLState::DeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+}
+
+// Waits until the fence of a region is signaled, then deletes it
+// @param region: Index of the region
+// @return Milliseconds waited, 0 if the GPU was already done
+double FrameRing::Wait(int region) {
+    GLsync fence = m_fences[region];
+    if (fence == nullptr) {
+        return 0.0;
+    }
+    m_fences[region] = nullptr;
+
+    // Already signaled is the common case, and costs no timing
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    double waited = 0.0;
+    if (result == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        // The first wait flushes, so the fence is sure to be reached
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        do {
+            result = glClientWaitSync(fence, flags, 1000000); // 1 ms
+            flags = 0;
+        } while (result == GL_TIMEOUT_EXPIRED);
+        waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(fence);
+    return waited;
+}
+
+// Moves to the next region, waiting for the GPU if it still reads it
+void FrameRing::BeginFrame() {
+    PROFILE_SCOPE("FrameRingWait");
+    m_stallMs = 0.0;
+    if (!IsAvailable()) {
+        return;
+    }
+
+    // Grow to fit what the last frame asked for. Frames in flight may
+    // still read the old buffer, so Destroy waits for all of them. Counted
+    // as an allocation, GetRegionSize reports the new size.
+    if (m_overflowed && m_buffer != 0) {
+        GLsizeiptr size = std::max(m_regionSize * 2, m_requested);
+        Destroy();
+        m_regionSize = size;
+        FlightRecorder::Count(FlightCounter::Allocations);
+    }
+    if (m_buffer == 0) {
+        Create();
+        m_region = 0;
+    } else {
+        m_region = (m_region + 1) % s_regionCount;
+    }
+    m_stallMs += Wait(m_region);
+    m_offset = 0;
+    m_requested = 0;
+    m_overflowed = false;
+}
+
+// Suballocates the current region
+// @param size: Bytes needed
+// @param alignment: Offset alignment in bytes
+// @param allocation: Receives the range
+// @return false if the region is full or the ring unavailable
+bool FrameRing::Allocate(GLsizeiptr size, GLsizeiptr alignment, Allocation& allocation) {
+    if (m_mapped == nullptr) {
+        return false;
+    }
+    GLsizeiptr offset = (m_offset + alignment - 1) / alignment * alignment;
+    m_requested = std::max(m_requested, offset) + size;
+    if (offset + size > m_regionSize) {
+        m_overflowed = true;
+        return false;
+    }
+    m_offset = offset + size;
+
+    GLintptr start = (GLintptr)m_region * m_regionSize + offset;
+    allocation.data = m_mapped + start;
+    allocation.buffer = m_buffer;
+    allocation.offset = start;
+    allocation.size = size;
+    return true;
+}
+
+// Fences the current region after the frame's last draw reading it
+void FrameRing::EndFrame() {
+    if (m_mapped == nullptr) {
+        return;
+    }
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,118 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+#ifdef FRUSTUM_USE_SSE
+    #include <xmmintrin.h>
+#endif
+
+const int Frustum::s_planeCount;
+
+// Constructor: every plane accepts everything until Extract is called
+Frustum::Frustum() {
+    for (int i = 0; i < s_planeCount; ++i) {
+        m_planeX[i] = 0.0f;
+        m_planeY[i] = 0.0f;
+        m_planeZ[i] = 0.0f;
+        m_planeW[i] = 1.0f;
+    }
+}
+
+// Extracts the planes from the rows of the projection x view matrix
+// @param viewProjection: projection x view matrix of the camera
+void Frustum::Extract(const glm::mat4& viewProjection) {
+    // glm is column major: row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r) {
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    }
+    const glm::vec4 planes[6] = {
+        rows[3] + rows[0], // left
+        rows[3] - rows[0], // right
+        rows[3] + rows[1], // bottom
+        rows[3] - rows[1], // top
+        rows[3] + rows[2], // near
+        rows[3] - rows[2]  // far
+    };
+
+    for (int i = 0; i < 6; ++i) {
+        float length = glm::length(glm::vec3(planes[i]));
+        if (length <= 0.0f) {
+            length = 1.0f;
+        }
+        m_planeX[i] = planes[i].x / length;
+        m_planeY[i] = planes[i].y / length;
+        m_planeZ[i] = planes[i].z / length;
+        m_planeW[i] = planes[i].w / length;
+    }
+    // Padding planes stay 0x + 0y + 0z + 1 >= 0
+}
+
+// Tests a box against all planes: the box is outside a plane if its center
+// is further behind it than the box's projected radius
+// @param box: World space box
+// @return false if the box is certainly outside
+bool Frustum::Intersects(const AABB& box) const {
+    if (box.IsEmpty()) {
+        return false;
+    }
+    const glm::vec3 center = box.GetCenter();
+    const glm::vec3 extents = box.GetExtents();
+
+#ifdef FRUSTUM_USE_SSE
+    const __m128 centerX = _mm_set1_ps(center.x);
+    const __m128 centerY = _mm_set1_ps(center.y);
+    const __m128 centerZ = _mm_set1_ps(center.z);
+    const __m128 extentX = _mm_set1_ps(extents.x);
+    const __m128 extentY = _mm_set1_ps(extents.y);
+    const __m128 extentZ = _mm_set1_ps(extents.z);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int i = 0; i < s_planeCount; i += 4) {
+        __m128 planeX = _mm_load_ps(m_planeX + i);
+        __m128 planeY = _mm_load_ps(m_planeY + i);
+        __m128 planeZ = _mm_load_ps(m_planeZ + i);
+        __m128 planeW = _mm_load_ps(m_planeW + i);
+
+        // Signed distance of the center to four planes
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(planeX, centerX), _mm_mul_ps(planeY, centerY)),
+            _mm_add_ps(_mm_mul_ps(planeZ, centerZ), planeW));
+        // Extents projected on the four normals: |n| . e
+        __m128 radius = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, planeX), extentX),
+                       _mm_mul_ps(_mm_andnot_ps(signMask, planeY), extentY)),
+            _mm_mul_ps(_mm_andnot_ps(signMask, planeZ), extentZ));
+
+        __m128 outside = _mm_cmplt_ps(_mm_add_ps(distance, radius), zero);
+        if (_mm_movemask_ps(outside) != 0) {
+            return false;
+        }
+    }
+    return true;
+#else
+    for (int i = 0; i < s_planeCount; ++i) {
+        float distance = m_planeX[i] * center.x + m_planeY[i] * center.y + m_planeZ[i] * center.z + m_planeW[i];
+        float radius = std::fabs(m_planeX[i]) * extents.x + std::fabs(m_planeY[i]) * extents.y + std::fabs(m_planeZ[i]) * extents.z;
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+// Tests a sphere against all planes
+// @param sphere: World space sphere
+// @return false if the sphere is certainly outside
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+    for (int i = 0; i < s_planeCount; ++i) {
+        float distance = m_planeX[i] * sphere.center.x + m_planeY[i] * sphere.center.y +
+                         m_planeZ[i] * sphere.center.z + m_planeW[i];
+        if (distance < -sphere.radius) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+#include "GLExtensions.hpp"
+#include <iostream>
+
+PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture = nullptr;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = nullptr;
+PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D = nullptr;
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+
+int GLExtensions::s_contextVersion = 0;
+bool GLExtensions::s_hasComputeShaders = false;
+bool GLExtensions::s_hasMultiDrawIndirect = false;
+bool GLExtensions::s_hasBufferStorage = false;
+
+// Loads the OpenGL 4.x entry points that glad does not provide
+// @param load: The loader function (e.g. SDL_GL_GetProcAddress)
+void GLExtensions::Load(GLADloadproc load) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    s_contextVersion = major * 10 + minor;
+
+    glad_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+    glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+    glad_glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+    glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+    glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+    glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+
+    // A non-null pointer is not enough, some drivers export everything
+    // regardless of the context version.
+    s_hasComputeShaders = s_contextVersion >= 43 &&
+                          glad_glBindImageTexture != nullptr &&
+                          glad_glMemoryBarrier != nullptr &&
+                          glad_glTexStorage2D != nullptr &&
+                          glad_glDispatchCompute != nullptr;
+    s_hasMultiDrawIndirect = s_contextVersion >= 43 &&
+                             glad_glMultiDrawElementsIndirect != nullptr;
+    s_hasBufferStorage = s_contextVersion >= 44 &&
+                         glad_glBufferStorage != nullptr;
+
+    std::cout << "GLExtensions: context version " << major << "." << minor
+              << ", compute shaders " << (s_hasComputeShaders ? "available" : "unavailable")
+              << ", indirect multi-draw " << (s_hasMultiDrawIndirect ? "available" : "unavailable")
+              << ", buffer storage " << (s_hasBufferStorage ? "available" : "unavailable") << std::endl;
+}
+
+// Returns the version of the current context, e.g. 43 for OpenGL 4.3
+int GLExtensions::GetContextVersion() {
+    return s_contextVersion;
+}
+
+// True when compute shaders and image load/store can be used
+bool GLExtensions::HasComputeShaders() {
+    return s_hasComputeShaders;
+}
+
+// True when glMultiDrawElementsIndirect and shader storage buffers can be used
+bool GLExtensions::HasMultiDrawIndirect() {
+    return s_hasMultiDrawIndirect;
+}
+
+// True when buffers can be mapped persistently with glBufferStorage
+bool GLExtensions::HasBufferStorage() {
+    return s_hasBufferStorage;
+}
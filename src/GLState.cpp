@@ -0,0 +1,556 @@
+#include "GLState.hpp"
+#include "GLExtensions.hpp"
+
+#include <cassert>
+
+// Tracked buffer targets, and the query returning their binding
+static const GLenum s_bufferTargetNames[] = {
+    GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+    GL_DRAW_INDIRECT_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_UNIFORM_BUFFER,
+    GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER
+};
+static const GLenum s_bufferBindingNames[] = {
+    GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+    GL_DRAW_INDIRECT_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING,
+    GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING
+};
+static const int s_elementSlot = 1;
+
+const GLuint GLState::s_unknown;
+const int GLState::s_textureUnits;
+const int GLState::s_bufferTargets;
+const int GLState::s_indexedBindings;
+const int GLState::s_capabilities;
+const int GLState::s_imageUnits;
+
+GLuint GLState::s_program = GLState::s_unknown;
+GLuint GLState::s_vertexArray = GLState::s_unknown;
+GLuint GLState::s_buffers[GLState::s_bufferTargets];
+GLuint GLState::s_storageBuffers[GLState::s_indexedBindings];
+GLuint GLState::s_uniformBuffers[GLState::s_indexedBindings];
+GLuint GLState::s_activeUnit = GLState::s_unknown;
+GLuint GLState::s_textures[GLState::s_textureUnits];
+GLuint GLState::s_images[GLState::s_imageUnits];
+GLint GLState::s_imageLevels[GLState::s_imageUnits];
+GLenum GLState::s_imageAccess[GLState::s_imageUnits];
+GLenum GLState::s_imageFormats[GLState::s_imageUnits];
+GLuint GLState::s_readFramebuffer = GLState::s_unknown;
+GLuint GLState::s_drawFramebuffer = GLState::s_unknown;
+GLuint GLState::s_renderbuffer = GLState::s_unknown;
+GLenum GLState::s_capabilityNames[GLState::s_capabilities];
+GLuint GLState::s_capabilityStates[GLState::s_capabilities];
+GLint GLState::s_viewport[4];
+bool GLState::s_viewportKnown = false;
+size_t GLState::s_issued = 0;
+size_t GLState::s_elided = 0;
+
+// Static arrays cannot be initialized to s_unknown in their definition
+static bool s_initialized = false;
+static void EnsureInitialized() {
+    if (!s_initialized) {
+        s_initialized = true;
+        GLState::Invalidate();
+    }
+}
+
+// Returns the slot of a tracked buffer target
+// @param target: A glBindBuffer target
+// @return The slot, -1 if the target is not tracked
+int GLState::BufferSlot(GLenum target) {
+    for (int i = 0; i < s_bufferTargets; ++i) {
+        if (s_bufferTargetNames[i] == target) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Returns the slot of a capability, taking a free one on first use
+// @param capability: A glEnable capability
+// @return The slot, -1 if all slots are taken
+int GLState::CapabilitySlot(GLenum capability) {
+    for (int i = 0; i < s_capabilities; ++i) {
+        if (s_capabilityNames[i] == capability) {
+            return i;
+        }
+        if (s_capabilityNames[i] == 0) {
+            s_capabilityNames[i] = capability;
+            s_capabilityStates[i] = s_unknown;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Counts a skipped call, checking that OpenGL agrees it was redundant
+// @param binding: glGetIntegerv query of the binding
+// @param expected: The remembered value
+void GLState::Elided(GLenum binding, GLuint expected) {
+    ++s_elided;
+#ifdef GLSTATE_VALIDATE
+    GLint actual = 0;
+    glGetIntegerv(binding, &actual);
+    assert((GLuint)actual == expected && "OpenGL state was changed behind GLState");
+#else
+    (void)binding;
+    (void)expected;
+#endif
+}
+
+// Counts a skipped indexed binding
+// @param binding: glGetIntegeri_v query of the binding
+// @param index: Binding index
+// @param expected: The remembered value
+void GLState::ElidedIndexed(GLenum binding, GLuint index, GLuint expected) {
+    ++s_elided;
+#ifdef GLSTATE_VALIDATE
+    GLint actual = 0;
+    glGetIntegeri_v(binding, index, &actual);
+    assert((GLuint)actual == expected && "OpenGL state was changed behind GLState");
+#else
+    (void)binding;
+    (void)index;
+    (void)expected;
+#endif
+}
+
+// Counts a skipped glEnable or glDisable
+// @param capability: The capability
+// @param expected: The remembered state
+void GLState::ElidedCapability(GLenum capability, bool expected) {
+    ++s_elided;
+#ifdef GLSTATE_VALIDATE
+    assert((glIsEnabled(capability) == GL_TRUE) == expected && "OpenGL state was changed behind GLState");
+#else
+    (void)capability;
+    (void)expected;
+#endif
+}
+
+// Binds a program
+// @param program: The program, 0 for none
+void GLState::UseProgram(GLuint program) {
+    EnsureInitialized();
+    if (s_program == program) {
+        Elided(GL_CURRENT_PROGRAM, program);
+        return;
+    }
+    glUseProgram(program);
+    s_program = program;
+    ++s_issued;
+}
+
+// Binds a vertex array
+// @param vertexArray: The vertex array, 0 for none
+void GLState::BindVertexArray(GLuint vertexArray) {
+    EnsureInitialized();
+    if (s_vertexArray == vertexArray) {
+        Elided(GL_VERTEX_ARRAY_BINDING, vertexArray);
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    s_vertexArray = vertexArray;
+    s_buffers[s_elementSlot] = s_unknown;
+    ++s_issued;
+}
+
+// Binds a buffer
+// @param target: Binding point
+// @param buffer: The buffer, 0 for none
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+    EnsureInitialized();
+    int slot = BufferSlot(target);
+    if (slot >= 0 && s_buffers[slot] == buffer) {
+        Elided(s_bufferBindingNames[slot], buffer);
+        return;
+    }
+    glBindBuffer(target, buffer);
+    if (slot >= 0) {
+        s_buffers[slot] = buffer;
+    }
+    ++s_issued;
+}
+
+// Binds a buffer to an indexed binding point (and the generic one)
+// @param target: GL_SHADER_STORAGE_BUFFER or GL_UNIFORM_BUFFER
+// @param index: Binding index
+// @param buffer: The buffer
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    EnsureInitialized();
+    GLuint* bindings = (target == GL_SHADER_STORAGE_BUFFER) ? s_storageBuffers :
+                       (target == GL_UNIFORM_BUFFER) ? s_uniformBuffers : nullptr;
+    int slot = BufferSlot(target);
+    bool tracked = bindings != nullptr && index < (GLuint)s_indexedBindings;
+    if (tracked && bindings[index] == buffer && s_buffers[slot] == buffer) {
+        ElidedIndexed(s_bufferBindingNames[slot], index, buffer);
+        return;
+    }
+    glBindBufferBase(target, index, buffer);
+    if (tracked) {
+        bindings[index] = buffer;
+    }
+    if (slot >= 0) {
+        s_buffers[slot] = buffer;
+    }
+    ++s_issued;
+}
+
+// Binds a range of a buffer to an indexed binding point. The range is not
+// remembered, so a later BindBufferBase of the same buffer is issued.
+// @param target: GL_SHADER_STORAGE_BUFFER or GL_UNIFORM_BUFFER
+// @param index: Binding index
+// @param buffer, offset, size: The range
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    EnsureInitialized();
+    glBindBufferRange(target, index, buffer, offset, size);
+    GLuint* bindings = (target == GL_SHADER_STORAGE_BUFFER) ? s_storageBuffers :
+                       (target == GL_UNIFORM_BUFFER) ? s_uniformBuffers : nullptr;
+    if (bindings != nullptr && index < (GLuint)s_indexedBindings) {
+        bindings[index] = s_unknown;
+    }
+    int slot = BufferSlot(target);
+    if (slot >= 0) {
+        s_buffers[slot] = buffer;
+    }
+    ++s_issued;
+}
+
+// Selects the texture unit later texture binds apply to
+// @param unit: GL_TEXTURE0 + i
+void GLState::ActiveTexture(GLenum unit) {
+    EnsureInitialized();
+    if (s_activeUnit == unit) {
+        Elided(GL_ACTIVE_TEXTURE, unit);
+        return;
+    }
+    glActiveTexture(unit);
+    s_activeUnit = unit;
+    ++s_issued;
+}
+
+// Binds a texture to the active unit
+// @param target: Texture target, only GL_TEXTURE_2D is tracked
+// @param texture: The texture, 0 for none
+void GLState::BindTexture(GLenum target, GLuint texture) {
+    EnsureInitialized();
+    GLuint unit = s_activeUnit - GL_TEXTURE0;
+    bool tracked = target == GL_TEXTURE_2D && s_activeUnit != s_unknown && unit < (GLuint)s_textureUnits;
+    if (tracked && s_textures[unit] == texture) {
+        Elided(GL_TEXTURE_BINDING_2D, texture);
+        return;
+    }
+    glBindTexture(target, texture);
+    if (tracked) {
+        s_textures[unit] = texture;
+    } else if (target == GL_TEXTURE_2D) {
+        // Unit unknown: no remembered unit can be trusted
+        for (int i = 0; i < s_textureUnits; ++i) {
+            s_textures[i] = s_unknown;
+        }
+    }
+    ++s_issued;
+}
+
+// Binds a texture level to an image unit
+// @param unit, texture, level, layered, layer, access, format: As glBindImageTexture
+void GLState::BindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format) {
+    EnsureInitialized();
+    bool tracked = unit < (GLuint)s_imageUnits && layered == GL_FALSE && layer == 0;
+    if (tracked && s_images[unit] == texture && s_imageLevels[unit] == level &&
+        s_imageAccess[unit] == access && s_imageFormats[unit] == format) {
+        ElidedIndexed(GL_IMAGE_BINDING_NAME, unit, texture);
+        return;
+    }
+    glBindImageTexture(unit, texture, level, layered, layer, access, format);
+    if (unit < (GLuint)s_imageUnits) {
+        s_images[unit] = tracked ? texture : s_unknown;
+        s_imageLevels[unit] = level;
+        s_imageAccess[unit] = access;
+        s_imageFormats[unit] = format;
+    }
+    ++s_issued;
+}
+
+// Binds a framebuffer
+// @param target: GL_FRAMEBUFFER, GL_READ_FRAMEBUFFER or GL_DRAW_FRAMEBUFFER
+// @param framebuffer: The framebuffer, 0 for the window
+void GLState::BindFramebuffer(GLenum target, GLuint framebuffer) {
+    EnsureInitialized();
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    if ((!read || s_readFramebuffer == framebuffer) && (!draw || s_drawFramebuffer == framebuffer)) {
+        Elided(draw ? GL_DRAW_FRAMEBUFFER_BINDING : GL_READ_FRAMEBUFFER_BINDING, framebuffer);
+        return;
+    }
+    glBindFramebuffer(target, framebuffer);
+    if (read) {
+        s_readFramebuffer = framebuffer;
+    }
+    if (draw) {
+        s_drawFramebuffer = framebuffer;
+    }
+    ++s_issued;
+}
+
+// Binds a renderbuffer
+// @param target: GL_RENDERBUFFER
+// @param renderbuffer: The renderbuffer, 0 for none
+void GLState::BindRenderbuffer(GLenum target, GLuint renderbuffer) {
+    EnsureInitialized();
+    if (s_renderbuffer == renderbuffer) {
+        Elided(GL_RENDERBUFFER_BINDING, renderbuffer);
+        return;
+    }
+    glBindRenderbuffer(target, renderbuffer);
+    s_renderbuffer = renderbuffer;
+    ++s_issued;
+}
+
+// Enables a capability
+// @param capability: e.g. GL_DEPTH_TEST
+void GLState::Enable(GLenum capability) {
+    EnsureInitialized();
+    int slot = CapabilitySlot(capability);
+    if (slot >= 0 && s_capabilityStates[slot] == 1) {
+        ElidedCapability(capability, true);
+        return;
+    }
+    glEnable(capability);
+    if (slot >= 0) {
+        s_capabilityStates[slot] = 1;
+    }
+    ++s_issued;
+}
+
+// Disables a capability
+// @param capability: e.g. GL_DEPTH_TEST
+void GLState::Disable(GLenum capability) {
+    EnsureInitialized();
+    int slot = CapabilitySlot(capability);
+    if (slot >= 0 && s_capabilityStates[slot] == 0) {
+        ElidedCapability(capability, false);
+        return;
+    }
+    glDisable(capability);
+    if (slot >= 0) {
+        s_capabilityStates[slot] = 0;
+    }
+    ++s_issued;
+}
+
+// Sets the viewport
+// @param x, y, width, height: As glViewport
+void GLState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    EnsureInitialized();
+    if (s_viewportKnown && s_viewport[0] == x && s_viewport[1] == y && s_viewport[2] == width && s_viewport[3] == height) {
+        ++s_elided;
+#ifdef GLSTATE_VALIDATE
+        GLint actual[4];
+        glGetIntegerv(GL_VIEWPORT, actual);
+        assert(actual[0] == x && actual[1] == y && actual[2] == width && actual[3] == height &&
+               "OpenGL state was changed behind GLState");
+#endif
+        return;
+    }
+    glViewport(x, y, width, height);
+    s_viewport[0] = x;
+    s_viewport[1] = y;
+    s_viewport[2] = width;
+    s_viewport[3] = height;
+    s_viewportKnown = true;
+    ++s_issued;
+}
+
+// Deletes a program. A current program stays in use until another one is
+// bound, so its binding is only forgotten.
+// @param program: The program
+void GLState::DeleteProgram(GLuint program) {
+    if (s_program == program) {
+        s_program = s_unknown;
+    }
+    glDeleteProgram(program);
+}
+
+// Deletes vertex arrays, a bound one reverts to 0
+// @param count, vertexArrays: The vertex arrays
+void GLState::DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (s_vertexArray == vertexArrays[i]) {
+            s_vertexArray = 0;
+            s_buffers[s_elementSlot] = s_unknown;
+        }
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+// Deletes buffers, bindings of the context revert to 0. Bindings stored
+// in vertex arrays are not tracked, so the element binding is forgotten.
+// @param count, buffers: The buffers
+void GLState::DeleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        for (int slot = 0; slot < s_bufferTargets; ++slot) {
+            if (s_buffers[slot] == buffers[i]) {
+                s_buffers[slot] = (slot == s_elementSlot) ? s_unknown : 0;
+            }
+        }
+        for (int index = 0; index < s_indexedBindings; ++index) {
+            if (s_storageBuffers[index] == buffers[i]) {
+                s_storageBuffers[index] = 0;
+            }
+            if (s_uniformBuffers[index] == buffers[i]) {
+                s_uniformBuffers[index] = 0;
+            }
+        }
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+// Deletes textures, bindings of every unit revert to 0
+// @param count, textures: The textures
+void GLState::DeleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; ++i) {
+        for (int unit = 0; unit < s_textureUnits; ++unit) {
+            if (s_textures[unit] == textures[i]) {
+                s_textures[unit] = 0;
+            }
+        }
+        for (int unit = 0; unit < s_imageUnits; ++unit) {
+            if (s_images[unit] == textures[i]) {
+                s_images[unit] = 0;
+            }
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+// Deletes framebuffers, a bound one reverts to the window
+// @param count, framebuffers: The framebuffers
+void GLState::DeleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (s_readFramebuffer == framebuffers[i]) {
+            s_readFramebuffer = 0;
+        }
+        if (s_drawFramebuffer == framebuffers[i]) {
+            s_drawFramebuffer = 0;
+        }
+    }
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+// Deletes renderbuffers, a bound one reverts to 0
+// @param count, renderbuffers: The renderbuffers
+void GLState::DeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (s_renderbuffer == renderbuffers[i]) {
+            s_renderbuffer = 0;
+        }
+    }
+    glDeleteRenderbuffers(count, renderbuffers);
+}
+
+// Returns the bound draw framebuffer without a query when it is known
+GLuint GLState::GetDrawFramebuffer() {
+    EnsureInitialized();
+    if (s_drawFramebuffer == s_unknown) {
+        GLint framebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        s_drawFramebuffer = (GLuint)framebuffer;
+    }
+    return s_drawFramebuffer;
+}
+
+// Returns the viewport without a query when it is known
+// @param viewport: Receives x, y, width, height
+void GLState::GetViewport(GLint viewport[4]) {
+    EnsureInitialized();
+    if (!s_viewportKnown) {
+        glGetIntegerv(GL_VIEWPORT, s_viewport);
+        s_viewportKnown = true;
+    }
+    for (int i = 0; i < 4; ++i) {
+        viewport[i] = s_viewport[i];
+    }
+}
+
+// Forgets all remembered state
+void GLState::Invalidate() {
+    s_initialized = true;
+    s_program = s_unknown;
+    s_vertexArray = s_unknown;
+    for (int i = 0; i < s_bufferTargets; ++i) {
+        s_buffers[i] = s_unknown;
+    }
+    for (int i = 0; i < s_indexedBindings; ++i) {
+        s_storageBuffers[i] = s_unknown;
+        s_uniformBuffers[i] = s_unknown;
+    }
+    s_activeUnit = s_unknown;
+    for (int i = 0; i < s_textureUnits; ++i) {
+        s_textures[i] = s_unknown;
+    }
+    for (int i = 0; i < s_imageUnits; ++i) {
+        s_images[i] = s_unknown;
+        s_imageLevels[i] = -1;
+        s_imageAccess[i] = 0;
+        s_imageFormats[i] = 0;
+    }
+    s_readFramebuffer = s_unknown;
+    s_drawFramebuffer = s_unknown;
+    s_renderbuffer = s_unknown;
+    for (int i = 0; i < s_capabilities; ++i) {
+        s_capabilityStates[i] = s_unknown;
+    }
+    s_viewportKnown = false;
+}
+
+// Checks every known binding against OpenGL
+void GLState::Validate() {
+#ifdef GLSTATE_VALIDATE
+    GLint actual = 0;
+    if (s_program != s_unknown) {
+        glGetIntegerv(GL_CURRENT_PROGRAM, &actual);
+        assert((GLuint)actual == s_program && "OpenGL program was changed behind GLState");
+    }
+    if (s_vertexArray != s_unknown) {
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &actual);
+        assert((GLuint)actual == s_vertexArray && "OpenGL vertex array was changed behind GLState");
+    }
+    for (int slot = 0; slot < s_bufferTargets; ++slot) {
+        if (s_buffers[slot] != s_unknown) {
+            glGetIntegerv(s_bufferBindingNames[slot], &actual);
+            assert((GLuint)actual == s_buffers[slot] && "OpenGL buffer binding was changed behind GLState");
+        }
+    }
+    if (s_activeUnit != s_unknown) {
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &actual);
+        assert((GLuint)actual == s_activeUnit && "OpenGL active texture was changed behind GLState");
+        for (int unit = 0; unit < s_textureUnits; ++unit) {
+            if (s_textures[unit] != s_unknown) {
+                glActiveTexture(GL_TEXTURE0 + unit);
+                glGetIntegerv(GL_TEXTURE_BINDING_2D, &actual);
+                assert((GLuint)actual == s_textures[unit] && "OpenGL texture binding was changed behind GLState");
+            }
+        }
+        glActiveTexture(s_activeUnit);
+    }
+    if (s_drawFramebuffer != s_unknown) {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &actual);
+        assert((GLuint)actual == s_drawFramebuffer && "OpenGL framebuffer was changed behind GLState");
+    }
+    for (int i = 0; i < s_capabilities; ++i) {
+        if (s_capabilityNames[i] != 0 && s_capabilityStates[i] != s_unknown) {
+            assert((glIsEnabled(s_capabilityNames[i]) == GL_TRUE) == (s_capabilityStates[i] == 1) &&
+                   "OpenGL capability was changed behind GLState");
+        }
+    }
+    (void)actual;
+#endif
+}
+
+// Starts a frame: validates the remembered state and resets the counters
+void GLState::BeginFrame() {
+    EnsureInitialized();
+    Validate();
+    s_issued = 0;
+    s_elided = 0;
+}
@@ -81,6 +81,22 @@ void Geometry::Gen(){
         m_bufferData.push_back(m_textureCoords[i].x);
         m_bufferData.push_back(m_textureCoords[i].y);
     }
+
+    // Bounds for culling: the box, then the sphere around its center
+    m_bounds = AABB();
+    for (size_t i = 0; i < m_vertexPositions.size(); ++i) {
+        m_bounds.Expand(m_vertexPositions[i]);
+    }
+    m_boundingSphere = BoundingSphere();
+    if (!m_bounds.IsEmpty()) {
+        m_boundingSphere.center = m_bounds.GetCenter();
+        float radiusSquared = 0.0f;
+        for (size_t i = 0; i < m_vertexPositions.size(); ++i) {
+            glm::vec3 offset = m_vertexPositions[i] - m_boundingSphere.center;
+            radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+        }
+        m_boundingSphere.radius = glm::sqrt(radiusSquared);
+    }
 }
 
 // Creates a triangle using three vertex indices
@@ -0,0 +1,307 @@
+#include "GpuCulling.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Constructor
+GpuCulling::GpuCulling()
+    : m_initialized(false), m_pool(nullptr), m_ring(nullptr), m_texture(0),
+      m_dirtyBegin(0), m_dirtyEnd(0), m_structureChanged(false),
+      m_instanceBuffer(0), m_matrixBuffer(0), m_commandBuffer(0), m_visibleBuffer(0),
+      m_depthTexture(0), m_depthPyramid(0), m_pyramidWidth(0), m_pyramidHeight(0), m_pyramidLevels(0),
+      m_hasDepthPyramid(false), m_pyramidViewProjection(1.0f), m_viewProjection(1.0f) {}
+
+// Destructor: Deletes the buffers and textures
+GpuCulling::~GpuCulling() {
+    GLuint buffers[] = { m_instanceBuffer, m_matrixBuffer, m_commandBuffer, m_visibleBuffer };
+    for (GLuint buffer : buffers) {
+        if (buffer != 0) {
+            GLState::DeleteBuffers(1, &buffer);
+        }
+    }
+    GLuint textures[] = { m_depthTexture, m_depthPyramid };
+    for (GLuint texture : textures) {
+        if (texture != 0) {
+            GLState::DeleteTextures(1, &texture);
+        }
+    }
+}
+
+// Compiles the compute shaders and the shaders drawing the instances
+// @param cullShader: Path to cull_comp.glsl
+// @param depthPyramidShader: Path to depth_pyramid_comp.glsl
+// @param vertShader, fragShader: Paths of the draw shaders
+// @return false if the context lacks compute shaders or indirect multi-draw
+bool GpuCulling::Init(const std::string& cullShader, const std::string& depthPyramidShader,
+                      const std::string& vertShader, const std::string& fragShader) {
+    if (!GLExtensions::HasComputeShaders() || !GLExtensions::HasMultiDrawIndirect()) {
+        std::cout << "GpuCulling: needs OpenGL 4.3, GPU culling disabled" << std::endl;
+        return false;
+    }
+
+    m_cullShader.CreateComputeShader(m_cullShader.LoadShader(cullShader));
+    m_depthPyramidShader.CreateComputeShader(m_depthPyramidShader.LoadShader(depthPyramidShader));
+    m_drawShader.CreateShaderFromFiles(vertShader, fragShader);
+    m_initialized = true;
+    std::cout << "GpuCulling Initialized" << std::endl;
+    return true;
+}
+
+// Adds an instance. Instances of the same mesh share one draw command.
+// @param mesh: Where the mesh is in the pool
+// @param model: World matrix
+// @param localBounds: Bounds of the mesh in object space
+// @return Index of the instance
+int GpuCulling::AddInstance(const MeshRange& mesh, const glm::mat4& model, const AABB& localBounds) {
+    GLuint meshIndex = 0;
+    while (meshIndex < m_meshes.size() &&
+           (m_meshes[meshIndex].firstIndex != mesh.firstIndex || m_meshes[meshIndex].baseVertex != mesh.baseVertex)) {
+        ++meshIndex;
+    }
+    if (meshIndex == m_meshes.size()) {
+        DrawElementsIndirectCommand command;
+        command.count = mesh.indexCount;
+        command.instanceCount = 0;
+        command.firstIndex = mesh.firstIndex;
+        command.baseVertex = mesh.baseVertex;
+        command.baseInstance = 0;
+        m_meshes.push_back(command);
+    }
+
+    AABB worldBounds = localBounds.Transformed(model);
+    GpuInstance instance;
+    instance.boundsMin = glm::vec4(worldBounds.min, 0.0f);
+    instance.boundsMax = glm::vec4(worldBounds.max, 0.0f);
+    instance.mesh = meshIndex;
+    instance.padding[0] = instance.padding[1] = instance.padding[2] = 0;
+
+    m_instances.push_back(instance);
+    m_matrices.push_back(model);
+    m_localBounds.push_back(localBounds);
+    m_structureChanged = true;
+    return (int)m_instances.size() - 1;
+}
+
+// Moves an instance
+// @param instance: Index returned by AddInstance
+// @param model: New world matrix
+void GpuCulling::SetInstanceTransform(int instance, const glm::mat4& model) {
+    AABB worldBounds = m_localBounds[instance].Transformed(model);
+    m_instances[instance].boundsMin = glm::vec4(worldBounds.min, 0.0f);
+    m_instances[instance].boundsMax = glm::vec4(worldBounds.max, 0.0f);
+    m_matrices[instance] = model;
+
+    if (m_dirtyBegin == m_dirtyEnd) {
+        m_dirtyBegin = instance;
+        m_dirtyEnd = instance + 1;
+    } else {
+        m_dirtyBegin = std::min(m_dirtyBegin, (size_t)instance);
+        m_dirtyEnd = std::max(m_dirtyEnd, (size_t)instance + 1);
+    }
+}
+
+// Removes every instance
+void GpuCulling::Clear() {
+    m_instances.clear();
+    m_matrices.clear();
+    m_localBounds.clear();
+    m_meshes.clear();
+    m_structureChanged = true;
+}
+
+// Creates a buffer if needed and replaces its contents
+// @param target: Binding point to upload through
+// @param buffer: The buffer, created if 0
+// @param size, data: The new contents, data may be nullptr
+void GpuCulling::Allocate(GLenum target, GLuint& buffer, GLsizeiptr size, const void* data) {
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+    }
+    GLState::BindBuffer(target, buffer);
+    glBufferData(target, size, data, GL_DYNAMIC_DRAW);
+}
+
+// Replaces part of a buffer the last frame's commands may still be using
+// @param buffer: Destination
+// @param offset, size, data: The range to replace and its new contents
+void GpuCulling::Write(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data) {
+    FrameRing::Allocation staging;
+    if (m_ring != nullptr && m_ring->Allocate(size, 16, staging)) {
+        std::memcpy(staging.data, data, size);
+        GLState::BindBuffer(GL_COPY_READ_BUFFER, staging.buffer);
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, staging.offset, offset, size);
+        return;
+    }
+    GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
+
+// Uploads everything after instances were added, otherwise only the
+// range of instances that moved
+void GpuCulling::Upload() {
+    if (m_structureChanged) {
+        // Give every mesh a slice of the visible list large enough for all its instances
+        std::vector<GLuint> counts(m_meshes.size(), 0);
+        for (size_t i = 0; i < m_instances.size(); ++i) {
+            ++counts[m_instances[i].mesh];
+        }
+        GLuint offset = 0;
+        for (size_t m = 0; m < m_meshes.size(); ++m) {
+            m_meshes[m].baseInstance = offset;
+            offset += counts[m];
+        }
+
+        Allocate(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer, m_instances.size() * sizeof(GpuInstance), m_instances.data());
+        Allocate(GL_SHADER_STORAGE_BUFFER, m_matrixBuffer, m_matrices.size() * sizeof(glm::mat4), m_matrices.data());
+        Allocate(GL_SHADER_STORAGE_BUFFER, m_commandBuffer, m_meshes.size() * sizeof(DrawElementsIndirectCommand), m_meshes.data());
+        Allocate(GL_SHADER_STORAGE_BUFFER, m_visibleBuffer, m_instances.size() * sizeof(GLuint), nullptr);
+        m_structureChanged = false;
+    } else if (m_dirtyBegin < m_dirtyEnd) {
+        size_t count = m_dirtyEnd - m_dirtyBegin;
+        Write(m_instanceBuffer, m_dirtyBegin * sizeof(GpuInstance), count * sizeof(GpuInstance), &m_instances[m_dirtyBegin]);
+        Write(m_matrixBuffer, m_dirtyBegin * sizeof(glm::mat4), count * sizeof(glm::mat4), &m_matrices[m_dirtyBegin]);
+    }
+    m_dirtyBegin = m_dirtyEnd = 0;
+}
+
+// Culls every instance on the GPU. The commands' instance counts start at
+// zero and the compute shader counts the visible instances into them.
+// @param viewProjection: projection x view matrix of this frame
+void GpuCulling::Cull(const glm::mat4& viewProjection) {
+    m_viewProjection = viewProjection;
+    if (!m_initialized || m_instances.empty()) {
+        return;
+    }
+    Upload();
+
+    // Reset the instance counts, a fixed cost of one command per mesh
+    Write(m_commandBuffer, 0, m_meshes.size() * sizeof(DrawElementsIndirectCommand), m_meshes.data());
+
+    Frustum frustum;
+    frustum.Extract(viewProjection);
+    glm::vec4 planes[6];
+    for (int i = 0; i < 6; ++i) {
+        planes[i] = frustum.GetPlane(i);
+    }
+
+    m_cullShader.Bind();
+    m_cullShader.SetUniform4fv("u_FrustumPlanes", 6, &planes[0][0]);
+    m_cullShader.SetUniformMatrix4fv("u_PyramidViewProjection", &m_pyramidViewProjection[0][0]);
+    m_cullShader.SetUniform1i("u_HasDepthPyramid", m_hasDepthPyramid ? 1 : 0);
+    m_cullShader.SetUniform1i("u_PyramidLevels", m_pyramidLevels);
+    m_cullShader.SetUniform1i("u_InstanceCount", (int)m_instances.size());
+    m_cullShader.SetUniform1i("u_DepthPyramid", 0);
+    GLState::ActiveTexture(GL_TEXTURE0);
+    GLState::BindTexture(GL_TEXTURE_2D, m_depthPyramid);
+
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_instanceBuffer);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_commandBuffer);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_visibleBuffer);
+
+    glDispatchCompute(((GLuint)m_instances.size() + s_cullGroupSize - 1) / s_cullGroupSize, 1, 1);
+
+    // The draw reads the commands, and the visible list as a vertex attribute
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// Draws the instances Cull kept, one command per mesh in a single call
+// @param view, projection: Camera matrices of this frame
+void GpuCulling::Draw(const glm::mat4& view, const glm::mat4& projection) {
+    if (!m_initialized || m_instances.empty() || m_pool == nullptr) {
+        return;
+    }
+
+    m_drawShader.Bind();
+    m_drawShader.SetUniformMatrix4fv("view", &view[0][0]);
+    m_drawShader.SetUniformMatrix4fv("projection", &projection[0][0]);
+    GLState::ActiveTexture(GL_TEXTURE0);
+    GLState::BindTexture(GL_TEXTURE_2D, m_texture);
+
+    // Instance i of mesh m reads visible[baseInstance + i], the index of its matrix
+    GLState::BindVertexArray(m_pool->GetVertexArray());
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_visibleBuffer);
+    glEnableVertexAttribArray(s_instanceAttribute);
+    glVertexAttribIPointer(s_instanceAttribute, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    glVertexAttribDivisor(s_instanceAttribute, 1);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_matrixBuffer);
+
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)m_meshes.size(), 0);
+}
+
+// Allocates the depth copy and a full mip chain for the pyramid
+// @param width, height: Size of the framebuffer
+void GpuCulling::ResizeDepthPyramid(int width, int height) {
+    if (width == m_pyramidWidth && height == m_pyramidHeight && m_depthPyramid != 0) {
+        return;
+    }
+    // Immutable storage cannot be resized, so start from new textures
+    if (m_depthTexture != 0) {
+        GLState::DeleteTextures(1, &m_depthTexture);
+        GLState::DeleteTextures(1, &m_depthPyramid);
+    }
+    m_pyramidWidth = width;
+    m_pyramidHeight = height;
+    m_pyramidLevels = 1;
+    while ((std::max(width, height) >> m_pyramidLevels) > 0) {
+        ++m_pyramidLevels;
+    }
+
+    glGenTextures(1, &m_depthTexture);
+    GLState::BindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    glGenTextures(1, &m_depthPyramid);
+    GLState::BindTexture(GL_TEXTURE_2D, m_depthPyramid);
+    glTexStorage2D(GL_TEXTURE_2D, m_pyramidLevels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+    m_hasDepthPyramid = false;
+}
+
+// Copies the depth buffer and reduces it level by level, keeping the
+// farthest depth of every 2x2 block (3x3 at odd edges, so no texel is lost)
+// @param width, height: Size of the bound framebuffer
+void GpuCulling::BuildDepthPyramid(int width, int height) {
+    if (!m_initialized || m_instances.empty()) {
+        return;
+    }
+    ResizeDepthPyramid(width, height);
+
+    // The window's depth buffer cannot be sampled, copy it into a texture
+    GLState::BindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+    m_depthPyramidShader.Bind();
+    m_depthPyramidShader.SetUniform1i("u_Source", 0);
+    GLState::ActiveTexture(GL_TEXTURE0);
+    for (int level = 0; level < m_pyramidLevels; ++level) {
+        int levelWidth = std::max(1, width >> level);
+        int levelHeight = std::max(1, height >> level);
+
+        // Level 0 copies the depth texture, the others reduce the level above
+        GLState::BindTexture(GL_TEXTURE_2D, level == 0 ? m_depthTexture : m_depthPyramid);
+        m_depthPyramidShader.SetUniform1i("u_SourceLevel", level == 0 ? 0 : level - 1);
+        m_depthPyramidShader.SetUniform1i("u_Reduce", level == 0 ? 0 : 1);
+        GLState::BindImageTexture(0, m_depthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        glDispatchCompute((levelWidth + s_pyramidTileSize - 1) / s_pyramidTileSize,
+                          (levelHeight + s_pyramidTileSize - 1) / s_pyramidTileSize, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    m_hasDepthPyramid = true;
+    m_pyramidViewProjection = m_viewProjection;
+}
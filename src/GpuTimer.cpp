@@ -0,0 +1,64 @@
+#include "GpuTimer.hpp"
+
+// Constructor: queries are created on first use, once a context exists
+GpuTimer::GpuTimer() {}
+
+// Destructor: Deletes the queries
+GpuTimer::~GpuTimer() {
+    if (m_created) {
+        glDeleteQueries(s_queryCount, m_queries);
+    }
+}
+
+// Starts a GL_TIME_ELAPSED query
+void GpuTimer::Begin() {
+    if (!m_created) {
+        glGenQueries(s_queryCount, m_queries);
+        m_created = true;
+    }
+    // All queries are in flight: drop the oldest unread result
+    if (m_pending == s_queryCount) {
+        --m_pending;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_head]);
+}
+
+// Ends the current query
+void GpuTimer::End() {
+    glEndQuery(GL_TIME_ELAPSED);
+    m_head = (m_head + 1) % s_queryCount;
+    ++m_pending;
+}
+
+// Reads the oldest pending query if the GPU has finished it
+// @param milliseconds: Receives the measured GPU time
+// @return true if a measurement was read
+bool GpuTimer::Poll(double& milliseconds) {
+    if (m_pending == 0) {
+        return false;
+    }
+    GLuint query = m_queries[(m_head - m_pending + s_queryCount) % s_queryCount];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    --m_pending;
+    milliseconds = nanoseconds / 1.0e6;
+    return true;
+}
+
+// Waits for the most recent query, discarding any older ones
+// @return The measured GPU time in milliseconds
+double GpuTimer::WaitElapsedMs() {
+    if (m_pending == 0) {
+        return 0.0;
+    }
+    GLuint query = m_queries[(m_head - 1 + s_queryCount) % s_queryCount];
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    m_pending = 0;
+    return nanoseconds / 1.0e6;
+}
@@ -0,0 +1,59 @@
+#include "InputQueue.hpp"
+#include "FramePacer.hpp"
+
+// Constructor
+InputQueue::InputQueue() : m_dropped(0), m_installed(false) {}
+
+// Destructor
+InputQueue::~InputQueue() {
+    if (m_installed) {
+        SDL_SetEventFilter(nullptr, nullptr);
+    }
+}
+
+// Routes SDL's input events into this queue
+void InputQueue::Install() {
+    SDL_SetEventFilter(&InputQueue::Filter, this);
+    m_installed = true;
+}
+
+// Delivers pending events to the filter
+void InputQueue::Pump() {
+    SDL_PumpEvents();
+    // What the filter let through is not handled, and would pile up
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+}
+
+// Converts the events the program handles into InputEvents
+// @param userdata: The InputQueue
+// @param event: The event SDL received
+// @return 0 to drop the event from SDL's queue, 1 to keep it
+int SDLCALL InputQueue::Filter(void* userdata, SDL_Event* event) {
+    InputQueue* queue = static_cast<InputQueue*>(userdata);
+    InputEvent input;
+    input.time = FramePacer::Now();
+    input.x = 0;
+    input.y = 0;
+    input.key = 0;
+    switch (event->type) {
+        case SDL_QUIT:
+            input.type = InputEventQuit;
+            break;
+        case SDL_MOUSEMOTION:
+            input.type = InputEventMouseMotion;
+            input.x = event->motion.x;
+            input.y = event->motion.y;
+            break;
+        case SDL_KEYDOWN:
+            input.type = InputEventKeyDown;
+            input.key = event->key.keysym.sym;
+            break;
+        default:
+            // Everything else stays in SDL's queue
+            return 1;
+    }
+    if (!queue->m_events.Push(input)) {
+        queue->m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    return 0;
+}
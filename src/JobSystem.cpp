@@ -0,0 +1,272 @@
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+
+#include <iostream>
+
+// Which JobSystem the current thread works for, and its queue index there
+static thread_local const JobSystem* t_jobSystem = nullptr;
+static thread_local unsigned int t_threadIndex = 0;
+
+// Constructor: starts the worker threads
+// @param workerCount: Number of worker threads besides the calling thread,
+//                     -1 for one per remaining hardware thread
+JobSystem::JobSystem(int workerCount) : m_registeredThreads(0), m_queuedJobs(0) {
+    if (workerCount < 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = (hardwareThreads > 1) ? (int)hardwareThreads - 1 : 0;
+    }
+    m_mainThreadId = std::this_thread::get_id();
+
+    // Queue 0 belongs to the creating thread, registered threads come last.
+    // All are made now: workers read m_queues without a lock.
+    for (int i = 0; i < workerCount + 1 + (int)s_registeredQueues; ++i) {
+        m_queues.push_back(new WorkQueue());
+    }
+    for (int i = 1; i < workerCount + 1; ++i) {
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, (unsigned int)i);
+    }
+    std::cout << "JobSystem created with " << workerCount << " worker threads" << std::endl;
+}
+
+// Destructor: lets the workers drain their queues, then joins them
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i].join();
+    }
+    for (size_t i = 0; i < m_queues.size(); ++i) {
+        delete m_queues[i];
+    }
+}
+
+// Appends a job, doubling the ring when it is full
+// @param job, counter: The job and its optional counter
+void JobSystem::WorkQueue::PushBack(Job&& job, JobCounter* counter) {
+    if (count == slots.size()) {
+        // Unroll the ring into a larger one, oldest job first
+        std::vector<QueuedJob> grown(slots.empty() ? 64 : slots.size() * 2);
+        for (size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(slots[(head + i) % slots.size()]);
+        }
+        slots.swap(grown);
+        head = 0;
+    }
+    QueuedJob& slot = slots[(head + count) % slots.size()];
+    slot.first = std::move(job);
+    slot.second = counter;
+    ++count;
+}
+
+// Takes the newest job
+// @param job: Receives the job
+// @return false if the queue is empty
+bool JobSystem::WorkQueue::PopBack(QueuedJob& job) {
+    if (count == 0) {
+        return false;
+    }
+    --count;
+    QueuedJob& slot = slots[(head + count) % slots.size()];
+    job = std::move(slot);
+    slot.first = nullptr;
+    return true;
+}
+
+// Takes the oldest job
+// @param job: Receives the job
+// @return false if the queue is empty
+bool JobSystem::WorkQueue::PopFront(QueuedJob& job) {
+    if (count == 0) {
+        return false;
+    }
+    QueuedJob& slot = slots[head];
+    job = std::move(slot);
+    slot.first = nullptr;
+    head = (head + 1) % slots.size();
+    --count;
+    return true;
+}
+
+// Returns the engine wide job system
+JobSystem& JobSystem::Get() {
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+// Index of the calling thread's queue. Threads that are neither workers
+// nor registered share the GL thread's queue.
+unsigned int JobSystem::GetThreadIndex() const {
+    return (t_jobSystem == this) ? t_threadIndex : 0;
+}
+
+// Gives the calling thread one of the queues kept for registered threads
+// @return false if none is left
+bool JobSystem::RegisterThread() {
+    if (GetThreadIndex() != 0 || IsMainThread()) {
+        return true;
+    }
+    unsigned int slot = m_registeredThreads.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= s_registeredQueues) {
+        std::cout << "JobSystem: no queue left to register a thread, it shares the GL thread's" << std::endl;
+        return false;
+    }
+    t_jobSystem = this;
+    t_threadIndex = (unsigned int)m_workers.size() + 1 + slot;
+    return true;
+}
+
+// Queues a job on the calling thread's deque
+// @param job: The work to do
+// @param counter: Optional counter, decremented once the job finished
+void JobSystem::Run(Job job, JobCounter* counter) {
+    if (counter != nullptr) {
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    WorkQueue* queue = m_queues[GetThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->PushBack(std::move(job), counter);
+    }
+    m_queuedJobs.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders this with a worker about to sleep, so the
+    // notification cannot be lost
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wake.notify_one();
+}
+
+// Runs one job: the newest of the own queue, else the oldest of another
+// @param index: Queue index of the calling thread
+// @param steal: Look in the other queues when the own one is empty
+// @return true if a job was run
+bool JobSystem::TryRunJob(unsigned int index, bool steal) {
+    QueuedJob item;
+    bool found = false;
+
+    WorkQueue* own = m_queues[index];
+    {
+        std::lock_guard<std::mutex> lock(own->mutex);
+        found = own->PopBack(item);
+    }
+
+    // Steal, starting with the next queue so thieves spread out
+    const unsigned int queueCount = (unsigned int)m_queues.size();
+    for (unsigned int k = 1; steal && !found && k < queueCount; ++k) {
+        WorkQueue* victim = m_queues[(index + k) % queueCount];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        found = victim->PopFront(item);
+    }
+
+    if (!found) {
+        return false;
+    }
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    {
+        PROFILE_SCOPE("Job");
+        item.first();
+    }
+    if (item.second != nullptr) {
+        item.second->m_count.fetch_sub(1, std::memory_order_release);
+    }
+    return true;
+}
+
+// Runs jobs on the calling thread until the counter reaches zero. A worker
+// may steal any job meanwhile; the GL thread and registered threads only
+// run the jobs of their own queue, which they queued themselves, so a wait
+// is not held up by another thread's batch.
+// @param counter: Counter of the batch to wait for
+void JobSystem::Wait(JobCounter& counter) {
+    unsigned int index = GetThreadIndex();
+    const bool isWorker = (index != 0 && index <= m_workers.size());
+    while (!counter.IsDone()) {
+        if (!TryRunJob(index, isWorker)) {
+            // The remaining jobs are running elsewhere
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Splits [begin, end) into chunks and runs body on each of them in parallel
+// @param begin, end: Index range
+// @param grainSize: Largest chunk handed to one job
+// @param body: Called with the begin and end of each chunk
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grainSize,
+                            void (*body)(const void* context, size_t begin, size_t end), const void* context) {
+    if (end <= begin) {
+        return;
+    }
+    if (grainSize == 0) {
+        grainSize = 1;
+    }
+    // Not worth a job
+    if (end - begin <= grainSize || m_workers.empty()) {
+        body(context, begin, end);
+        return;
+    }
+
+    // The jobs only capture this and their first index, which fits in
+    // std::function's own storage, so queuing them allocates nothing
+    struct Range{
+        void (*body)(const void*, size_t, size_t);
+        const void* context;
+        size_t end;
+        size_t grainSize;
+    };
+    const Range range = { body, context, end, grainSize };
+    const Range* shared = &range;
+
+    JobCounter counter;
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+        Run([shared, chunkBegin]() {
+            size_t chunkEnd = (shared->end - chunkBegin > shared->grainSize) ? chunkBegin + shared->grainSize : shared->end;
+            shared->body(shared->context, chunkBegin, chunkEnd);
+        }, &counter);
+    }
+    Wait(counter);
+}
+
+// Queues a job for the GL thread
+// @param job: The work to do, typically OpenGL calls
+void JobSystem::RunOnMainThread(Job job) {
+    std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+    m_mainThreadJobs.push_back(std::move(job));
+}
+
+// Runs the jobs queued for the GL thread
+void JobSystem::PumpMainThread() {
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+        jobs.swap(m_mainThreadJobs);
+    }
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        jobs[i]();
+    }
+}
+
+// Worker thread: runs jobs, sleeps when there are none
+// @param index: Queue index of this worker
+void JobSystem::WorkerLoop(unsigned int index) {
+    t_jobSystem = this;
+    t_threadIndex = index;
+    PROFILE_THREAD_NAME("Worker " + std::to_string(index));
+
+    while (true) {
+        if (TryRunJob(index, true)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait(lock, [this]() {
+            return m_stopping || m_queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stopping && m_queuedJobs.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
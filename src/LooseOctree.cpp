@@ -0,0 +1,354 @@
+#include "LooseOctree.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <queue>
+#include <utility>
+
+const int LooseOctree::s_invalidHandle;
+const int LooseOctree::s_overflowCell;
+
+// Squared distance from a point to a box, 0 inside
+static float DistanceSquared(const glm::vec3& p, const AABB& box) {
+    glm::vec3 below = glm::max(box.min - p, glm::vec3(0.0f));
+    glm::vec3 above = glm::max(p - box.max, glm::vec3(0.0f));
+    glm::vec3 d = below + above;
+    return glm::dot(d, d);
+}
+
+// Slab test of a ray against a box
+// @param tEntry: Distance along the ray where it enters the box (0 if it starts inside)
+static bool RayIntersects(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& box, float& tEntry) {
+    glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    tEntry = enter;
+    return enter <= exit;
+}
+
+// True if two boxes overlap
+static bool Overlaps(const AABB& a, const AABB& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// Constructor: creates the root cell
+// @param center, halfSize: The cube covered by the root cell
+// @param maxDepth: Depth of the smallest cells
+LooseOctree::LooseOctree(const glm::vec3& center, float halfSize, int maxDepth)
+    : m_center(center), m_halfSize(halfSize), m_maxDepth(maxDepth) {
+    Clear();
+}
+
+// Removes all items, keeps only the root cell
+void LooseOctree::Clear() {
+    m_cells.clear();
+    m_items.clear();
+    m_freeItems.clear();
+    m_overflow.clear();
+    m_itemCount = 0;
+
+    Cell root;
+    root.center = m_center;
+    root.halfSize = m_halfSize;
+    root.depth = 0;
+    std::fill(root.children, root.children + 8, s_invalidHandle);
+    m_cells.push_back(root);
+}
+
+// Bounds every item stored in a cell lies in
+AABB LooseOctree::GetLooseBounds(const Cell& cell) const {
+    glm::vec3 looseHalf(cell.halfSize * 2.0f);
+    return AABB(cell.center - looseHalf, cell.center + looseHalf);
+}
+
+// Finds the deepest cell at least as large as the item that contains its
+// center. Its loose bounds then contain the whole item.
+// @param bounds: Bounds of the item
+// @return The cell index, or s_overflowCell
+int LooseOctree::FindCell(const AABB& bounds) {
+    glm::vec3 center = bounds.GetCenter();
+    glm::vec3 extents = bounds.GetExtents();
+    float itemHalfSize = std::max(std::max(extents.x, extents.y), extents.z);
+
+    glm::vec3 offset = glm::abs(center - m_center);
+    if (itemHalfSize > m_halfSize || offset.x > m_halfSize || offset.y > m_halfSize || offset.z > m_halfSize) {
+        return s_overflowCell;
+    }
+
+    int cell = 0;
+    while (m_cells[cell].depth < m_maxDepth) {
+        float childHalfSize = m_cells[cell].halfSize * 0.5f;
+        if (itemHalfSize > childHalfSize) {
+            break;
+        }
+        const glm::vec3 cellCenter = m_cells[cell].center;
+        int octant = (center.x >= cellCenter.x ? 1 : 0) |
+                     (center.y >= cellCenter.y ? 2 : 0) |
+                     (center.z >= cellCenter.z ? 4 : 0);
+        int child = m_cells[cell].children[octant];
+        if (child == s_invalidHandle) {
+            Cell newCell;
+            newCell.center = cellCenter + glm::vec3((octant & 1) ? childHalfSize : -childHalfSize,
+                                                    (octant & 2) ? childHalfSize : -childHalfSize,
+                                                    (octant & 4) ? childHalfSize : -childHalfSize);
+            newCell.halfSize = childHalfSize;
+            newCell.depth = m_cells[cell].depth + 1;
+            std::fill(newCell.children, newCell.children + 8, s_invalidHandle);
+            child = (int)m_cells.size();
+            // m_cells may reallocate, write the link through the index
+            m_cells.push_back(newCell);
+            m_cells[cell].children[octant] = child;
+        }
+        cell = child;
+    }
+    return cell;
+}
+
+// Stores an item in a cell
+void LooseOctree::Link(int handle, int cell) {
+    std::vector<int>& items = GetCellItems(cell);
+    m_items[handle].cell = cell;
+    m_items[handle].slot = (int)items.size();
+    items.push_back(handle);
+}
+
+// Takes an item out of its cell (swap with the cell's last item)
+void LooseOctree::Unlink(int handle) {
+    std::vector<int>& items = GetCellItems(m_items[handle].cell);
+    int slot = m_items[handle].slot;
+    int last = items.back();
+    items[slot] = last;
+    m_items[last].slot = slot;
+    items.pop_back();
+}
+
+// Adds an item
+// @param bounds: World space bounds of the item
+// @param userData: Value queries report for this item
+// @return The item's handle
+int LooseOctree::Insert(const AABB& bounds, int userData) {
+    int handle;
+    if (!m_freeItems.empty()) {
+        handle = m_freeItems.back();
+        m_freeItems.pop_back();
+    } else {
+        handle = (int)m_items.size();
+        m_items.emplace_back();
+    }
+    m_items[handle].bounds = bounds;
+    m_items[handle].userData = userData;
+    Link(handle, FindCell(bounds));
+    ++m_itemCount;
+    return handle;
+}
+
+// Moves an item, relinking it only if it belongs to another cell now
+// @param handle: Handle returned by Insert
+// @param bounds: New world space bounds
+void LooseOctree::Update(int handle, const AABB& bounds) {
+    m_items[handle].bounds = bounds;
+    int cell = FindCell(bounds);
+    if (cell != m_items[handle].cell) {
+        Unlink(handle);
+        Link(handle, cell);
+    }
+}
+
+// Removes an item
+// @param handle: Handle returned by Insert
+void LooseOctree::Remove(int handle) {
+    Unlink(handle);
+    m_items[handle].cell = s_invalidHandle;
+    m_freeItems.push_back(handle);
+    --m_itemCount;
+}
+
+// Depth first walk over the cells that pass cellTest
+template <typename CellTest, typename Visit>
+void LooseOctree::Traverse(const CellTest& cellTest, const Visit& visit) const {
+    for (size_t i = 0; i < m_overflow.size(); ++i) {
+        visit(m_overflow[i]);
+    }
+
+    int stack[64 * 8];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Cell& cell = m_cells[stack[--stackSize]];
+        if (!cellTest(GetLooseBounds(cell))) {
+            continue;
+        }
+        for (size_t i = 0; i < cell.items.size(); ++i) {
+            visit(cell.items[i]);
+        }
+        for (int c = 0; c < 8; ++c) {
+            if (cell.children[c] != s_invalidHandle) {
+                stack[stackSize++] = cell.children[c];
+            }
+        }
+    }
+}
+
+// Items intersecting a box
+// @param box: World space box
+// @param results: Receives the user data of the matches
+void LooseOctree::QueryAABB(const AABB& box, std::vector<int>& results) const {
+    Traverse([&box](const AABB& cellBounds) { return Overlaps(cellBounds, box); },
+             [this, &box, &results](int handle) {
+                 if (Overlaps(m_items[handle].bounds, box)) {
+                     results.push_back(m_items[handle].userData);
+                 }
+             });
+}
+
+// Items intersecting a sphere
+// @param sphere: World space sphere
+// @param results: Receives the user data of the matches
+void LooseOctree::QuerySphere(const BoundingSphere& sphere, std::vector<int>& results) const {
+    const float radiusSquared = sphere.radius * sphere.radius;
+    Traverse([&sphere, radiusSquared](const AABB& cellBounds) { return DistanceSquared(sphere.center, cellBounds) <= radiusSquared; },
+             [this, &sphere, radiusSquared, &results](int handle) {
+                 if (DistanceSquared(sphere.center, m_items[handle].bounds) <= radiusSquared) {
+                     results.push_back(m_items[handle].userData);
+                 }
+             });
+}
+
+// Items intersecting a frustum
+// @param frustum: The view volume
+// @param results: Receives the user data of the matches
+void LooseOctree::QueryFrustum(const Frustum& frustum, std::vector<int>& results) const {
+    Traverse([&frustum](const AABB& cellBounds) { return frustum.Intersects(cellBounds); },
+             [this, &frustum, &results](int handle) {
+                 if (frustum.Intersects(m_items[handle].bounds)) {
+                     results.push_back(m_items[handle].userData);
+                 }
+             });
+}
+
+// The k items nearest to a point. Cells are visited nearest first and the
+// search stops once the next cell is further than the k-th best item.
+// @param point: World space position
+// @param k: Number of items wanted
+// @param results: Receives the user data of the matches, nearest first
+void LooseOctree::QueryNearest(const glm::vec3& point, size_t k, std::vector<int>& results) const {
+    if (k == 0 || m_itemCount == 0) {
+        return;
+    }
+    typedef std::pair<float, int> Entry; // squared distance, cell or handle
+    // Best items so far, worst on top
+    std::priority_queue<Entry> best;
+    // Cells to visit, nearest on top
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> cells;
+
+    auto consider = [this, &point, k, &best](int handle) {
+        float d = DistanceSquared(point, m_items[handle].bounds);
+        if (best.size() < k) {
+            best.push(Entry(d, handle));
+        } else if (d < best.top().first) {
+            best.pop();
+            best.push(Entry(d, handle));
+        }
+    };
+
+    for (size_t i = 0; i < m_overflow.size(); ++i) {
+        consider(m_overflow[i]);
+    }
+    cells.push(Entry(DistanceSquared(point, GetLooseBounds(m_cells[0])), 0));
+    while (!cells.empty()) {
+        Entry next = cells.top();
+        cells.pop();
+        if (best.size() == k && next.first > best.top().first) {
+            break;
+        }
+        const Cell& cell = m_cells[next.second];
+        for (size_t i = 0; i < cell.items.size(); ++i) {
+            consider(cell.items[i]);
+        }
+        for (int c = 0; c < 8; ++c) {
+            if (cell.children[c] != s_invalidHandle) {
+                cells.push(Entry(DistanceSquared(point, GetLooseBounds(m_cells[cell.children[c]])), cell.children[c]));
+            }
+        }
+    }
+
+    size_t first = results.size();
+    results.resize(first + best.size());
+    for (size_t i = results.size(); i > first; --i) {
+        results[i - 1] = m_items[best.top().second].userData;
+        best.pop();
+    }
+}
+
+// The first item along a ray
+// @param origin, direction: The ray
+// @param userData: Receives the user data of the hit item
+// @param distance: Receives the distance (in units of direction) to the hit
+// @return false if the ray hits nothing
+bool LooseOctree::QueryRay(const glm::vec3& origin, const glm::vec3& direction, int& userData, float& distance) const {
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    float bestDistance = FLT_MAX;
+    int bestHandle = s_invalidHandle;
+
+    Traverse([&origin, &inverseDirection, &bestDistance](const AABB& cellBounds) {
+                 float tEntry;
+                 return RayIntersects(origin, inverseDirection, cellBounds, tEntry) && tEntry < bestDistance;
+             },
+             [this, &origin, &inverseDirection, &bestDistance, &bestHandle](int handle) {
+                 float tEntry;
+                 if (RayIntersects(origin, inverseDirection, m_items[handle].bounds, tEntry) && tEntry < bestDistance) {
+                     bestDistance = tEntry;
+                     bestHandle = handle;
+                 }
+             });
+
+    if (bestHandle == s_invalidHandle) {
+        return false;
+    }
+    userData = m_items[bestHandle].userData;
+    distance = bestDistance;
+    return true;
+}
+
+// Runs a batch of queries
+// @param queries: The queries
+// @param results: Resized to the number of queries, results[i] holds the matches of queries[i]
+// @param jobs: Threads to run the queries on, nullptr to run them here
+void LooseOctree::QueryBatch(const std::vector<OctreeQuery>& queries, std::vector<std::vector<int>>& results, JobSystem* jobs) const {
+    results.resize(queries.size());
+    auto runQueries = [this, &queries, &results](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const OctreeQuery& query = queries[i];
+            results[i].clear();
+            switch (query.type) {
+                case OctreeQuery::Box:
+                    QueryAABB(query.box, results[i]);
+                    break;
+                case OctreeQuery::Sphere:
+                    QuerySphere(query.sphere, results[i]);
+                    break;
+                case OctreeQuery::FrustumVolume:
+                    if (query.frustum != nullptr) {
+                        QueryFrustum(*query.frustum, results[i]);
+                    }
+                    break;
+                case OctreeQuery::Nearest:
+                    QueryNearest(query.point, query.count, results[i]);
+                    break;
+            }
+        }
+    };
+
+    if (jobs != nullptr) {
+        jobs->ParallelFor(0, queries.size(), 16, runQueries);
+    } else {
+        runQueries(0, queries.size());
+    }
+}
@@ -0,0 +1,194 @@
+#include "MeshPool.hpp"
+#include "Profiler.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+// Constructor
+// @param vertexCapacity, indexCapacity: Initial size of the buffers
+MeshPool::MeshPool(GLuint vertexCapacity, GLuint indexCapacity)
+    : m_vertexArray(0), m_vertexBuffer(0), m_indexBuffer(0),
+      m_vertexCapacity(vertexCapacity), m_indexCapacity(indexCapacity), m_meshCount(0) {}
+
+// Destructor
+MeshPool::~MeshPool() {
+    if (m_vertexArray != 0) {
+        GLState::DeleteVertexArrays(1, &m_vertexArray);
+        GLState::DeleteBuffers(1, &m_vertexBuffer);
+        GLState::DeleteBuffers(1, &m_indexBuffer);
+    }
+}
+
+// Returns the pool Objects are placed in unless told otherwise
+MeshPool& MeshPool::GetDefault() {
+    static MeshPool defaultPool;
+    return defaultPool;
+}
+
+// First fit allocation
+// @param freeRanges: Free space of the buffer
+// @param count: Number of elements needed
+// @param offset: Receives the first element of the allocation
+// @return false if no free range is large enough
+bool MeshPool::Allocate(std::vector<FreeRange>& freeRanges, GLuint count, GLuint& offset) {
+    for (size_t i = 0; i < freeRanges.size(); ++i) {
+        if (freeRanges[i].count >= count) {
+            offset = freeRanges[i].offset;
+            freeRanges[i].offset += count;
+            freeRanges[i].count -= count;
+            if (freeRanges[i].count == 0) {
+                freeRanges.erase(freeRanges.begin() + i);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns a range to the free list, merging it with adjacent free ranges
+// @param freeRanges: Free space of the buffer
+// @param offset, count: The range to free
+void MeshPool::Free(std::vector<FreeRange>& freeRanges, GLuint offset, GLuint count) {
+    if (count == 0) {
+        return;
+    }
+    auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset,
+                                 [](const FreeRange& range, GLuint value) { return range.offset < value; });
+    next = freeRanges.insert(next, FreeRange{ offset, count });
+
+    // Merge with the following range, then with the previous one
+    auto following = next + 1;
+    if (following != freeRanges.end() && next->offset + next->count == following->offset) {
+        next->count += following->count;
+        freeRanges.erase(following);
+    }
+    if (next != freeRanges.begin()) {
+        auto previous = next - 1;
+        if (previous->offset + previous->count == next->offset) {
+            previous->count += next->count;
+            freeRanges.erase(next);
+        }
+    }
+}
+
+// Creates the vertex and index buffers at their initial capacity
+void MeshPool::Create() {
+    glGenVertexArrays(1, &m_vertexArray);
+    GLState::BindVertexArray(m_vertexArray);
+
+    glGenBuffers(1, &m_vertexBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)m_vertexCapacity * s_stride * sizeof(float), nullptr, GL_STATIC_DRAW);
+    SetupVertexArray();
+
+    glGenBuffers(1, &m_indexBuffer);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)m_indexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    GLState::BindVertexArray(0);
+
+    m_freeVertices.push_back(FreeRange{ 0, m_vertexCapacity });
+    m_freeIndices.push_back(FreeRange{ 0, m_indexCapacity });
+}
+
+// Points attributes 0 to 3 of the bound vertex array at the vertex buffer,
+// same layout as VertexBufferLayout::CreateSkyboxBufferLayout
+void MeshPool::SetupVertexArray() {
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+
+    glEnableVertexAttribArray(0); // Position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * s_stride, 0);
+
+    glEnableVertexAttribArray(1); // Color
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * s_stride, (char*)(sizeof(float) * 3));
+
+    glEnableVertexAttribArray(2); // Normal
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(float) * s_stride, (char*)(sizeof(float) * 6));
+
+    glEnableVertexAttribArray(3); // Texture coordinates
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * s_stride, (char*)(sizeof(float) * 9));
+}
+
+// Replaces a buffer by a larger one, copying the old contents on the GPU
+// @param target: GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+// @param buffer, capacity, freeRanges: The buffer to grow
+// @param elementSize: Bytes per element
+// @param count: Elements the caller failed to allocate
+void MeshPool::Grow(GLenum target, GLuint& buffer, GLuint& capacity, std::vector<FreeRange>& freeRanges, GLuint elementSize, GLuint count) {
+    GLuint newCapacity = std::max(capacity * 2, capacity + count);
+
+    GLuint newBuffer = 0;
+    glGenBuffers(1, &newBuffer);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)newCapacity * elementSize, nullptr, GL_STATIC_DRAW);
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)capacity * elementSize);
+    GLState::DeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+
+    Free(freeRanges, capacity, newCapacity - capacity);
+    capacity = newCapacity;
+
+    // The vertex array refers to the old buffer
+    GLState::BindVertexArray(m_vertexArray);
+    if (target == GL_ARRAY_BUFFER) {
+        SetupVertexArray();
+    } else {
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    }
+    GLState::BindVertexArray(0);
+
+    FlightRecorder::Count(FlightCounter::Allocations);
+    std::cout << "MeshPool: grew " << (target == GL_ARRAY_BUFFER ? "vertex" : "index")
+              << " buffer to " << newCapacity << " elements" << std::endl;
+}
+
+// Copies a mesh into the pool's buffers
+// @param vertexData: vertexCount * 11 floats
+// @param vertexCount: Number of vertices
+// @param indices: Indices into the mesh's own vertices
+// @param indexCount: Number of indices
+// @return Where the mesh was placed
+MeshRange MeshPool::Add(const float* vertexData, GLuint vertexCount, const unsigned int* indices, GLuint indexCount) {
+    PROFILE_SCOPE("MeshPoolUpload");
+    if (m_vertexArray == 0) {
+        Create();
+    }
+
+    GLuint vertexOffset = 0, indexOffset = 0;
+    if (!Allocate(m_freeVertices, vertexCount, vertexOffset)) {
+        Grow(GL_ARRAY_BUFFER, m_vertexBuffer, m_vertexCapacity, m_freeVertices, s_stride * sizeof(float), vertexCount);
+        Allocate(m_freeVertices, vertexCount, vertexOffset);
+    }
+    if (!Allocate(m_freeIndices, indexCount, indexOffset)) {
+        Grow(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer, m_indexCapacity, m_freeIndices, sizeof(unsigned int), indexCount);
+        Allocate(m_freeIndices, indexCount, indexOffset);
+    }
+
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)vertexOffset * s_stride * sizeof(float),
+                    (GLsizeiptr)vertexCount * s_stride * sizeof(float), vertexData);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)indexOffset * sizeof(unsigned int),
+                    (GLsizeiptr)indexCount * sizeof(unsigned int), indices);
+    FlightRecorder::Count(FlightCounter::UploadBytes,
+                          (uint64_t)vertexCount * s_stride * sizeof(float) + (uint64_t)indexCount * sizeof(unsigned int));
+
+    MeshRange mesh;
+    mesh.baseVertex = (GLint)vertexOffset;
+    mesh.vertexCount = vertexCount;
+    mesh.firstIndex = indexOffset;
+    mesh.indexCount = indexCount;
+    ++m_meshCount;
+    return mesh;
+}
+
+// Frees a mesh's ranges. Draws already issued are unaffected, the space is
+// only reused by later Adds.
+// @param mesh: A range returned by Add
+void MeshPool::Remove(const MeshRange& mesh) {
+    Free(m_freeVertices, (GLuint)mesh.baseVertex, mesh.vertexCount);
+    Free(m_freeIndices, mesh.firstIndex, mesh.indexCount);
+    --m_meshCount;
+}
@@ -1,11 +1,16 @@
 #include "Object.hpp"
+#include "Profiler.hpp"
 #include "Error.hpp"
 
 // Constructor: Initializes the Object instance
 Object::Object() {}
 
 // Destructor: Cleans up resources used by the Object instance
-Object::~Object() {}
+Object::~Object() {
+    if (m_meshPool != nullptr) {
+        m_meshPool->Remove(m_meshRange);
+    }
+}
 
 // Loads a texture file into the object
 // @param fileName: Path to the texture file
@@ -16,6 +21,7 @@ void Object::LoadTexture(std::string fileName) {
 // Loads an OBJ file and sets up its geometry and texture
 // @param filepath: Path to the OBJ file
 void Object::LoadOBJ(std::string filepath) {
+    PROFILE_SCOPE("LoadOBJ");
     std::cout << "Loading OBJ file: " << filepath << std::endl;
     m_filePath = filepath;
 
@@ -35,6 +41,18 @@ void Object::LoadOBJ(std::string filepath) {
     );
 }
 
+// Copies the geometry loaded by LoadOBJ into a shared mesh pool
+// @param pool: The pool to place the geometry in
+void Object::AddToMeshPool(MeshPool& pool) {
+    PROFILE_SCOPE("AddToMeshPool");
+    if (m_meshPool != nullptr) {
+        m_meshPool->Remove(m_meshRange);
+    }
+    m_meshPool = &pool;
+    m_meshRange = pool.Add(m_geometry.GetBufferDataPtr(), (GLuint)(m_geometry.GetBufferDataSize() / 11),
+                           m_geometry.GetIndicesDataPtr(), m_geometry.GetIndicesSize());
+}
+
 // Parses an OBJ file for geometry and material references
 // @param filepath: Path to the OBJ file
 void Object::parseOBJ(const std::string& filepath) {
@@ -142,10 +160,29 @@ void Object::parseOBJ(const std::string& filepath) {
 // Parses an MTL file for texture and material information
 // @param filepath: Path to the MTL file
 void Object::parseMTL(const std::string& filepath) {
+    std::string diffuseMap, normalMap;
+    if (!readMTL(filepath, diffuseMap, normalMap)) {
+        return;
+    }
+    if (!diffuseMap.empty()) {
+        m_textureDiffuse.LoadTexture(m_directory + diffuseMap);
+    }
+    if (!normalMap.empty()) {
+        m_normalMap.LoadTexture(m_directory + normalMap);
+    }
+}
+
+// Reads the texture file names an MTL file refers to. Where a map is
+// given more than once, the last one is kept.
+// @param filepath: Path to the MTL file
+// @param diffuseMap: Receives the map_Kd file name, untouched if none
+// @param normalMap: Receives the map_Bump (or bump) file name, untouched if none
+// @return false if the file could not be opened
+bool Object::readMTL(const std::string& filepath, std::string& diffuseMap, std::string& normalMap) {
     std::ifstream mtlFile(filepath);
     if (!mtlFile.is_open()) {
         std::cerr << "Failed to open MTL file: " << filepath << std::endl;
-        return;
+        return false;
     }
 
     std::string line, prefix;
@@ -154,17 +191,14 @@ void Object::parseMTL(const std::string& filepath) {
         ss >> prefix;
 
         if (prefix == "map_Kd") {
-            std::string textureFilename;
-            ss >> textureFilename;
-            m_textureDiffuse.LoadTexture(m_directory + textureFilename);
+            ss >> diffuseMap;
         } else if (prefix == "map_Bump" || prefix == "bump") {
-            std::string normalMapFilename;
-            ss >> normalMapFilename;
-            m_normalMap.LoadTexture(m_directory + normalMapFilename);
+            ss >> normalMap;
         }
     }
 
     mtlFile.close();
+    return true;
 }
 
 // Binds the object (geometry and textures) for rendering
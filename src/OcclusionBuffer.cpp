@@ -0,0 +1,268 @@
+#include "OcclusionBuffer.hpp"
+#include "Profiler.hpp"
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define OCCLUSION_USE_SSE 1
+    #include <xmmintrin.h>
+#endif
+
+const int OcclusionBuffer::s_bandHeight;
+
+// Vertices closer than this (clip space w) are treated as crossing the near plane
+static const float s_nearW = 1e-4f;
+
+// Constructor: allocates the depth buffer and its pyramid
+// @param width, height: Resolution of the depth buffer
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : m_width((std::max(width, 4) + 3) & ~3), m_height(std::max(height, 1)), m_viewProjection(1.0f) {
+    int levelWidth = m_width;
+    int levelHeight = m_height;
+    while (true) {
+        m_levels.push_back(std::vector<float>(levelWidth * levelHeight, 1.0f));
+        m_levelWidths.push_back(levelWidth);
+        m_levelHeights.push_back(levelHeight);
+        if (levelWidth == 1 && levelHeight == 1) {
+            break;
+        }
+        levelWidth = std::max(1, (levelWidth + 1) / 2);
+        levelHeight = std::max(1, (levelHeight + 1) / 2);
+    }
+}
+
+// Clears the depth buffer to the far plane and forgets last frame's occluders
+// @param viewProjection: projection x view matrix of the camera
+void OcclusionBuffer::Begin(const glm::mat4& viewProjection) {
+    m_viewProjection = viewProjection;
+    m_triangles.clear();
+    std::fill(m_levels[0].begin(), m_levels[0].end(), 1.0f);
+}
+
+// Projects an occluder's triangles and sets up their edge functions
+// @param positions, indices: The occluder's triangle mesh
+// @param model: Its world transform
+void OcclusionBuffer::AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& model) {
+    const glm::mat4 modelViewProjection = m_viewProjection * model;
+
+    // Screen space vertices, w < s_nearW marks a vertex behind the near plane
+    glm::vec4* screen = FrameArena::GetFrame().AllocateArray<glm::vec4>(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        glm::vec4 clip = modelViewProjection * glm::vec4(positions[i], 1.0f);
+        if (clip.w < s_nearW) {
+            screen[i] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+            continue;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        screen[i] = glm::vec4((ndc.x * 0.5f + 0.5f) * m_width,
+                              (ndc.y * 0.5f + 0.5f) * m_height,
+                              glm::clamp(ndc.z * 0.5f + 0.5f, 0.0f, 1.0f),
+                              1.0f);
+    }
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        glm::vec4 v0 = screen[indices[t]];
+        glm::vec4 v1 = screen[indices[t + 1]];
+        glm::vec4 v2 = screen[indices[t + 2]];
+        if (v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f) {
+            continue;
+        }
+
+        // Occluders are drawn from both sides: make every triangle counter clockwise
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::fabs(area) < 1e-6f) {
+            continue;
+        }
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        ScreenTriangle triangle;
+        triangle.minX = std::max(0, (int)std::floor(std::min(std::min(v0.x, v1.x), v2.x)));
+        triangle.maxX = std::min(m_width - 1, (int)std::ceil(std::max(std::max(v0.x, v1.x), v2.x)));
+        triangle.minY = std::max(0, (int)std::floor(std::min(std::min(v0.y, v1.y), v2.y)));
+        triangle.maxY = std::min(m_height - 1, (int)std::ceil(std::max(std::max(v0.y, v1.y), v2.y)));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+            continue;
+        }
+
+        // Edge i runs from vertex i to vertex i+1, the third vertex is on its positive side
+        const glm::vec4* v[3] = { &v0, &v1, &v2 };
+        for (int e = 0; e < 3; ++e) {
+            const glm::vec4& a = *v[e];
+            const glm::vec4& b = *v[(e + 1) % 3];
+            triangle.edgeA[e] = -(b.y - a.y);
+            triangle.edgeB[e] = b.x - a.x;
+            triangle.edgeC[e] = (b.y - a.y) * a.x - (b.x - a.x) * a.y;
+        }
+
+        // Depth is affine in screen space
+        triangle.depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        triangle.depthB = ((v1.x - v0.x) * (v2.z - v0.z) - (v2.x - v0.x) * (v1.z - v0.z)) / area;
+        triangle.depthC = v0.z - triangle.depthA * v0.x - triangle.depthB * v0.y;
+        m_triangles.push_back(triangle);
+    }
+}
+
+// Rasterizes the occluders, one band of rows per job, then builds the pyramid
+// @param jobs: Threads to rasterize on, nullptr to rasterize here
+void OcclusionBuffer::Rasterize(JobSystem* jobs) {
+    PROFILE_SCOPE("RasterizeOccluders");
+    const size_t bandCount = (m_height + s_bandHeight - 1) / s_bandHeight;
+    auto rasterizeBands = [this](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; ++band) {
+            int beginY = (int)band * s_bandHeight;
+            RasterizeBand(beginY, std::min(beginY + s_bandHeight, m_height));
+        }
+    };
+    if (jobs != nullptr && !m_triangles.empty()) {
+        jobs->ParallelFor(0, bandCount, 1, rasterizeBands);
+    } else {
+        rasterizeBands(0, bandCount);
+    }
+    BuildPyramid();
+}
+
+// Rasterizes every triangle overlapping rows [beginY, endY), keeping the
+// nearest depth per pixel. Pixels are covered when their center is inside.
+void OcclusionBuffer::RasterizeBand(int beginY, int endY) {
+    std::vector<float>& depth = m_levels[0];
+
+    for (size_t t = 0; t < m_triangles.size(); ++t) {
+        const ScreenTriangle& tri = m_triangles[t];
+        if (tri.maxY < beginY || tri.minY >= endY) {
+            continue;
+        }
+        const int firstY = std::max(tri.minY, beginY);
+        const int lastY = std::min(tri.maxY, endY - 1);
+        // Groups of four pixels start at multiples of four, the width is one too
+        const int firstX = tri.minX & ~3;
+
+#ifdef OCCLUSION_USE_SSE
+        const __m128 edgeA0 = _mm_set1_ps(tri.edgeA[0]);
+        const __m128 edgeA1 = _mm_set1_ps(tri.edgeA[1]);
+        const __m128 edgeA2 = _mm_set1_ps(tri.edgeA[2]);
+        const __m128 depthA = _mm_set1_ps(tri.depthA);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 four = _mm_set1_ps(4.0f);
+
+        for (int y = firstY; y <= lastY; ++y) {
+            const float py = y + 0.5f;
+            const __m128 row0 = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+            const __m128 row1 = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+            const __m128 row2 = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(tri.depthB * py + tri.depthC);
+            float* rowPixels = &depth[y * m_width];
+
+            __m128 px = _mm_setr_ps(firstX + 0.5f, firstX + 1.5f, firstX + 2.5f, firstX + 3.5f);
+            for (int x = firstX; x <= tri.maxX; x += 4, px = _mm_add_ps(px, four)) {
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, px), row0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, px), row1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, px), row2);
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+                __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                __m128 current = _mm_loadu_ps(rowPixels + x);
+                __m128 nearest = _mm_min_ps(current, z);
+                _mm_storeu_ps(rowPixels + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+        }
+#else
+        for (int y = firstY; y <= lastY; ++y) {
+            const float py = y + 0.5f;
+            float* rowPixels = &depth[y * m_width];
+            for (int x = firstX; x <= tri.maxX; ++x) {
+                const float px = x + 0.5f;
+                if (tri.edgeA[0] * px + tri.edgeB[0] * py + tri.edgeC[0] < 0.0f ||
+                    tri.edgeA[1] * px + tri.edgeB[1] * py + tri.edgeC[1] < 0.0f ||
+                    tri.edgeA[2] * px + tri.edgeB[2] * py + tri.edgeC[2] < 0.0f) {
+                    continue;
+                }
+                float z = tri.depthA * px + tri.depthB * py + tri.depthC;
+                rowPixels[x] = std::min(rowPixels[x], z);
+            }
+        }
+#endif
+    }
+}
+
+// Every texel of a level is the farthest depth of the 2x2 texels below it
+void OcclusionBuffer::BuildPyramid() {
+    for (size_t level = 1; level < m_levels.size(); ++level) {
+        const std::vector<float>& below = m_levels[level - 1];
+        const int belowWidth = m_levelWidths[level - 1];
+        const int belowHeight = m_levelHeights[level - 1];
+        std::vector<float>& current = m_levels[level];
+        for (int y = 0; y < m_levelHeights[level]; ++y) {
+            int y0 = 2 * y;
+            int y1 = std::min(2 * y + 1, belowHeight - 1);
+            for (int x = 0; x < m_levelWidths[level]; ++x) {
+                int x0 = 2 * x;
+                int x1 = std::min(2 * x + 1, belowWidth - 1);
+                current[y * m_levelWidths[level] + x] = std::max(
+                    std::max(below[y0 * belowWidth + x0], below[y0 * belowWidth + x1]),
+                    std::max(below[y1 * belowWidth + x0], below[y1 * belowWidth + x1]));
+            }
+        }
+    }
+}
+
+// Tests a box against the pyramid level where its screen rectangle spans
+// at most 2x2 texels
+// @param worldBounds: World space box
+// @return true if every pixel the box could cover has an occluder in front of it
+bool OcclusionBuffer::IsOccluded(const AABB& worldBounds) const {
+    if (worldBounds.IsEmpty()) {
+        return false;
+    }
+
+    glm::vec3 minNdc(FLT_MAX);
+    glm::vec3 maxNdc(-FLT_MAX);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 p((corner & 1) ? worldBounds.max.x : worldBounds.min.x,
+                    (corner & 2) ? worldBounds.max.y : worldBounds.min.y,
+                    (corner & 4) ? worldBounds.max.z : worldBounds.min.z);
+        glm::vec4 clip = m_viewProjection * glm::vec4(p, 1.0f);
+        // Reaches the camera, cannot be behind anything
+        if (clip.w < s_nearW) {
+            return false;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        minNdc = glm::min(minNdc, ndc);
+        maxNdc = glm::max(maxNdc, ndc);
+    }
+    // Off screen: left to frustum culling
+    if (maxNdc.x < -1.0f || minNdc.x > 1.0f || maxNdc.y < -1.0f || minNdc.y > 1.0f) {
+        return false;
+    }
+
+    const float nearestDepth = minNdc.z * 0.5f + 0.5f;
+    int x0 = glm::clamp((int)std::floor((minNdc.x * 0.5f + 0.5f) * m_width), 0, m_width - 1);
+    int x1 = glm::clamp((int)std::floor((maxNdc.x * 0.5f + 0.5f) * m_width), 0, m_width - 1);
+    int y0 = glm::clamp((int)std::floor((minNdc.y * 0.5f + 0.5f) * m_height), 0, m_height - 1);
+    int y1 = glm::clamp((int)std::floor((maxNdc.y * 0.5f + 0.5f) * m_height), 0, m_height - 1);
+
+    int level = 0;
+    while (level + 1 < (int)m_levels.size() &&
+           ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        ++level;
+    }
+
+    const std::vector<float>& depth = m_levels[level];
+    const int levelWidth = m_levelWidths[level];
+    for (int y = y0 >> level; y <= (y1 >> level); ++y) {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x) {
+            if (nearestDepth <= depth[y * levelWidth + x]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,260 @@
+#include "Profiler.hpp"
+
+#include <glad/glad.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+std::atomic<bool> Profiler::s_capturing(false);
+
+// The calling thread's zones, registered with the profiler on first use
+static thread_local void* t_threadBuffer = nullptr;
+
+// Name of the frame markers
+static const char* s_frameMarker = "Frame";
+
+// Constructor
+Profiler::Profiler() {
+    m_gpuOpen.reserve(16);
+}
+
+// Returns the engine wide profiler
+Profiler& Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+// Current time
+// @return nanoseconds on the steady clock
+int64_t Profiler::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns the buffer of the calling thread, creating it the first time.
+// Buffers are never deleted, a trace may still need a finished thread's.
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer() {
+    if (t_threadBuffer == nullptr) {
+        ThreadBuffer* buffer = new ThreadBuffer();
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        buffer->id = (int)m_threads.size() + 1;
+        buffer->name = "Thread " + std::to_string(buffer->id);
+        m_threads.push_back(buffer);
+        t_threadBuffer = buffer;
+    }
+    return static_cast<ThreadBuffer*>(t_threadBuffer);
+}
+
+// Names the calling thread's track in traces
+// @param name: e.g. "GL thread" or "Worker 1"
+void Profiler::SetThreadName(const std::string& name) {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->name = name;
+}
+
+// Starts a capture, dropping what an earlier one left
+// @param filename: Trace file to write
+// @param frameCount: Frames captured, 0 to capture until EndCapture
+void Profiler::BeginCapture(const std::string& filename, int frameCount) {
+    {
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        for (ThreadBuffer* buffer : m_threads) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+        }
+    }
+    m_gpuEvents.clear();
+    m_filename = filename;
+    m_captureFrames = frameCount;
+    m_capturedFrames = 0;
+    m_dropped = 0;
+    m_captureStart = Now();
+    s_capturing.store(true, std::memory_order_relaxed);
+    std::cout << "Profiler: capturing " << (frameCount > 0 ? std::to_string(frameCount) : std::string("all"))
+              << " frames to " << filename << std::endl;
+}
+
+// Ends the capture and writes the trace
+// @return false if no capture was running or the file could not be written
+bool Profiler::EndCapture() {
+    if (!IsCapturing()) {
+        return false;
+    }
+    s_capturing.store(false, std::memory_order_relaxed);
+    // Every frame still in flight, oldest first
+    for (int i = 1; i <= s_gpuLatency + 1; ++i) {
+        ReadGpuFrame(m_gpuFrames[(m_gpuFrame + i) % (s_gpuLatency + 1)], true);
+    }
+    return WriteTrace(m_filename);
+}
+
+// Marks the end of a frame, reads back the GPU zones of the oldest frame in
+// the ring and ends the capture after its last frame
+void Profiler::EndFrame() {
+    if (!IsCapturing()) {
+        return;
+    }
+    // GPU zones do not span frames
+    assert(m_gpuOpen.empty());
+    int64_t now = Now();
+    RecordCpu(s_frameMarker, now, now);
+
+    m_gpuFrame = (m_gpuFrame + 1) % (s_gpuLatency + 1);
+    ReadGpuFrame(m_gpuFrames[m_gpuFrame], false);
+
+    if (m_captureFrames > 0 && ++m_capturedFrames >= m_captureFrames) {
+        EndCapture();
+    }
+}
+
+// Adds a zone to the calling thread's buffer
+// @param name: Zone name, a string literal
+// @param start, end: Times from Now
+void Profiler::RecordCpu(const char* name, int64_t start, int64_t end) {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    if (buffer->events.size() >= s_maxEventsPerThread) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events.push_back(ProfileEvent{ name, start, end });
+}
+
+// Issues a GL_TIMESTAMP query, reusing the query names of the frame
+// @return the query
+unsigned int Profiler::QueryTimestamp() {
+    GpuFrame& frame = m_gpuFrames[m_gpuFrame];
+    if (frame.usedQueries == frame.queries.size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    GLuint query = frame.queries[frame.usedQueries++];
+    glQueryCounter(query, GL_TIMESTAMP);
+    return query;
+}
+
+// Opens a GPU zone
+// @param name: Zone name, a string literal
+void Profiler::BeginGpu(const char* name) {
+    if (!IsCapturing()) {
+        m_gpuOpen.push_back((size_t)-1);
+        return;
+    }
+    if (!m_gpuCalibrated) {
+        // The GL clock read now, against ours
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        m_gpuOffset = Now() - (int64_t)gpuNow;
+        m_gpuCalibrated = true;
+    }
+    GpuFrame& frame = m_gpuFrames[m_gpuFrame];
+    m_gpuOpen.push_back(frame.zones.size());
+    frame.zones.push_back(GpuZone{ name, QueryTimestamp(), 0 });
+}
+
+// Closes the innermost GPU zone
+void Profiler::EndGpu() {
+    assert(!m_gpuOpen.empty());
+    size_t zone = m_gpuOpen.back();
+    m_gpuOpen.pop_back();
+    // Opened outside the capture
+    if (zone == (size_t)-1 || !IsCapturing()) {
+        return;
+    }
+    m_gpuFrames[m_gpuFrame].zones[zone].endQuery = QueryTimestamp();
+}
+
+// Converts the zones of a frame whose queries finished, and empties it
+// @param frame: A frame s_gpuLatency frames old, or any when ending
+// @param wait: Wait for unfinished queries instead of dropping their zones
+void Profiler::ReadGpuFrame(GpuFrame& frame, bool wait) {
+    for (const GpuZone& zone : frame.zones) {
+        if (zone.endQuery == 0) {
+            continue;
+        }
+        GLint available = 1;
+        if (!wait) {
+            glGetQueryObjectiv(zone.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (!available) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(zone.beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(zone.endQuery, GL_QUERY_RESULT, &end);
+        m_gpuEvents.push_back(ProfileEvent{ zone.name, (int64_t)begin + m_gpuOffset, (int64_t)end + m_gpuOffset });
+    }
+    frame.zones.clear();
+    frame.usedQueries = 0;
+}
+
+// Writes an event as a trace-event object, times in microseconds
+// @param out: The trace
+// @param event: The event
+// @param tid: Track it goes on
+// @param captureStart: Time zero of the trace
+void Profiler::WriteTraceEvent(std::ostream& out, const ProfileEvent& event, int tid, int64_t captureStart) {
+    char times[96];
+    if (event.end == event.start) {
+        std::snprintf(times, sizeof(times), "\"ph\": \"i\", \"s\": \"g\", \"ts\": %.3f",
+                      (event.start - captureStart) / 1000.0);
+    } else {
+        std::snprintf(times, sizeof(times), "\"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f",
+                      (event.start - captureStart) / 1000.0, (event.end - event.start) / 1000.0);
+    }
+    out << ",\n{\"name\": \"" << event.name << "\", " << times << ", \"pid\": 1, \"tid\": " << tid << "}";
+}
+
+// Writes the captured zones as Chrome trace-event JSON: a named track per
+// thread, and one for the GPU
+// @param filename: File to write
+// @return false if it could not be written
+bool Profiler::WriteTrace(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cout << "Profiler: could not write " << filename << std::endl;
+        return false;
+    }
+    // The GPU track comes after the threads
+    const int gpuTid = 1000;
+    size_t eventCount = m_gpuEvents.size();
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+         << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"aurorascene\"}}";
+    file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << gpuTid
+         << ", \"args\": {\"name\": \"GPU\"}}";
+    file << ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << gpuTid
+         << ", \"args\": {\"sort_index\": " << gpuTid << "}}";
+    {
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        for (ThreadBuffer* buffer : m_threads) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+                 << ", \"args\": {\"name\": \"" << buffer->name << "\"}}";
+            file << ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+                 << ", \"args\": {\"sort_index\": " << buffer->id << "}}";
+            for (const ProfileEvent& event : buffer->events) {
+                WriteTraceEvent(file, event, buffer->id, m_captureStart);
+            }
+            eventCount += buffer->events.size();
+            buffer->events.clear();
+        }
+    }
+    for (const ProfileEvent& event : m_gpuEvents) {
+        WriteTraceEvent(file, event, gpuTid, m_captureStart);
+    }
+    m_gpuEvents.clear();
+    file << "\n]}" << std::endl;
+
+    std::cout << "Profiler: wrote " << eventCount << " events";
+    if (m_dropped > 0) {
+        std::cout << " (" << m_dropped << " dropped)";
+    }
+    std::cout << " to " << filename << std::endl;
+    return static_cast<bool>(file);
+}
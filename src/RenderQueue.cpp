@@ -0,0 +1,359 @@
+#include "RenderQueue.hpp"
+#include "Profiler.hpp"
+#include "SceneNode.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Constructor. The buffers are created on the first draw that needs them.
+RenderQueue::RenderQueue()
+    : m_view(1.0f), m_projection(1.0f), m_farPlane(1.0f), m_frame(0), m_arena(&FrameArena::GetFrame()),
+      m_packets(m_list.m_packets), m_instanceBuffer(0),
+      m_indirectEnabled(false), m_commandBuffer(0), m_drawIndexBuffer(0), m_drawIndexCount(0), m_ring(nullptr),
+      m_instanceData(), m_commandData() {}
+
+// Destructor
+RenderQueue::~RenderQueue() {
+    GLuint buffers[] = { m_instanceBuffer, m_commandBuffer, m_drawIndexBuffer };
+    for (GLuint buffer : buffers) {
+        if (buffer != 0) {
+            GLState::DeleteBuffers(1, &buffer);
+        }
+    }
+}
+
+// Lets nodes submit indirect packets, if the context supports them
+// @param enabled: true to draw pooled meshes with glMultiDrawElementsIndirect
+void RenderQueue::SetIndirectEnabled(bool enabled) {
+    if (enabled && !GLExtensions::HasMultiDrawIndirect()) {
+        std::cout << "RenderQueue: indirect multi-draw unavailable, drawing per node" << std::endl;
+        enabled = false;
+    }
+    m_indirectEnabled = enabled;
+}
+
+// Starts a new frame, with room for as many packets as the last one had
+// @param view: View matrix, used for the depth part of the keys
+// @param projection: Projection matrix, set on the programs with the view
+// @param farPlane: Distance mapped to the largest depth key
+void RenderQueue::Begin(const glm::mat4& view, const glm::mat4& projection, float farPlane) {
+    m_view = view;
+    m_projection = projection;
+    m_farPlane = farPlane;
+    ++m_frame;
+    m_list.Begin(view, farPlane, m_indirectEnabled, m_arena);
+    m_sortBuffer = PacketArray(ArenaAllocator<DrawPacket>(m_arena));
+    m_stats = RenderQueueStats();
+}
+
+// Adds a draw, see CommandList::Push
+void RenderQueue::Push(RenderPass pass, GLuint program, GLuint instancedProgram, GLuint texture, GLuint vertexArray, GLsizei indexCount, const glm::mat4& model) {
+    m_list.Push(pass, program, instancedProgram, texture, vertexArray, indexCount, model);
+}
+
+// Adds a draw of a pooled mesh, see CommandList::PushIndirect
+void RenderQueue::PushIndirect(RenderPass pass, GLuint program, GLuint texture, const MeshPool& pool, const MeshRange& mesh, const glm::mat4& model) {
+    m_list.PushIndirect(pass, program, texture, pool, mesh, model);
+}
+
+// Adds a node that draws itself, see CommandList::PushCustom
+void RenderQueue::PushCustom(RenderPass pass, SceneNode* node) {
+    m_list.PushCustom(pass, node);
+}
+
+// Copies a recorded list's packets behind the queued ones
+// @param list: A list recorded with this frame's view and arena
+void RenderQueue::Append(const CommandList& list) {
+    m_packets.insert(m_packets.end(), list.GetPackets().begin(), list.GetPackets().end());
+}
+
+// Counts program, texture and vertex array changes along the packets
+size_t RenderQueue::CountStateChanges() const {
+    size_t changes = 0;
+    const DrawPacket* previous = nullptr;
+    for (size_t i = 0; i < m_packets.size(); ++i) {
+        const DrawPacket& packet = m_packets[i];
+        if (packet.node != nullptr) {
+            previous = nullptr;
+            continue;
+        }
+        changes += (previous == nullptr || previous->program != packet.program) ? 1 : 0;
+        changes += (previous == nullptr || previous->texture != packet.texture) ? 1 : 0;
+        changes += (previous == nullptr || previous->vertexArray != packet.vertexArray) ? 1 : 0;
+        previous = &packet;
+    }
+    return changes;
+}
+
+// Least significant digit radix sort, one byte per pass. Passes where
+// every key has the same byte are skipped, which is most of them.
+void RenderQueue::Sort() {
+    PROFILE_SCOPE("SortPackets");
+    m_stats.packets = m_packets.size();
+    m_stats.stateChangesUnsorted = CountStateChanges();
+
+    m_sortBuffer.resize(m_packets.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < m_packets.size(); ++i) {
+            ++counts[(m_packets[i].key >> shift) & 0xFF];
+        }
+        if (m_packets.empty() || counts[(m_packets[0].key >> shift) & 0xFF] == m_packets.size()) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            size_t count = counts[digit];
+            counts[digit] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < m_packets.size(); ++i) {
+            m_sortBuffer[counts[(m_packets[i].key >> shift) & 0xFF]++] = m_packets[i];
+        }
+        m_packets.swap(m_sortBuffer);
+    }
+}
+
+// Splits the sorted packets into runs of the same mesh and state. Runs
+// long enough, with an instanced program, become one instanced draw, and
+// runs of pooled meshes one indirect draw.
+void RenderQueue::BuildBatches() {
+    m_batches.clear();
+    m_instanceMatrices.clear();
+    m_commands.clear();
+
+    size_t first = 0;
+    while (first < m_packets.size()) {
+        const DrawPacket& packet = m_packets[first];
+        size_t end = first + 1;
+        if (packet.node == nullptr && (packet.instancedProgram != 0 || packet.indirect)) {
+            while (end < m_packets.size() &&
+                   m_packets[end].node == nullptr &&
+                   m_packets[end].indirect == packet.indirect &&
+                   m_packets[end].program == packet.program &&
+                   m_packets[end].instancedProgram == packet.instancedProgram &&
+                   m_packets[end].texture == packet.texture &&
+                   m_packets[end].vertexArray == packet.vertexArray &&
+                   (packet.indirect || m_packets[end].indexCount == packet.indexCount)) {
+                ++end;
+            }
+        }
+
+        DrawBatch batch;
+        batch.first = first;
+        batch.firstInstance = m_instanceMatrices.size();
+        batch.firstCommand = m_commands.size();
+        batch.commandCount = 0;
+        if (packet.indirect) {
+            batch.type = BatchIndirect;
+            batch.count = end - first;
+            BuildIndirectBatch(first, end);
+            batch.commandCount = m_commands.size() - batch.firstCommand;
+            ++m_stats.indirectDraws;
+            m_stats.indirectPackets += batch.count;
+        } else if (end - first >= s_minInstances) {
+            batch.type = BatchInstanced;
+            batch.count = end - first;
+            for (size_t i = first; i < end; ++i) {
+                m_instanceMatrices.push_back(*m_packets[i].model);
+            }
+            ++m_stats.instancedDraws;
+            m_stats.instances += batch.count;
+        } else {
+            batch.type = BatchSingle;
+            batch.count = 1;
+        }
+        m_batches.push_back(batch);
+        first += batch.count;
+    }
+}
+
+// Writes one command per mesh of an indirect run. Packets of the same mesh
+// are adjacent and become the instances of one command, their matrices
+// stored from the command's baseInstance on.
+// @param first, end: The run's packets
+void RenderQueue::BuildIndirectBatch(size_t first, size_t end) {
+    for (size_t i = first; i < end; ++i) {
+        const DrawPacket& packet = m_packets[i];
+        if (i > first && m_commands.back().firstIndex == packet.firstIndex &&
+            m_commands.back().baseVertex == packet.baseVertex) {
+            ++m_commands.back().instanceCount;
+        } else {
+            DrawElementsIndirectCommand command;
+            command.count = (GLuint)packet.indexCount;
+            command.instanceCount = 1;
+            command.firstIndex = packet.firstIndex;
+            command.baseVertex = packet.baseVertex;
+            command.baseInstance = (GLuint)m_instanceMatrices.size();
+            m_commands.push_back(command);
+        }
+        m_instanceMatrices.push_back(*packet.model);
+    }
+}
+
+// Replaces a buffer's contents, orphaning the previous storage
+// @param target: Binding point to upload through
+// @param buffer: The buffer, created if 0
+// @param size, data: The new contents
+void RenderQueue::Upload(GLenum target, GLuint& buffer, GLsizeiptr size, const void* data) {
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+    }
+    GLState::BindBuffer(target, buffer);
+    glBufferData(target, size, data, GL_STREAM_DRAW);
+    FlightRecorder::Count(FlightCounter::UploadBytes, size);
+}
+
+// Places this frame's data in the ring's mapped memory if there is room,
+// else uploads it to buffer with glBufferData
+// @param target: Binding point to upload through
+// @param buffer: Fallback buffer, created if 0
+// @param size, data: The data
+// @param alignment: Offset alignment the data is bound with
+// @param allocation: Receives the buffer and offset the data is at
+void RenderQueue::Stream(GLenum target, GLuint& buffer, GLsizeiptr size, GLsizeiptr alignment, const void* data, FrameRing::Allocation& allocation) {
+    PROFILE_SCOPE("Upload");
+    m_stats.uploadBytes += size;
+    if (m_ring != nullptr && m_ring->Allocate(size, alignment, allocation)) {
+        std::memcpy(allocation.data, data, size);
+        FlightRecorder::Count(FlightCounter::UploadBytes, size);
+        return;
+    }
+    Upload(target, buffer, size, data);
+    allocation.data = nullptr;
+    allocation.buffer = buffer;
+    allocation.offset = 0;
+    allocation.size = size;
+}
+
+// Binds a program and, the first time it is used this frame, its view and
+// projection matrices
+// @param program: The program to bind
+RenderQueue::ProgramUniforms& RenderQueue::UseProgram(GLuint program) {
+    GLState::UseProgram(program);
+
+    auto it = m_uniforms.find(program);
+    if (it == m_uniforms.end()) {
+        ProgramUniforms uniforms;
+        uniforms.model = glGetUniformLocation(program, "model");
+        uniforms.view = glGetUniformLocation(program, "view");
+        uniforms.projection = glGetUniformLocation(program, "projection");
+        uniforms.frame = m_frame - 1;
+        it = m_uniforms.emplace(program, uniforms).first;
+    }
+
+    ProgramUniforms& uniforms = it->second;
+    if (uniforms.frame != m_frame) {
+        if (uniforms.view >= 0) {
+            glUniformMatrix4fv(uniforms.view, 1, GL_FALSE, &m_view[0][0]);
+        }
+        if (uniforms.projection >= 0) {
+            glUniformMatrix4fv(uniforms.projection, 1, GL_FALSE, &m_projection[0][0]);
+        }
+        uniforms.frame = m_frame;
+    }
+    return uniforms;
+}
+
+// Issues the draws, binding program, texture and vertex array only when
+// they differ from the previous draw's
+void RenderQueue::Execute() {
+    PROFILE_SCOPE("Execute");
+    PROFILE_GPU_SCOPE("Draw");
+    auto start = std::chrono::steady_clock::now();
+    BuildBatches();
+
+    // All instance matrices and indirect commands of the frame in one
+    // upload each. Indirect draws read the matrices as storage buffer 0.
+    GLsizeiptr storageAlignment = (m_ring != nullptr) ? m_ring->GetStorageAlignment() : 16;
+    if (!m_instanceMatrices.empty()) {
+        Stream(GL_ARRAY_BUFFER, m_instanceBuffer, m_instanceMatrices.size() * sizeof(glm::mat4), storageAlignment,
+               m_instanceMatrices.data(), m_instanceData);
+    }
+    if (!m_commands.empty()) {
+        Stream(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer, m_commands.size() * sizeof(DrawElementsIndirectCommand),
+               sizeof(GLuint), m_commands.data(), m_commandData);
+        GLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_instanceData.buffer, m_instanceData.offset, m_instanceData.size);
+        if (m_drawIndexCount < m_instanceMatrices.size()) {
+            m_drawIndexCount = std::max((GLuint)m_instanceMatrices.size(), m_drawIndexCount * 2);
+            std::vector<GLuint> drawIndices(m_drawIndexCount);
+            for (GLuint i = 0; i < m_drawIndexCount; ++i) {
+                drawIndices[i] = i;
+            }
+            Upload(GL_ARRAY_BUFFER, m_drawIndexBuffer, drawIndices.size() * sizeof(GLuint), drawIndices.data());
+        }
+    }
+
+    // Unknown state: the first draw binds everything
+    bool stateKnown = false;
+    GLuint program = 0, texture = 0, vertexArray = 0;
+    ProgramUniforms* uniforms = nullptr;
+
+    for (size_t b = 0; b < m_batches.size(); ++b) {
+        const DrawBatch& batch = m_batches[b];
+        const DrawPacket& packet = m_packets[batch.first];
+        if (packet.node != nullptr) {
+            packet.node->DrawCustom();
+            // Custom draws may leave anything bound
+            stateKnown = false;
+            continue;
+        }
+
+        GLuint batchProgram = (batch.type == BatchInstanced) ? packet.instancedProgram : packet.program;
+        if (!stateKnown || batchProgram != program) {
+            uniforms = &UseProgram(batchProgram);
+            program = batchProgram;
+            ++m_stats.stateChangesSorted;
+        }
+        if (!stateKnown || packet.texture != texture) {
+            GLState::ActiveTexture(GL_TEXTURE0);
+            GLState::BindTexture(GL_TEXTURE_2D, packet.texture);
+            texture = packet.texture;
+            ++m_stats.stateChangesSorted;
+        }
+        if (!stateKnown || packet.vertexArray != vertexArray) {
+            GLState::BindVertexArray(packet.vertexArray);
+            vertexArray = packet.vertexArray;
+            ++m_stats.stateChangesSorted;
+        }
+        stateKnown = true;
+        for (size_t i = batch.first; i < batch.first + batch.count; ++i) {
+            m_stats.triangles += m_packets[i].indexCount / 3;
+        }
+
+        if (batch.type == BatchIndirect) {
+            // Instance i of a command reads draw index baseInstance + i
+            GLState::BindBuffer(GL_ARRAY_BUFFER, m_drawIndexBuffer);
+            glEnableVertexAttribArray(s_instanceAttribute);
+            glVertexAttribIPointer(s_instanceAttribute, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+            glVertexAttribDivisor(s_instanceAttribute, 1);
+            GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandData.buffer);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        (void*)(m_commandData.offset + batch.firstCommand * sizeof(DrawElementsIndirectCommand)),
+                                        (GLsizei)batch.commandCount, 0);
+        } else if (batch.type == BatchInstanced) {
+            // Point the instance matrix attributes of the bound vertex array
+            // at this batch's matrices, one column per attribute
+            GLState::BindBuffer(GL_ARRAY_BUFFER, m_instanceData.buffer);
+            for (GLuint column = 0; column < 4; ++column) {
+                GLuint attribute = s_instanceAttribute + column;
+                size_t offset = m_instanceData.offset + batch.firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4);
+                glEnableVertexAttribArray(attribute);
+                glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+                glVertexAttribDivisor(attribute, 1);
+            }
+            glDrawElementsInstanced(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_INT, nullptr, (GLsizei)batch.count);
+        } else {
+            if (uniforms->model >= 0) {
+                glUniformMatrix4fv(uniforms->model, 1, GL_FALSE, &(*packet.model)[0][0]);
+            }
+            glDrawElements(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_INT, nullptr);
+        }
+        ++m_stats.drawCalls;
+    }
+
+    m_stats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
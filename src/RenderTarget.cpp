@@ -0,0 +1,84 @@
+#include "RenderTarget.hpp"
+#include "GLState.hpp"
+
+#include <iostream>
+
+// Constructor: GL resources are created in Create
+RenderTarget::RenderTarget() {}
+
+// Destructor: Deletes the framebuffer and its attachments
+RenderTarget::~RenderTarget() {
+    Destroy();
+}
+
+// Deletes the framebuffer and its attachments
+void RenderTarget::Destroy() {
+    if (m_framebuffer != 0) {
+        GLState::DeleteFramebuffers(1, &m_framebuffer);
+        GLState::DeleteTextures(1, &m_colorTexture);
+        GLState::DeleteRenderbuffers(1, &m_depthBuffer);
+    }
+    m_framebuffer = 0;
+    m_colorTexture = 0;
+    m_depthBuffer = 0;
+}
+
+// Creates the framebuffer with a color texture and a depth buffer
+// @param width, height: Size of the attachments in pixels
+void RenderTarget::Create(int width, int height) {
+    if (m_framebuffer != 0 && width == m_width && height == m_height) {
+        return;
+    }
+    Destroy();
+    m_width = width;
+    m_height = height;
+
+    // Color attachment, sampled or blitted later
+    glGenTextures(1, &m_colorTexture);
+    GLState::BindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+    // Depth attachment, never sampled
+    glGenRenderbuffers(1, &m_depthBuffer);
+    GLState::BindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
+    GLState::BindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "RenderTarget: framebuffer incomplete (" << m_width << "x" << m_height << ")" << std::endl;
+    }
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Binds the framebuffer for drawing and sets the viewport to its size
+void RenderTarget::Bind() const {
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    GLState::Viewport(0, 0, m_width, m_height);
+}
+
+// Binds the window's framebuffer again
+void RenderTarget::Unbind() const {
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Copies the color attachment into another framebuffer, leaving it bound
+// @param framebuffer: Destination framebuffer, 0 for the window
+// @param width, height: Size of the destination area in pixels
+void RenderTarget::BlitTo(GLuint framebuffer, int width, int height) const {
+    GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(0, 0, m_width, m_height,
+                      0, 0, width, height,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
@@ -1,5 +1,12 @@
 #include "Renderer.hpp"
+#include "Profiler.hpp"
 #include "SceneNode.hpp"
+#include "JobSystem.hpp"
+#include "GLState.hpp"
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <chrono>
 
 // Constructor: Initializes the Renderer with the specified width and height
 Renderer::Renderer(unsigned int w, unsigned int h) 
@@ -10,6 +17,8 @@ Renderer::Renderer(unsigned int w, unsigned int h)
     m_cameras.push_back(defaultCamera); // Add the default camera to the list
 
     m_root = nullptr; // Initialize the root node to null
+    m_queue.SetFrameRing(&m_frameRing);
+    m_queue.SetArena(&m_renderArena);
     std::cout << "Renderer created with width: " << m_screenWidth 
               << " and height: " << m_screenHeight << std::endl;
 }
@@ -22,8 +31,20 @@ Renderer::~Renderer() {
     }
 }
 
-// Updates the scene graph and camera view
+// Updates the scene graph and camera view, and records what the frame
+// draws in the update snapshot
 void Renderer::Update() {
+    PROFILE_SCOPE("Update");
+    auto start = std::chrono::steady_clock::now();
+    FrameSnapshot& snapshot = m_snapshots[m_updateSnapshot];
+    snapshot.frame = m_snapshots[m_updateSnapshot ^ 1].frame + 1;
+    snapshot.visible.clear();
+    snapshot.gpuInstances.clear();
+
+    // The last update's transient data (occluder vertices) is done with
+    snapshot.frameArenaBytes = FrameArena::GetFrame().GetUsed();
+    FrameArena::GetFrame().Reset();
+
     // Set up the projection matrix for perspective rendering
     // Field of view: 45 degrees
     // Aspect ratio: screen width / screen height
@@ -35,22 +56,133 @@ void Renderer::Update() {
         0.1f,
         512.0f
     );
+    snapshot.projection = m_projectionMatrix;
+    if (!m_cameraLatched) {
+        LatchCamera();
+    }
+    m_cameraLatched = false;
+    snapshot.view = m_updateView;
 
     // Update the scene graph starting from the root node
     if (m_root != nullptr) {
-        // Currently uses the first camera (index 0) for updates.
-        m_root->Update(m_projectionMatrix, m_cameras[0], this);
+        // All world transforms in one pass over the scene storage,
+        // spread over the worker threads for large scenes
+        m_root->GetScene()->UpdateWorldTransforms(&JobSystem::Get());
+        snapshot.worldTransformsRecomputed = m_root->GetScene()->GetRecomputedCount();
+
+        // Mark what the first camera sees, rejecting whole subtrees
+        auto cullStart = std::chrono::steady_clock::now();
+        glm::mat4 viewProjection = snapshot.projection * snapshot.view;
+        if (m_lateLatch) {
+            glm::mat4 cullProjection = glm::perspective(glm::radians(s_lateLatchCullFov),
+                ((float)m_screenWidth) / ((float)m_screenHeight), 0.1f, 512.0f);
+            m_frustum.Extract(cullProjection * snapshot.view);
+        } else {
+            m_frustum.Extract(viewProjection);
+        }
+        CullStats cull = m_root->GetScene()->Cull(m_frustum);
+
+        // Hide what the visible occluders cover, rasterized on the workers.
+        // Without occluders the buffer is not cleared nor the nodes walked.
+        if (m_root->GetScene()->GetOccluderCount() > 0) {
+            m_occlusionBuffer.Begin(viewProjection);
+            if (m_root->GetScene()->GatherOccluders(m_occlusionBuffer) > 0) {
+                m_occlusionBuffer.Rasterize(&JobSystem::Get());
+                m_root->GetScene()->CullOccluded(m_occlusionBuffer, cull);
+            }
+        }
+        snapshot.cull = cull;
+        snapshot.cullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+
+        // Copy out what survived, Render only reads the snapshot
+        {
+            PROFILE_SCOPE("GatherVisible");
+            GatherVisible(m_root, snapshot);
+            GatherGpuInstances(snapshot);
+        }
+
+        // The root's per-frame inputs (the sky's), with the first camera
+        m_root->Update(m_projectionMatrix, m_cameras[0], this, snapshot);
+    }
+
+    snapshot.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Takes the first camera's view for the next Update
+void Renderer::LatchCamera() {
+    m_updateView = m_cameras[0]->GetWorldToViewmatrix();
+    m_cameraLatched = true;
+}
+
+// Adds the visible nodes with an object of a subtree to the snapshot
+// @param node: Root of the subtree
+// @param snapshot: The frame being simulated
+void Renderer::GatherVisible(SceneNode* node, FrameSnapshot& snapshot) {
+    SceneGraph* scene = node->GetScene();
+    unsigned int flags = scene->GetFlags(node->GetSceneIndex());
+    if (!(flags & NodeFlagSubtreeVisible)) {
+        return;
+    }
+    // Nodes of the GPU driven path are culled and drawn by GpuCulling
+    if (node->GetObject() != nullptr && (flags & NodeFlagVisible) && node->GetGpuInstance() < 0) {
+        VisibleNode visible;
+        visible.node = node;
+        visible.world = scene->GetWorldTransform(node->GetSceneIndex()).GetMatrix();
+        snapshot.visible.push_back(visible);
+    }
+    for (SceneNode* child = node->GetFirstChild(); child != nullptr; child = child->GetNextSibling()) {
+        GatherVisible(child, snapshot);
     }
 }
 
+// Adds the GPU culled nodes whose world transform was recomputed, or all
+// of them after nodes were added
+// @param snapshot: The frame being simulated
+void Renderer::GatherGpuInstances(FrameSnapshot& snapshot) {
+    for (SceneNode* node : m_gpuCulledNodes) {
+        SceneGraph* scene = node->GetScene();
+        int index = node->GetSceneIndex();
+        if (m_gpuInstancesAdded || (scene->GetFlags(index) & NodeFlagWorldChanged)) {
+            snapshot.gpuInstances.push_back(GpuInstanceUpdate{ node->GetGpuInstance(), scene->GetWorldTransform(index).GetMatrix() });
+        }
+    }
+    m_gpuInstancesAdded = false;
+}
+
 // Renders the scene, setting up the OpenGL state and drawing the scene graph
 void Renderer::Render() {
+    PROFILE_SCOPE("Render");
+    PROFILE_GPU_SCOPE("Render");
+    auto start = std::chrono::steady_clock::now();
+    const FrameSnapshot& snapshot = m_snapshots[m_updateSnapshot ^ 1];
+    m_stats.worldTransformsRecomputed = snapshot.worldTransformsRecomputed;
+    m_stats.nodesVisible = snapshot.cull.visible;
+    m_stats.nodesCulled = snapshot.cull.culled;
+    m_stats.subtreesRejected = snapshot.cull.subtreesRejected;
+    m_stats.occlusionTested = snapshot.cull.occlusionTested;
+    m_stats.occluded = snapshot.cull.occluded;
+    m_stats.updateMs = snapshot.updateMs;
+    m_stats.cullMs = snapshot.cullMs;
+
+    // Late latch: the camera as it is now, after the input that arrived
+    // since the update
+    m_renderView = m_lateLatch ? m_cameras[0]->GetWorldToViewmatrix() : snapshot.view;
+
+    // The last render's packets are done with
+    m_stats.frameArenaBytes = snapshot.frameArenaBytes + m_renderArena.GetUsed();
+    m_renderArena.Reset();
+
+    // Count this frame's binds and enables from here
+    GLState::BeginFrame();
+    // Take the next region of the ring, waiting if the GPU still reads it
+    m_frameRing.BeginFrame();
+    m_stats.ringStallMs = m_frameRing.GetStallMs();
+
     // Enable depth testing (Z-buffer) to handle 3D object depth
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D); // Enable 2D textures
+    GLState::Enable(GL_DEPTH_TEST);
 
     // Set the viewport to the full screen dimensions
-    glViewport(0, 0, m_screenWidth, m_screenHeight);
+    GLState::Viewport(0, 0, m_screenWidth, m_screenHeight);
 
     // Set the background color (dark gray)
     glClearColor(0.01f, 0.01f, 0.01f, 1.f);
@@ -61,10 +193,146 @@ void Renderer::Render() {
     // Debug: Render in wireframe mode
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    // Draw the scene graph starting from the root node
+    // Record the visible nodes of the snapshot, then draw them sorted by
+    // shader, texture and vertex array, instancing the nodes that share a mesh
     if (m_root != nullptr) {
-        m_root->Draw();
+        RecordCommands();
+        m_queue.Sort();
+        m_queue.Execute();
+        m_stats.drawPackets = m_queue.GetStats().packets;
+        m_stats.stateChangesUnsorted = m_queue.GetStats().stateChangesUnsorted;
+        m_stats.stateChangesSorted = m_queue.GetStats().stateChangesSorted;
+        m_stats.drawCalls = m_queue.GetStats().drawCalls;
+        m_stats.triangles = m_queue.GetStats().triangles;
+        m_stats.instancedDraws = m_queue.GetStats().instancedDraws;
+        m_stats.instances = m_queue.GetStats().instances;
+        m_stats.indirectDraws = m_queue.GetStats().indirectDraws;
+        m_stats.submitMs = m_queue.GetStats().submitMs;
+        m_stats.uploadBytes = m_queue.GetStats().uploadBytes;
+    }
+
+    // Instances of the GPU driven path: culled by a compute shader and drawn
+    // with one call, then this frame's depth is kept for the next frame's
+    // occlusion test
+    if (m_gpuCulling.IsInitialized()) {
+        PROFILE_SCOPE("GpuCulling");
+        PROFILE_GPU_SCOPE("GpuCulling");
+        // An older snapshot may name instances cleared since
+        for (const GpuInstanceUpdate& update : snapshot.gpuInstances) {
+            if ((size_t)update.instance < m_gpuCulling.GetInstanceCount()) {
+                m_gpuCulling.SetInstanceTransform(update.instance, update.world);
+            }
+        }
+        m_gpuCulling.Cull(snapshot.projection * m_renderView);
+        m_gpuCulling.Draw(m_renderView, snapshot.projection);
+        m_gpuCulling.BuildDepthPyramid(m_screenWidth, m_screenHeight);
+        m_stats.gpuCullInstances = m_gpuCulling.GetInstanceCount();
+    }
+
+    // Every draw reading this frame's region has been issued
+    m_frameRing.EndFrame();
+
+    m_stats.glCallsIssued = GLState::GetIssued();
+    m_stats.glCallsElided = GLState::GetElided();
+    m_stats.renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Records the packets of the render snapshot's visible nodes into the
+// queue, spread over the job workers for large snapshots. Each worker
+// fills its own CommandList and the GL thread appends them in order, so the
+// packets come out the same as recorded by one thread.
+void Renderer::RecordCommands() {
+    PROFILE_SCOPE("RecordCommands");
+    auto start = std::chrono::steady_clock::now();
+    const FrameSnapshot& snapshot = m_snapshots[m_updateSnapshot ^ 1];
+    m_queue.Begin(m_renderView, snapshot.projection, 512.0f);
+
+    JobSystem& jobs = JobSystem::Get();
+    size_t count = snapshot.visible.size();
+    size_t listCount = 1;
+    if (m_parallelRecording && count >= 2 * s_recordGrainSize) {
+        listCount = std::min((size_t)jobs.GetThreadCount(), count / s_recordGrainSize);
+    }
+
+    if (listCount <= 1) {
+        for (const VisibleNode& visible : snapshot.visible) {
+            visible.node->Submit(m_queue.GetCommandList(), visible.world, snapshot);
+        }
+    } else {
+        if (m_commandLists.size() < listCount) {
+            m_commandLists.resize(listCount);
+        }
+        size_t grainSize = (count + listCount - 1) / listCount;
+        listCount = (count + grainSize - 1) / grainSize;
+        bool indirect = m_queue.IsIndirectEnabled();
+        jobs.ParallelFor(0, count, grainSize, [&](size_t begin, size_t end) {
+            CommandList& list = m_commandLists[begin / grainSize];
+            list.Begin(m_renderView, 512.0f, indirect, &m_renderArena);
+            for (size_t i = begin; i < end; ++i) {
+                snapshot.visible[i].node->Submit(list, snapshot.visible[i].world, snapshot);
+            }
+        });
+        for (size_t i = 0; i < listCount; ++i) {
+            m_queue.Append(m_commandLists[i]);
+        }
+    }
+
+    m_stats.commandLists = listCount;
+    m_stats.recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Compiles the GPU culling shaders. Instances are drawn from the default
+// MeshPool with the indirect variant of the default object shaders.
+void Renderer::EnableGpuCulling() {
+    if (m_gpuCulling.Init("shaders/cull_comp.glsl", "shaders/depth_pyramid_comp.glsl",
+                          "shaders/vert_indirect.glsl", "shaders/frag.glsl")) {
+        m_gpuCulling.SetMeshPool(&MeshPool::GetDefault());
+        m_gpuCulling.SetFrameRing(&m_frameRing);
+    }
+}
+
+// Registers the nodes of a subtree that draw a mesh of the default
+// MeshPool as GpuCulling instances. Their matrices are sent by the next
+// Update, once their world transforms are known.
+// @param root: Root of the subtree, e.g. a StressScene
+// @return Number of nodes registered
+size_t Renderer::AddGpuCulledNodes(SceneNode* root) {
+    if (!m_gpuCulling.IsInitialized() || root == nullptr) {
+        return 0;
+    }
+    size_t added = 0;
+    std::vector<SceneNode*> stack(1, root);
+    while (!stack.empty()) {
+        SceneNode* node = stack.back();
+        stack.pop_back();
+        for (SceneNode* child = node->GetFirstChild(); child != nullptr; child = child->GetNextSibling()) {
+            stack.push_back(child);
+        }
+        Object* object = node->GetObject();
+        if (object == nullptr || object->GetMeshPool() != &MeshPool::GetDefault() || node->GetGpuInstance() >= 0) {
+            continue;
+        }
+        // One texture for every instance, the first node's
+        if (m_gpuCulledNodes.empty()) {
+            m_gpuCulling.SetTexture(object->GetDiffuseTexture());
+        }
+        int instance = m_gpuCulling.AddInstance(object->GetMeshRange(), glm::mat4(1.0f), object->GetBounds());
+        node->SetGpuInstance(instance);
+        m_gpuCulledNodes.push_back(node);
+        ++added;
+    }
+    m_gpuInstancesAdded = m_gpuInstancesAdded || added > 0;
+    std::cout << "GpuCulling: " << m_gpuCulledNodes.size() << " instances" << std::endl;
+    return added;
+}
+
+// Removes every instance of the GPU driven path
+void Renderer::ClearGpuCulledNodes() {
+    for (SceneNode* node : m_gpuCulledNodes) {
+        node->SetGpuInstance(-1);
     }
+    m_gpuCulledNodes.clear();
+    m_gpuCulling.Clear();
 }
 
 // Sets the root node of the scene graph
@@ -1,10 +1,24 @@
 #include "SDLGraphicsProgram.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 
 // Constructor: Initializes the SDL graphics program
 // @param w: Window width
 // @param h: Window height
-SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
+// @param hidden: Keep the window hidden, for rendering offscreen only
+SDLGraphicsProgram::SDLGraphicsProgram(int w, int h, bool hidden){
+	PROFILE_THREAD_NAME("GL thread");
+	PROFILE_SCOPE("Startup");
+	// Time each startup phase for the benchmark report
+	double phaseStart = FramePacer::Now();
+	auto endPhase = [this, &phaseStart](const char* name){
+		double now = FramePacer::Now();
+		m_startupPhases.push_back(std::make_pair(std::string(name), (now - phaseStart) * 1000.0));
+		phaseStart = now;
+	};
 	// Initialization flag
 	bool success = true;
 	// String to hold any errors that occur.
@@ -12,19 +26,25 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
 	// Initialize the window pointer
 	m_window = NULL;
 
+#if defined(LINUX)
+	// Without a display, render through SDL's offscreen driver (EGL, e.g.
+	// Mesa's llvmpipe), unless a driver was asked for
+	if(hidden && SDL_getenv("DISPLAY") == NULL && SDL_getenv("WAYLAND_DISPLAY") == NULL){
+		SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+	}
+#endif
 	// Initialize SDL
 	if(SDL_Init(SDL_INIT_VIDEO)< 0){
 		errorStream << "SDL could not initialize! SDL Error: " << SDL_GetError() << "\n";
 		success = false;
 	}
 	else{
-		//Use OpenGL 3.3 core
-		SDL_GL_SetAttribute( SDL_GL_CONTEXT_MAJOR_VERSION, 3 );
-		SDL_GL_SetAttribute( SDL_GL_CONTEXT_MINOR_VERSION, 3 );
+		//Use an OpenGL core profile
 		SDL_GL_SetAttribute( SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE );
 		// request a double buffer for smooth updating.
 		SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 		SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+		endPhase("sdlInit");
 
 		//Create window
 		m_window = SDL_CreateWindow( "Lab",
@@ -32,7 +52,8 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
                                 SDL_WINDOWPOS_UNDEFINED,
                                 w,
                                 h,
-                                SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN );
+                                SDL_WINDOW_OPENGL | (hidden ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN) );
+		endPhase("window");
 
 		// Check if Window created.
 		if( m_window == NULL ){
@@ -41,7 +62,18 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
 		}
 
 		//Create an OpenGL Graphics Context
-		m_openGLContext = SDL_GL_CreateContext( m_window );
+		// Prefer 4.3 for the optional compute paths, and fall back to 3.3
+		// where 4.3 is not available (e.g. macOS stops at 4.1).
+		const int glVersions[][2] = { {4, 3}, {3, 3} };
+		m_openGLContext = NULL;
+		for(const auto& version : glVersions){
+			SDL_GL_SetAttribute( SDL_GL_CONTEXT_MAJOR_VERSION, version[0] );
+			SDL_GL_SetAttribute( SDL_GL_CONTEXT_MINOR_VERSION, version[1] );
+			m_openGLContext = SDL_GL_CreateContext( m_window );
+			if( m_openGLContext != NULL){
+				break;
+			}
+		}
 		if( m_openGLContext == NULL){
 			errorStream << "OpenGL context could not be created! SDL Error: " << SDL_GetError() << "\n";
 			success = false;
@@ -52,6 +84,9 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
 			errorStream << "Failed to iniitalize GLAD\n";
 			success = false;
 		}
+		// Load the entry points glad does not cover
+		GLExtensions::Load(SDL_GL_GetProcAddress);
+		endPhase("glContext");
 
 		//Initialize OpenGL
 		if(!InitGL()){
@@ -68,13 +103,18 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
     }else{
         SDL_Log("SDLGraphicsProgram::SDLGraphicsProgram - No SDL, GLAD, or OpenGL, errors detected during initialization\n\n");
     }
+    m_initialized = success;
 
 	// SDL_LogSetAllPriority(SDL_LOG_PRIORITY_WARN); // debug
 	GetOpenGLVersionInfo();
 
+    // Start the worker threads here, so this (the GL thread) is the job
+    // system's main thread
+    JobSystem::Get();
 
     // Setup Renderer
     m_renderer = new Renderer(w,h);
+    endPhase("renderer");
     // Set start time
     Uint32 startTime = SDL_GetTicks();
     m_renderer->SetStartTime(startTime);    
@@ -83,6 +123,8 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
 
 // Destructor: Cleans up resources and shuts down SDL
 SDLGraphicsProgram::~SDLGraphicsProgram(){
+    // A capture still running needs the context to read its GPU zones
+    Profiler::Get().EndCapture();
     if(m_renderer!=nullptr){
         delete m_renderer;
     }
@@ -102,49 +144,57 @@ bool SDLGraphicsProgram::InitGL(){
 	return success;
 }
 
-// Processes user input, including keyboard and mouse events
+// Applies the input that arrived since the last call to the camera.
+// Called at the top of the frame, and again right before rendering to
+// latch the camera late. While a camera path plays, only quit is taken.
 // @param quit: Flag to indicate whether the program should quit
 // @param cameraSpeed: Speed at which the camera moves
 void SDLGraphicsProgram::Input(bool& quit, float cameraSpeed) {
-    SDL_Event e;
+    PROFILE_SCOPE("Input");
+    m_input.Pump();
+    InputEvent e;
     //Handle events on queue
-    while(SDL_PollEvent( &e ) != 0){
+    while(m_input.Pop(e)){
+        m_cameraPath.RecordEvent(e);
         // User posts an event to quit
-        if(e.type == SDL_QUIT){
+        if(e.type == InputEventQuit){
             quit = true;
+            continue;
+        }
+        // The camera path moves the camera
+        if(m_playing){
+            continue;
         }
+        // The next frame shows this input
+        m_latency.AddInput(e.time);
         // Handle keyboard input for the camera class
-        if(e.type==SDL_MOUSEMOTION){
+        if(e.type == InputEventMouseMotion){
             // Handle mouse movements
-            int mouseX = e.motion.x;
-            int mouseY = e.motion.y;
-            // m_renderer->SetMousePosition(mouseX, mouseY);
-            m_renderer->GetCamera(0)->MouseLook(mouseX, mouseY);
-        }
-        switch(e.type){
-            // Handle keyboard presses
-            case SDL_KEYDOWN:
-                switch(e.key.keysym.sym){
-                    case SDLK_LEFT:
-                        m_renderer->GetCamera(0)->MoveLeft(cameraSpeed);
-                        break;
-                    case SDLK_RIGHT:
-                        m_renderer->GetCamera(0)->MoveRight(cameraSpeed);
-                        break;
-                    case SDLK_UP:
-                        m_renderer->GetCamera(0)->MoveForward(cameraSpeed);
-                        break;
-                    case SDLK_DOWN:
-                        m_renderer->GetCamera(0)->MoveBackward(cameraSpeed);
-                        break;
-                    case SDLK_RSHIFT:
-                        m_renderer->GetCamera(0)->MoveUp(cameraSpeed);
-                        break;
-                    case SDLK_RCTRL:
-                        m_renderer->GetCamera(0)->MoveDown(cameraSpeed);
-                        break;
-                }
-            break;
+            // m_renderer->SetMousePosition(e.x, e.y);
+            m_renderer->GetCamera(0)->MouseLook(e.x, e.y);
+        }
+        // Handle keyboard presses
+        if(e.type == InputEventKeyDown){
+            switch(e.key){
+                case SDLK_LEFT:
+                    m_renderer->GetCamera(0)->MoveLeft(cameraSpeed);
+                    break;
+                case SDLK_RIGHT:
+                    m_renderer->GetCamera(0)->MoveRight(cameraSpeed);
+                    break;
+                case SDLK_UP:
+                    m_renderer->GetCamera(0)->MoveForward(cameraSpeed);
+                    break;
+                case SDLK_DOWN:
+                    m_renderer->GetCamera(0)->MoveBackward(cameraSpeed);
+                    break;
+                case SDLK_RSHIFT:
+                    m_renderer->GetCamera(0)->MoveUp(cameraSpeed);
+                    break;
+                case SDLK_RCTRL:
+                    m_renderer->GetCamera(0)->MoveDown(cameraSpeed);
+                    break;
+            }
         }
     }
 }
@@ -154,16 +204,28 @@ SkyboxNode* skyboxNode;
 
 // Initializes the scene graph
 void SDLGraphicsProgram::InitSceneGraph() {
+    PROFILE_SCOPE("InitSceneGraph");
     skybox = new Object();
     skyboxNode = new SkyboxNode(skybox);
     skyboxNode->Init(skybox);
+    skyboxNode->SetAuroraPath(m_auroraPath);
     m_renderer->setRoot(skyboxNode);
+    if(m_stress){
+        SceneNode* stressRoot = m_stressScene.Generate(m_stressSettings);
+        if(stressRoot != nullptr){
+            skyboxNode->AddChild(stressRoot);
+            // Culled and drawn on the GPU with --gpu-culling
+            m_renderer->AddGpuCulledNodes(stressRoot);
+        }
+    }
     std::cout << "Scene Graph Initialized" << std::endl;
 }
 
-// Updates objects in the scene
-void SDLGraphicsProgram::UpdateObjectsInScene() {
-
+// Advances the objects in the scene by one fixed simulation step
+// @param stepSeconds: Length of the step
+void SDLGraphicsProgram::UpdateObjectsInScene(double stepSeconds) {
+    PROFILE_SCOPE("UpdateObjectsInScene");
+    m_stressScene.Update(stepSeconds);
 }
 
 // Main program loop
@@ -182,26 +244,540 @@ void SDLGraphicsProgram::Loop(){
     m_renderer->GetCamera(0)->SetCameraEyePosition(0.0f,0.0f,100.0f);
     InitSceneGraph();
 
+    // Input arrives through the queue, and the camera is latched again
+    // right before the draw
+    m_input.Install();
+    m_latency.SetMaxFramesInFlight(m_framesInFlight);
+    m_renderer->SetLateLatch(m_lateLatch);
+
+    // A played camera path replaces the input and the variable time step,
+    // at a fixed quality, so every run renders the same frames
+    size_t playbackFrame = 0;
+    if(!m_playPath.empty()){
+        if(!m_cameraPath.Load(m_playPath)){
+            SDL_StopTextInput();
+            return;
+        }
+        m_playing = true;
+        m_simulationStep = m_cameraPath.GetSimulationStep();
+        m_governor.SetBudget(0.0);
+    }else if(!m_recordPath.empty()){
+        m_cameraPath.BeginRecording(m_recordPath, m_simulationStep);
+    }
+
+    // Updates the scene of the next frame while this one renders
+    SimulationThread simulation(m_renderer);
+    if(m_pipelined){
+        simulation.Start();
+    }
+    m_renderer->GetStats().pipelined = m_pipelined;
+
+    // Frames are paced by vsync when it is available and asked for,
+    // else by the pacer's limiter
+    bool vsync = m_vsync && SDL_GL_SetSwapInterval(1) == 0;
+    if(!vsync){
+        if(m_vsync){
+            std::cout << "Vsync unavailable, limiting the frame rate instead" << std::endl;
+        }
+        SDL_GL_SetSwapInterval(0);
+    }
+    m_pacer.SetTargetMs((!vsync && m_frameRateCap > 0.0) ? 1000.0 / m_frameRateCap : 0.0);
+
+    // Simulation time advances in fixed steps, what is left over is
+    // the fraction of a step the rendered state is interpolated by
+    double simulationTime = 0.0;
+    double accumulator = 0.0;
+
+    // Timers for the frame governor
+    Uint64 counterFrequency = SDL_GetPerformanceFrequency();
+    GpuTimer gpuTimer;
+    m_statsStartTime = SDL_GetTicks();
+    // Totals of the whole run, printed for recorded and played paths
+    double runStart = FramePacer::Now();
+    double runCpuMs = 0.0;
+    double runCpuMaxMs = 0.0;
+    double runGpuMs = 0.0;
+    size_t runGpuSamples = 0;
+    size_t runFrames = 0;
+
     while(!quit){
+        double frameSeconds = m_pacer.BeginFrame();
+        Uint64 frameStart = SDL_GetPerformanceCounter();
         Input(quit, cameraSpeed);
-        UpdateObjectsInScene();
-        
-        // Update our scene through our renderer
-        m_renderer->Update();
+
+        if(m_playing){
+            // One step per frame, with the camera where it was recorded
+            UpdateObjectsInScene(m_simulationStep);
+            m_renderer->SetTime(playbackFrame * m_simulationStep);
+            m_cameraPath.Apply(playbackFrame, *m_renderer->GetCamera(0));
+        }else{
+            // Run the steps this frame's time covers. After a long stall
+            // (a breakpoint, a dragged window) skip ahead instead of running
+            // many steps that would make the next frame late too.
+            accumulator += std::min(frameSeconds, s_maxSteps * m_simulationStep);
+            int steps = 0;
+            while(accumulator >= m_simulationStep && steps < s_maxSteps){
+                UpdateObjectsInScene(m_simulationStep);
+                simulationTime += m_simulationStep;
+                accumulator -= m_simulationStep;
+                ++steps;
+            }
+            // Render between the last two steps, one step behind, so the time
+            // moves smoothly however the frames and the steps line up
+            double alpha = accumulator / m_simulationStep;
+            m_renderer->SetTime(std::max(0.0, simulationTime - (1.0 - alpha) * m_simulationStep));
+        }
+
+        // Render the sky at the quality the governor picked
+        const QualityTier& tier = m_governor.GetTier();
+        m_renderer->SetSkyQuality(tier.skyResolutionScale, tier.auroraSteps);
+
+        // Update our scene through our renderer. Pipelined, the update
+        // runs on the simulation thread while the last update's snapshot
+        // renders, and the camera and scene stay untouched until Wait.
+        m_renderer->LatchCamera();
+        simulation.Kick();
+        if(!m_pipelined){
+            simulation.Wait();
+            m_renderer->SwapSnapshots();
+        }
+
+        // OpenGL work handed over by jobs
+        JobSystem::Get().PumpMainThread();
+
+        // Wait for the GPU to catch up before sampling input, so the
+        // input is as recent as possible when the frame is shown
+        m_latency.BeginFrame();
+        if(m_lateLatch){
+            Input(quit, cameraSpeed);
+        }
+
+        // The camera as it renders this frame
+        m_cameraPath.RecordFrame(m_renderer->GetTime(), *m_renderer->GetCamera(0));
 
         // Render our scene using our selected renderer
+        gpuTimer.Begin();
         m_renderer->Render();
+        gpuTimer.End();
 
-        // Add delay to control frame rate
-        SDL_Delay(25);
+        if(m_pipelined){
+            simulation.Wait();
+            m_renderer->SwapSnapshots();
+        }
+
+        // Feed the governor with this frame's CPU time and the newest
+        // GPU time that is ready, without waiting for the GPU
+        double cpuMs = (SDL_GetPerformanceCounter() - frameStart) * 1000.0 / counterFrequency;
+        double gpuMs = -1.0;
+        if(!gpuTimer.Poll(gpuMs)){
+            gpuMs = -1.0;
+        }
+        m_governor.Update(cpuMs, gpuMs);
+        ReportStats(cpuMs, gpuMs);
+        ++runFrames;
+        runCpuMs += cpuMs;
+        runCpuMaxMs = std::max(runCpuMaxMs, cpuMs);
+        if(gpuMs >= 0.0){
+            ++runGpuSamples;
+            runGpuMs += gpuMs;
+        }
+        if(m_playing && ++playbackFrame == m_cameraPath.GetFrameCount()){
+            quit = true;
+        }
+
+        // Hold the frame until its deadline (nothing to do with vsync)
+        m_pacer.Wait();
 
       	//Update screen of our specified window
-      	SDL_GL_SwapWindow(GetSDLWindow());
+        {
+            PROFILE_SCOPE("SwapWindow");
+            SDL_GL_SwapWindow(GetSDLWindow());
+        }
+        m_latency.EndFrame();
+        Profiler::Get().EndFrame();
+        FlightRecorder::Get().EndFrame();
 	}
+    m_latency.Finish();
+    m_cameraPath.EndRecording();
+    if(m_playing || !m_recordPath.empty()){
+        std::cout << (m_playing ? "[Playback] " : "[Recording] ")
+                  << runFrames << " frames in " << (FramePacer::Now() - runStart) << " s"
+                  << " | CPU avg " << (runFrames > 0 ? runCpuMs / runFrames : 0.0) << " ms"
+                  << " max " << runCpuMaxMs << " ms"
+                  << " | GPU avg " << (runGpuSamples > 0 ? runGpuMs / runGpuSamples : 0.0) << " ms"
+                  << std::endl;
+    }
     //Disable text input
     SDL_StopTextInput();
 }
 
+// Accumulates frame times, and once per second prints their averages
+// along with the governor's decisions
+// @param cpuMs: CPU time of the frame
+// @param gpuMs: GPU time of a recent frame, negative if none was available
+void SDLGraphicsProgram::ReportStats(double cpuMs, double gpuMs){
+    ++m_statsFrames;
+    m_statsCpuMs += cpuMs;
+    if(gpuMs >= 0.0){
+        ++m_statsGpuSamples;
+        m_statsGpuMs += gpuMs;
+    }
+
+    Uint32 elapsed = SDL_GetTicks() - m_statsStartTime;
+    if(elapsed < 1000){
+        return;
+    }
+
+    FrameStats& stats = m_renderer->GetStats();
+    stats.cpuFrameMs = m_statsCpuMs / m_statsFrames;
+    stats.gpuFrameMs = (m_statsGpuSamples > 0) ? m_statsGpuMs / m_statsGpuSamples : 0.0;
+    stats.qualityTier = m_governor.GetTierIndex();
+    stats.skyResolutionScale = m_governor.GetTier().skyResolutionScale;
+    stats.auroraSteps = m_governor.GetTier().auroraSteps;
+    stats.governorDecision = m_governor.GetLastDecision();
+    stats.inputLatencyMs = m_latency.GetAverageMs();
+    stats.inputLatencyMaxMs = m_latency.GetMaxMs();
+    stats.framesInFlightWaitMs = m_latency.GetWaitMs() / m_statsFrames;
+    m_latency.Reset();
+    stats.Print(std::cout, m_statsFrames * 1000.0 / elapsed);
+    m_pacer.PrintJitter(std::cout);
+    m_pacer.ResetJitter();
+
+    m_statsStartTime = SDL_GetTicks();
+    m_statsFrames = 0;
+    m_statsGpuSamples = 0;
+    m_statsCpuMs = 0.0;
+    m_statsGpuMs = 0.0;
+}
+
+// Nearest rank percentile
+// @param sorted: Samples in ascending order, not empty
+// @param percent: 0 to 100
+static double Percentile(const std::vector<double>& sorted, double percent){
+    size_t rank = (size_t)std::ceil(percent / 100.0 * sorted.size());
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+// Writes the distribution of frame times as a JSON object
+// @param out: Stream to write to
+// @param samples: Frame times in milliseconds, sorted in place
+static void WriteTimingsJson(std::ostream& out, std::vector<double>& samples){
+    std::sort(samples.begin(), samples.end());
+    out << "{\"samples\": " << samples.size();
+    if(!samples.empty()){
+        double total = 0.0;
+        for(double sample : samples){
+            total += sample;
+        }
+        out << ", \"avg\": " << total / samples.size()
+            << ", \"min\": " << samples.front()
+            << ", \"p50\": " << Percentile(samples, 50.0)
+            << ", \"p95\": " << Percentile(samples, 95.0)
+            << ", \"p99\": " << Percentile(samples, 99.0)
+            << ", \"max\": " << samples.back();
+    }
+    out << "}";
+}
+
+// Renders frames into the bound framebuffer with the camera where it is,
+// one simulation step per frame at the governor's current quality.
+// GPU times are read a few frames late, as in Loop, so the GPU is never
+// waited on except by the frames in flight limit.
+// @param warmupFrames: Frames rendered first and not measured
+// @param frames: Frames measured
+// @param samples: Receives the measurements
+void SDLGraphicsProgram::MeasureFrames(int warmupFrames, int frames, FrameSamples& samples){
+    m_latency.SetMaxFramesInFlight(m_framesInFlight);
+    m_renderer->SetLateLatch(m_lateLatch);
+    SimulationThread simulation(m_renderer);
+    if(m_pipelined){
+        simulation.Start();
+    }
+    m_renderer->GetStats().pipelined = m_pipelined;
+    const QualityTier& tier = m_governor.GetTier();
+    m_renderer->SetSkyQuality(tier.skyResolutionScale, tier.auroraSteps);
+
+    GpuTimer gpuTimer;
+    samples = FrameSamples();
+    samples.cpuMs.reserve(frames);
+    samples.gpuMs.reserve(frames);
+    for(int frame = 0; frame < warmupFrames + frames; ++frame){
+        double frameStart = FramePacer::Now();
+        UpdateObjectsInScene(m_simulationStep);
+        m_renderer->SetTime(frame * m_simulationStep);
+        m_renderer->LatchCamera();
+        simulation.Kick();
+        if(!m_pipelined){
+            simulation.Wait();
+            m_renderer->SwapSnapshots();
+        }
+        JobSystem::Get().PumpMainThread();
+        m_latency.BeginFrame();
+
+        gpuTimer.Begin();
+        m_renderer->Render();
+        gpuTimer.End();
+
+        if(m_pipelined){
+            simulation.Wait();
+            m_renderer->SwapSnapshots();
+        }
+        double elapsedMs = (FramePacer::Now() - frameStart) * 1000.0;
+        if(frame == 0){
+            samples.firstFrameMs = elapsedMs;
+        }
+        double gpuSample = -1.0;
+        bool gpuReady = gpuTimer.Poll(gpuSample);
+        if(frame >= warmupFrames){
+            const FrameStats& stats = m_renderer->GetStats();
+            samples.cpuMs.push_back(elapsedMs);
+            if(gpuReady){
+                samples.gpuMs.push_back(gpuSample);
+            }
+            samples.updateMs.push_back(stats.updateMs);
+            samples.cullMs.push_back(stats.cullMs);
+            samples.recordMs.push_back(stats.recordMs);
+            samples.submitMs.push_back(stats.submitMs);
+            samples.drawCalls += stats.drawCalls;
+            samples.triangles += stats.triangles;
+            samples.drawPackets += stats.drawPackets;
+        }
+        // Nothing is swapped, the fence alone keeps the GPU close
+        glFlush();
+        m_latency.EndFrame();
+        Profiler::Get().EndFrame();
+    }
+    m_latency.Finish();
+    double gpuSample = 0.0;
+    while((int)samples.gpuMs.size() < frames && gpuTimer.Poll(gpuSample)){
+        samples.gpuMs.push_back(gpuSample);
+    }
+}
+
+// Renders frames offscreen with the camera at its default position and
+// reports on them
+// @param frames: Frames measured
+// @param warmupFrames: Frames rendered first and not measured
+// @param output: File the JSON report is written to, stdout if empty
+// @return false if the report could not be written
+bool SDLGraphicsProgram::RunBenchmark(int frames, int warmupFrames, const std::string& output){
+    double phaseStart = FramePacer::Now();
+    m_renderer->GetCamera(0)->SetCameraEyePosition(0.0f,0.0f,100.0f);
+    InitSceneGraph();
+    m_startupPhases.push_back(std::make_pair(std::string("scene"), (FramePacer::Now() - phaseStart) * 1000.0));
+
+    // Render into a framebuffer of our own, a hidden window's may not be
+    // backed by anything
+    int width = (int)m_renderer->GetScreenWidth();
+    int height = (int)m_renderer->GetScreenHeight();
+    RenderTarget target;
+    target.Create(width, height);
+    target.Bind();
+    FrameSamples samples;
+    MeasureFrames(warmupFrames, frames, samples);
+    target.Unbind();
+    m_startupPhases.push_back(std::make_pair(std::string("firstFrame"), samples.firstFrameMs));
+
+    std::ofstream file;
+    if(!output.empty()){
+        file.open(output);
+        if(!file){
+            std::cout << "Could not write the benchmark report to " << output << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+    std::string rendererName = (const char*)glGetString(GL_RENDERER);
+    std::replace(rendererName.begin(), rendererName.end(), '"', '\'');
+    int measured = std::max(frames, 1);
+    out << "{\n"
+        << "  \"renderer\": \"" << rendererName << "\",\n"
+        << "  \"width\": " << width << ",\n"
+        << "  \"height\": " << height << ",\n"
+        << "  \"frames\": " << frames << ",\n"
+        << "  \"warmupFrames\": " << warmupFrames << ",\n"
+        << "  \"qualityTier\": \"" << m_governor.GetTier().name << "\",\n"
+        << "  \"pipelined\": " << (m_pipelined ? "true" : "false") << ",\n"
+        << "  \"cpuFrameMs\": ";
+    WriteTimingsJson(out, samples.cpuMs);
+    out << ",\n  \"gpuFrameMs\": ";
+    WriteTimingsJson(out, samples.gpuMs);
+    out << ",\n"
+        << "  \"drawCalls\": " << samples.drawCalls / measured << ",\n"
+        << "  \"triangles\": " << samples.triangles / measured << ",\n"
+        << "  \"drawPackets\": " << samples.drawPackets / measured << ",\n"
+        << "  \"startupMs\": {";
+    for(size_t i = 0; i < m_startupPhases.size(); ++i){
+        out << (i > 0 ? ", " : "") << "\"" << m_startupPhases[i].first << "\": " << m_startupPhases[i].second;
+    }
+    out << "}\n}" << std::endl;
+    if(!output.empty()){
+        std::cout << "Benchmark report written to " << output << std::endl;
+    }
+    return static_cast<bool>(out);
+}
+
+// Median of samples
+// @param samples: Sorted in place, 0 if empty
+static double Median(std::vector<double>& samples){
+    if(samples.empty()){
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return Percentile(samples, 50.0);
+}
+
+// Generates a stress scene of each node count, renders it offscreen and
+// writes a CSV row per count: median update, cull, record and submit
+// times, their cost per node, and resident memory per node. A phase stops
+// scaling linearly where its cost per node grows; rows where it grew by
+// more than half over the previous count are pointed out.
+// @param settings: Shape of the scenes, nodeCount is replaced by each count
+// @param nodeCounts: Scene sizes, in increasing order
+// @param frames: Frames measured per scene, after a few warmup frames
+// @param output: CSV file, stdout if empty
+// @return false if the CSV could not be written or no scene was generated
+bool SDLGraphicsProgram::RunStressSweep(const StressSceneSettings& settings, const std::vector<size_t>& nodeCounts,
+                                        int frames, const std::string& output){
+    std::ofstream file;
+    if(!output.empty()){
+        file.open(output);
+        if(!file){
+            std::cout << "Could not write the stress sweep to " << output << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+    out << "nodes,depth,branching,dynamic,visible,update_ms,cull_ms,record_ms,submit_ms,cpu_ms,gpu_ms,"
+           "update_ns_per_node,cull_ns_per_node,submit_ns_per_node,bytes_per_node" << std::endl;
+
+    // Pull the camera back far enough to see the largest scenes
+    m_renderer->GetCamera(0)->SetCameraEyePosition(0.0f,0.0f,400.0f);
+    int width = (int)m_renderer->GetScreenWidth();
+    int height = (int)m_renderer->GetScreenHeight();
+    RenderTarget target;
+    target.Create(width, height);
+    target.Bind();
+
+    // Memory is measured against the process before the first scene. The
+    // pools keep their chunks, so with increasing counts each scene reuses
+    // the last one's memory and the difference is the scene's own.
+    size_t baselineBytes = StressScene::GetResidentBytes();
+    const char* phases[3] = { "update", "cull", "submit" };
+    double previousNsPerNode[3] = { 0.0, 0.0, 0.0 };
+    bool generated = false;
+    for(size_t nodeCount : nodeCounts){
+        StressSceneSettings scene = settings;
+        scene.nodeCount = nodeCount;
+        SceneNode* root = m_stressScene.Generate(scene);
+        if(root == nullptr){
+            break;
+        }
+        generated = true;
+        m_renderer->setRoot(root);
+        m_renderer->AddGpuCulledNodes(root);
+
+        FrameSamples samples;
+        MeasureFrames(10, frames, samples);
+        size_t residentBytes = StressScene::GetResidentBytes();
+        size_t nodes = m_stressScene.GetNodeCount();
+        double updateMs = Median(samples.updateMs);
+        double cullMs = Median(samples.cullMs);
+        double recordMs = Median(samples.recordMs);
+        double submitMs = Median(samples.submitMs);
+        double nsPerNode[3] = { updateMs * 1.0e6 / nodes, cullMs * 1.0e6 / nodes, (recordMs + submitMs) * 1.0e6 / nodes };
+        double bytesPerNode = (residentBytes > baselineBytes) ? (double)(residentBytes - baselineBytes) / nodes : 0.0;
+        out << nodes << "," << m_stressScene.GetDepth() << "," << scene.branching << ","
+            << m_stressScene.GetDynamicCount() << "," << m_renderer->GetStats().nodesVisible << ","
+            << updateMs << "," << cullMs << "," << recordMs << "," << submitMs << ","
+            << Median(samples.cpuMs) << "," << Median(samples.gpuMs) << ","
+            << nsPerNode[0] << "," << nsPerNode[1] << "," << nsPerNode[2] << "," << bytesPerNode << std::endl;
+        for(int p = 0; p < 3; ++p){
+            if(previousNsPerNode[p] > 0.0 && nsPerNode[p] > 1.5 * previousNsPerNode[p]){
+                std::cout << "[Stress] " << phases[p] << " stops scaling linearly at " << nodes << " nodes: "
+                          << previousNsPerNode[p] << " -> " << nsPerNode[p] << " ns per node" << std::endl;
+            }
+            previousNsPerNode[p] = nsPerNode[p];
+        }
+
+        // Both snapshots still point at the scene's nodes, empty them
+        // before the nodes go
+        m_renderer->setRoot(nullptr);
+        for(int i = 0; i < 2; ++i){
+            m_renderer->Update();
+            m_renderer->SwapSnapshots();
+        }
+        m_renderer->ClearGpuCulledNodes();
+        m_stressScene.Clear();
+    }
+    target.Unbind();
+    if(!output.empty()){
+        std::cout << "Stress sweep written to " << output << std::endl;
+    }
+    return generated && static_cast<bool>(out);
+}
+
+// Renders the sky offscreen with the fragment and compute aurora paths at
+// several resolutions, and prints the average GPU time per frame of each
+void SDLGraphicsProgram::BenchmarkAurora(){
+    const int resolutions[][2] = { {640, 360}, {1280, 720}, {1920, 1080}, {2560, 1440} };
+    const int warmupFrames = 10;
+    const int measuredFrames = 60;
+
+    InitSceneGraph();
+    unsigned int screenWidth = m_renderer->GetScreenWidth();
+    unsigned int screenHeight = m_renderer->GetScreenHeight();
+
+    RenderTarget target;
+    GpuTimer timer;
+
+    std::cout << "Aurora benchmark: average GPU ms per frame over " << measuredFrames << " frames\n";
+    std::cout << "resolution\tfragment\tcompute\n";
+    for(const auto& resolution : resolutions){
+        target.Create(resolution[0], resolution[1]);
+        m_renderer->SetScreenSize(resolution[0], resolution[1]);
+
+        double averageMs[2] = { -1.0, -1.0 };
+        const AuroraPath paths[2] = { AuroraPath::Fragment, AuroraPath::Compute };
+        for(int p = 0; p < 2; ++p){
+            skyboxNode->SetAuroraPath(paths[p]);
+            if(skyboxNode->GetAuroraPath() != paths[p]){
+                continue; // compute path unavailable
+            }
+            target.Bind();
+            double totalMs = 0.0;
+            for(int frame = 0; frame < warmupFrames + measuredFrames; ++frame){
+                m_renderer->SetTime(frame / 60.0);
+                m_renderer->Update();
+                m_renderer->SwapSnapshots();
+                timer.Begin();
+                m_renderer->Render();
+                timer.End();
+                double elapsedMs = timer.WaitElapsedMs();
+                if(frame >= warmupFrames){
+                    totalMs += elapsedMs;
+                }
+            }
+            averageMs[p] = totalMs / measuredFrames;
+        }
+
+        std::cout << resolution[0] << "x" << resolution[1];
+        for(int p = 0; p < 2; ++p){
+            if(averageMs[p] < 0.0){
+                std::cout << "\tn/a";
+            }else{
+                std::cout << "\t" << averageMs[p];
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // Restore the window as the render target
+    target.Unbind();
+    m_renderer->SetScreenSize(screenWidth, screenHeight);
+    skyboxNode->SetAuroraPath(m_auroraPath);
+}
+
 
 // Get Pointer to Window
 SDL_Window* SDLGraphicsProgram::GetSDLWindow(){
@@ -0,0 +1,501 @@
+#include "SceneGraph.hpp"
+#include "Profiler.hpp"
+#include "SceneNode.hpp"
+#include "JobSystem.hpp"
+#include "Frustum.hpp"
+#include "OcclusionBuffer.hpp"
+
+#include <atomic>
+#include <cassert>
+
+const int SceneGraph::s_noParent;
+const size_t SceneGraph::s_parallelThreshold;
+const size_t SceneGraph::s_parallelGrainSize;
+
+// Constructor
+SceneGraph::SceneGraph() {}
+
+// Destructor: nodes own themselves, the arrays go with the graph
+SceneGraph::~SceneGraph() {
+    delete m_spatialIndex;
+}
+
+// Returns the storage nodes are created in unless told otherwise
+SceneGraph& SceneGraph::GetDefault() {
+    static SceneGraph defaultGraph;
+    return defaultGraph;
+}
+
+// Adds a root node at the end of the arrays
+// @param node: The handle to keep in sync with the node's index
+// @return The index of the new node
+int SceneGraph::Add(SceneNode* node) {
+    m_localTransforms.emplace_back();
+    m_worldTransforms.emplace_back();
+    m_parents.push_back(s_noParent);
+    // Visible until the first Cull, for renderers that never cull
+    m_flags.push_back(NodeFlagAlive | NodeFlagVisible | NodeFlagSubtreeVisible);
+    m_localBounds.emplace_back();
+    m_worldBounds.emplace_back();
+    m_subtreeBounds.emplace_back();
+    m_spatialHandles.push_back(LooseOctree::s_invalidHandle);
+    m_nodes.push_back(node);
+    m_structureChanged = true;
+    m_levelsValid = false;
+    return (int)m_nodes.size() - 1;
+}
+
+// Frees the slot of a node
+// @param index: Index of the node to remove
+void SceneGraph::Remove(int index) {
+    if (m_flags[index] & NodeFlagOccluder) {
+        --m_occluderCount;
+    }
+    m_flags[index] = 0;
+    m_localBounds[index] = AABB();
+    if (m_spatialHandles[index] != LooseOctree::s_invalidHandle) {
+        m_spatialIndex->Remove(m_spatialHandles[index]);
+        m_spatialHandles[index] = LooseOctree::s_invalidHandle;
+    }
+    m_nodes[index] = nullptr;
+    m_parents[index] = s_noParent;
+    m_needsSort = true;
+    m_structureChanged = true;
+    m_levelsValid = false;
+}
+
+// Attaches a node below another one
+// @param child: Index of the child node
+// @param parent: Index of the new parent
+void SceneGraph::SetParent(int child, int parent) {
+    m_parents[child] = parent;
+    m_flags[child] |= NodeFlagReparented;
+    m_structureChanged = true;
+    m_levelsValid = false;
+    // Attaching a new node to an existing parent keeps the order, anything
+    // else may leave the child (and its subtree) before its parent
+    if (parent > child) {
+        m_needsSort = true;
+    }
+}
+
+// Sets the object space bounds of a node's geometry
+// @param index: Index of the node
+// @param bounds: Bounds of its geometry, empty if it draws nothing
+void SceneGraph::SetLocalBounds(int index, const AABB& bounds) {
+    m_localBounds[index] = bounds;
+    if (bounds.IsEmpty()) {
+        m_flags[index] &= ~NodeFlagHasBounds;
+    } else {
+        m_flags[index] |= NodeFlagHasBounds;
+    }
+    m_flags[index] |= NodeFlagBoundsChanged;
+    // Forces the next pass, which rebuilds the subtree bounds
+    m_structureChanged = true;
+}
+
+// Excludes a node from culling, or includes it again
+// @param index: Index of the node
+// @param cullable: False to always draw the node
+void SceneGraph::SetCullable(int index, bool cullable) {
+    if (cullable) {
+        m_flags[index] &= ~NodeFlagNeverCull;
+    } else {
+        m_flags[index] |= NodeFlagNeverCull;
+    }
+    m_structureChanged = true;
+}
+
+// Recomputes the world transforms that are out of date, parents first
+// @param jobs: Threads to spread large graphs over, nullptr for a serial pass
+void SceneGraph::UpdateWorldTransforms(JobSystem* jobs) {
+    PROFILE_SCOPE("WorldTransforms");
+    m_recomputedCount = 0;
+    const bool parallel = (jobs != nullptr) && jobs->GetThreadCount() > 1 &&
+                          m_nodes.size() >= s_parallelThreshold;
+    // The parallel pass needs the nodes grouped by depth
+    if (m_needsSort || (parallel && !m_levelsValid)) {
+        Sort();
+    }
+
+    // Nothing moved and nothing was attached or removed: a static scene
+    // costs one comparison, plus clearing last pass's flags once
+    if (!m_structureChanged && !m_localsTouched) {
+        if (m_hasWorldChangedFlags) {
+            for (size_t i = 0; i < m_flags.size(); ++i) {
+                m_flags[i] &= ~NodeFlagWorldChanged;
+            }
+            m_hasWorldChangedFlags = false;
+        }
+        return;
+    }
+
+    if (parallel && m_levelsValid) {
+        // A level only reads the world transforms of the level before it
+        std::atomic<size_t> recomputed(0);
+        for (size_t level = 0; level + 1 < m_levelOffsets.size(); ++level) {
+            jobs->ParallelFor(m_levelOffsets[level], m_levelOffsets[level + 1], s_parallelGrainSize,
+                [this, &recomputed](size_t begin, size_t end) {
+                    recomputed.fetch_add(UpdateRange(begin, end), std::memory_order_relaxed);
+                });
+        }
+        m_recomputedCount = recomputed.load();
+    } else {
+        m_recomputedCount = UpdateRange(0, m_nodes.size());
+    }
+
+    // Moved or restructured nodes change the bounds of their ancestors
+    UpdateSubtreeBounds();
+    if (m_spatialIndex != nullptr) {
+        UpdateSpatialIndex(m_structureChanged);
+    }
+
+    m_hasWorldChangedFlags = (m_recomputedCount > 0);
+    m_structureChanged = false;
+    m_localsTouched = false;
+}
+
+// Recomputes the out of date world transforms of a range of nodes.
+// The parents of the range must be up to date.
+// @param begin, end: Index range
+// @return The number of world transforms recomputed
+size_t SceneGraph::UpdateRange(size_t begin, size_t end) {
+    size_t recomputed = 0;
+    for (size_t i = begin; i < end; ++i) {
+        int parent = m_parents[i];
+        unsigned int flags = m_flags[i];
+        bool parentChanged = (parent != s_noParent) && (m_flags[parent] & NodeFlagWorldChanged);
+
+        if (!m_localTransforms[i].IsDirty() && !parentChanged && !(flags & (NodeFlagReparented | NodeFlagBoundsChanged))) {
+            m_flags[i] = flags & ~NodeFlagWorldChanged;
+            continue;
+        }
+
+        // Written directly, world transforms are not tracked as dirty
+        if (parent == s_noParent) {
+            m_worldTransforms[i].m_modelTransformMatrix = m_localTransforms[i].GetMatrix();
+        } else {
+            m_worldTransforms[i].m_modelTransformMatrix = m_worldTransforms[parent].GetMatrix() * m_localTransforms[i].GetMatrix();
+        }
+        if (flags & NodeFlagHasBounds) {
+            m_worldBounds[i] = m_localBounds[i].Transformed(m_worldTransforms[i].GetMatrix());
+        } else {
+            m_worldBounds[i] = AABB();
+        }
+        m_localTransforms[i].ClearDirty();
+        m_flags[i] = (flags & ~(NodeFlagReparented | NodeFlagBoundsChanged)) | NodeFlagWorldChanged;
+        ++recomputed;
+    }
+    return recomputed;
+}
+
+// Rebuilds every node's subtree bounds. Walking the topological order
+// backwards visits all children before their parent.
+void SceneGraph::UpdateSubtreeBounds() {
+    const int count = (int)m_nodes.size();
+    for (int i = 0; i < count; ++i) {
+        m_subtreeBounds[i] = m_worldBounds[i];
+        m_flags[i] = (m_flags[i] & NodeFlagNeverCull) ? (m_flags[i] | NodeFlagSubtreeNeverCull)
+                                                      : (m_flags[i] & ~NodeFlagSubtreeNeverCull);
+    }
+    for (int i = count - 1; i > 0; --i) {
+        int parent = m_parents[i];
+        if (parent == s_noParent) {
+            continue;
+        }
+        m_subtreeBounds[parent].Merge(m_subtreeBounds[i]);
+        m_flags[parent] |= (m_flags[i] & NodeFlagSubtreeNeverCull);
+    }
+}
+
+// Marks a node as occluder
+// @param index: Index of the node
+// @param occluder: True to rasterize the node's mesh into the occlusion buffer
+void SceneGraph::SetOccluder(int index, bool occluder) {
+    if (occluder == ((m_flags[index] & NodeFlagOccluder) != 0)) {
+        return;
+    }
+    if (occluder) {
+        m_flags[index] |= NodeFlagOccluder;
+        ++m_occluderCount;
+    } else {
+        m_flags[index] &= ~NodeFlagOccluder;
+        --m_occluderCount;
+    }
+}
+
+// Adds the visible occluders' meshes to an occlusion buffer
+// @param buffer: The buffer, Begin was called for this frame
+// @return The number of occluders added
+size_t SceneGraph::GatherOccluders(OcclusionBuffer& buffer) {
+    size_t occluders = 0;
+    const size_t count = m_nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned int flags = m_flags[i];
+        if (!(flags & NodeFlagOccluder) || !(flags & NodeFlagVisible)) {
+            continue;
+        }
+        Object* object = m_nodes[i]->GetObject();
+        if (object == nullptr) {
+            continue;
+        }
+        const Geometry& geometry = object->getGeometry();
+        buffer.AddOccluder(geometry.GetPositions(), geometry.GetIndices(), m_worldTransforms[i].GetMatrix());
+        ++occluders;
+    }
+    return occluders;
+}
+
+// Tests the visible nodes against the occluders. Occluders themselves and
+// nodes that are never culled are not tested.
+// @param buffer: The rasterized occlusion buffer
+// @param stats: The result of Cull, updated with the occlusion results
+void SceneGraph::CullOccluded(const OcclusionBuffer& buffer, CullStats& stats) {
+    PROFILE_SCOPE("CullOccluded");
+    const size_t count = m_nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned int flags = m_flags[i];
+        if (!(flags & NodeFlagVisible) || !(flags & NodeFlagHasBounds) ||
+            (flags & (NodeFlagOccluder | NodeFlagNeverCull))) {
+            continue;
+        }
+        ++stats.occlusionTested;
+        if (buffer.IsOccluded(m_worldBounds[i])) {
+            m_flags[i] = flags & ~NodeFlagVisible;
+            ++stats.occluded;
+            --stats.visible;
+            ++stats.culled;
+        }
+    }
+}
+
+// Creates the octree and fills it with the current nodes
+// @param center, halfSize: The cube covered by the octree's root cell
+// @param maxDepth: Depth of the smallest cells
+void SceneGraph::EnableSpatialIndex(const glm::vec3& center, float halfSize, int maxDepth) {
+    delete m_spatialIndex;
+    m_spatialIndex = new LooseOctree(center, halfSize, maxDepth);
+    for (size_t i = 0; i < m_spatialHandles.size(); ++i) {
+        m_spatialHandles[i] = LooseOctree::s_invalidHandle;
+    }
+    // Filled by the next pass
+    m_structureChanged = true;
+}
+
+// Inserts, moves or removes the octree items of the nodes
+// @param all: Visit every node (after structural changes), otherwise only
+//             the ones whose world transform was recomputed
+void SceneGraph::UpdateSpatialIndex(bool all) {
+    const size_t count = m_nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        unsigned int flags = m_flags[i];
+        if (!all && !(flags & NodeFlagWorldChanged)) {
+            continue;
+        }
+        bool indexed = (flags & NodeFlagHasBounds) && !(flags & NodeFlagNeverCull);
+        int& handle = m_spatialHandles[i];
+        if (indexed && handle == LooseOctree::s_invalidHandle) {
+            handle = m_spatialIndex->Insert(m_worldBounds[i], (int)i);
+        } else if (indexed) {
+            m_spatialIndex->Update(handle, m_worldBounds[i]);
+        } else if (handle != LooseOctree::s_invalidHandle) {
+            m_spatialIndex->Remove(handle);
+            handle = LooseOctree::s_invalidHandle;
+        }
+    }
+}
+
+// Returns the node whose world bounds a ray hits first
+// @param origin, direction: The ray, e.g. from the camera through the mouse
+SceneNode* SceneGraph::Pick(const glm::vec3& origin, const glm::vec3& direction) const {
+    int index;
+    float distance;
+    if (m_spatialIndex == nullptr || !m_spatialIndex->QueryRay(origin, direction, index, distance)) {
+        return nullptr;
+    }
+    return m_nodes[index];
+}
+
+// Marks the ancestors of a node, stopping at the first one already marked
+void SceneGraph::MarkAncestorsVisible(int index) {
+    for (int parent = m_parents[index]; parent != s_noParent; parent = m_parents[parent]) {
+        if (m_flags[parent] & NodeFlagSubtreeVisible) {
+            break;
+        }
+        m_flags[parent] |= NodeFlagSubtreeVisible;
+    }
+}
+
+// Culling through the octree: only the cells around the frustum are
+// visited, then the drawn nodes' ancestors are marked so Draw reaches them
+CullStats SceneGraph::CullSpatialIndex(const Frustum& frustum) {
+    CullStats stats;
+    const size_t count = m_nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        m_flags[i] &= ~(NodeFlagVisible | NodeFlagSubtreeVisible);
+    }
+
+    m_queryResults.clear();
+    m_spatialIndex->QueryFrustum(frustum, m_queryResults);
+    for (size_t i = 0; i < m_queryResults.size(); ++i) {
+        int index = m_queryResults[i];
+        m_flags[index] |= NodeFlagVisible | NodeFlagSubtreeVisible;
+        MarkAncestorsVisible(index);
+    }
+    stats.visible = m_queryResults.size();
+    stats.culled = m_spatialIndex->GetSize() - m_queryResults.size();
+
+    // Nodes the octree does not hold are always drawn
+    for (size_t i = 0; i < count; ++i) {
+        if ((m_flags[i] & NodeFlagAlive) && (m_flags[i] & NodeFlagNeverCull)) {
+            m_flags[i] |= NodeFlagVisible | NodeFlagSubtreeVisible;
+            MarkAncestorsVisible((int)i);
+            ++stats.visible;
+        }
+    }
+    return stats;
+}
+
+// Marks the nodes inside the frustum visible, parents first
+// @param frustum: The camera's view volume
+// @return How many nodes were drawn, culled and rejected with their subtree
+CullStats SceneGraph::Cull(const Frustum& frustum) {
+    PROFILE_SCOPE("Cull");
+    if (m_spatialIndex != nullptr) {
+        return CullSpatialIndex(frustum);
+    }
+
+    CullStats stats;
+    const size_t count = m_nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        unsigned int flags = m_flags[i] & ~(NodeFlagVisible | NodeFlagSubtreeVisible);
+        if (!(flags & NodeFlagAlive)) {
+            continue;
+        }
+        int parent = m_parents[i];
+
+        // Below a rejected subtree, or a rejected subtree itself
+        bool subtreeVisible = (parent == s_noParent) || (m_flags[parent] & NodeFlagSubtreeVisible);
+        if (subtreeVisible && !(flags & NodeFlagSubtreeNeverCull)) {
+            subtreeVisible = frustum.Intersects(m_subtreeBounds[i]);
+            if (!subtreeVisible && !m_subtreeBounds[i].IsEmpty()) {
+                ++stats.subtreesRejected;
+            }
+        }
+        if (!subtreeVisible) {
+            if (flags & NodeFlagHasBounds) {
+                ++stats.culled;
+            }
+            m_flags[i] = flags;
+            continue;
+        }
+        flags |= NodeFlagSubtreeVisible;
+
+        // The node's own geometry, when its subtree is more than itself
+        bool visible = (flags & NodeFlagNeverCull) ||
+                       ((flags & NodeFlagHasBounds) && frustum.Intersects(m_worldBounds[i]));
+        if (visible) {
+            flags |= NodeFlagVisible;
+            ++stats.visible;
+        } else if (flags & NodeFlagHasBounds) {
+            ++stats.culled;
+        }
+        m_flags[i] = flags;
+    }
+    return stats;
+}
+
+// Reorders the arrays breadth first from the roots, so every parent comes
+// before its children, and drops freed slots
+void SceneGraph::Sort() {
+    const int count = (int)m_nodes.size();
+
+    // Children of every node as ranges of one array (counting sort by parent)
+    std::vector<int> childStart(count + 1, 0);
+    std::vector<int> children;
+    std::vector<int> roots;
+    for (int i = 0; i < count; ++i) {
+        if (!(m_flags[i] & NodeFlagAlive)) {
+            continue;
+        }
+        if (m_parents[i] == s_noParent) {
+            roots.push_back(i);
+        } else {
+            ++childStart[m_parents[i] + 1];
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        childStart[i + 1] += childStart[i];
+    }
+    children.resize(childStart[count]);
+    std::vector<int> fill(childStart.begin(), childStart.end() - 1);
+    for (int i = 0; i < count; ++i) {
+        if ((m_flags[i] & NodeFlagAlive) && m_parents[i] != s_noParent) {
+            children[fill[m_parents[i]]++] = i;
+        }
+    }
+
+    // Breadth first order: the queue itself is the new order, and every
+    // depth level is a contiguous range of it
+    std::vector<int> order(roots);
+    order.reserve(count);
+    m_levelOffsets.clear();
+    m_levelOffsets.push_back(0);
+    size_t levelEnd = order.size();
+    for (size_t head = 0; head < order.size(); ++head) {
+        if (head == levelEnd) {
+            m_levelOffsets.push_back(head);
+            levelEnd = order.size();
+        }
+        int node = order[head];
+        for (int c = childStart[node]; c < childStart[node + 1]; ++c) {
+            order.push_back(children[c]);
+        }
+    }
+    m_levelOffsets.push_back(order.size());
+
+    std::vector<int> newIndex(count, s_noParent);
+    for (int i = 0; i < (int)order.size(); ++i) {
+        newIndex[order[i]] = i;
+    }
+
+    // Permute the arrays
+    const size_t newCount = order.size();
+    std::vector<Transform> localTransforms(newCount);
+    std::vector<Transform> worldTransforms(newCount);
+    std::vector<int> parents(newCount);
+    std::vector<unsigned int> flags(newCount);
+    std::vector<AABB> localBounds(newCount);
+    std::vector<AABB> worldBounds(newCount);
+    std::vector<AABB> subtreeBounds(newCount);
+    std::vector<int> spatialHandles(newCount);
+    std::vector<SceneNode*> nodes(newCount);
+    for (size_t i = 0; i < newCount; ++i) {
+        int old = order[i];
+        localTransforms[i] = m_localTransforms[old];
+        worldTransforms[i] = m_worldTransforms[old];
+        parents[i] = (m_parents[old] == s_noParent) ? s_noParent : newIndex[m_parents[old]];
+        assert(parents[i] < (int)i);
+        flags[i] = m_flags[old];
+        localBounds[i] = m_localBounds[old];
+        worldBounds[i] = m_worldBounds[old];
+        subtreeBounds[i] = m_subtreeBounds[old];
+        spatialHandles[i] = m_spatialHandles[old];
+        if (spatialHandles[i] != LooseOctree::s_invalidHandle) {
+            m_spatialIndex->SetUserData(spatialHandles[i], (int)i);
+        }
+        nodes[i] = m_nodes[old];
+        nodes[i]->SetSceneIndex((int)i);
+    }
+    m_localTransforms.swap(localTransforms);
+    m_worldTransforms.swap(worldTransforms);
+    m_parents.swap(parents);
+    m_flags.swap(flags);
+    m_localBounds.swap(localBounds);
+    m_worldBounds.swap(worldBounds);
+    m_subtreeBounds.swap(subtreeBounds);
+    m_spatialHandles.swap(spatialHandles);
+    m_nodes.swap(nodes);
+    m_needsSort = false;
+    m_levelsValid = true;
+}
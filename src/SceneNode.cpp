@@ -1,32 +1,48 @@
 #include "SceneNode.hpp"
 #include "Renderer.hpp"
+#include "GLExtensions.hpp"
 
 #include <string>
 #include <iostream>
 
 // Constructor: Initializes a SceneNode with an object and shader programs
 // @param ob: Pointer to the object this node manages
-// @param vertShader: Path to the vertex shader file
-// @param fragShader: Path to the fragment shader file
-SceneNode::SceneNode(Object* ob, std::string vertShader, std::string fragShader) {
-    std::cout << "(SceneNode.cpp) Constructor called\n";
+// @param vertShader: Path to the vertex shader file, empty for a group node
+// @param fragShader: Path to the fragment shader file, empty for a group node
+// @param scene: Storage for the node's transforms, nullptr for the default SceneGraph
+SceneNode::SceneNode(Object* ob, std::string vertShader, std::string fragShader, SceneGraph* scene) {
     m_object = ob;           // Assign the object to this node
     m_parent = nullptr;      // By default, the node has no parent
 
-    // Load and compile shaders for this node
-    std::string vertexShader = m_shader.LoadShader(vertShader);
-    std::string fragmentShader = m_shader.LoadShader(fragShader);
+    // Reserve the node's slot in the scene storage
+    m_scene = (scene != nullptr) ? scene : &SceneGraph::GetDefault();
+    m_sceneIndex = m_scene->Add(this);
+    RefreshBounds();
+
+    // Group nodes only carry a transform and have no program
+    if (vertShader.empty() && fragShader.empty()) {
+        return;
+    }
+
+    std::cout << "(SceneNode.cpp) Constructor called\n";
 
-    // Create the shader program
-    m_shader.CreateShader(vertexShader, fragmentShader);
+    // Load and compile shaders for this node, nodes using the same files
+    // share the program
+    m_shader.CreateShaderFromFiles(vertShader, fragShader);
+    m_fragShaderPath = fragShader;
 }
 
 // Destructor: Cleans up the SceneNode and its children
 SceneNode::~SceneNode() {
     // Recursively delete all child nodes
-    for (int i = 0; i < m_children.size(); i++) {
-        delete m_children[i];
+    SceneNode* child = m_firstChild;
+    while (child != nullptr) {
+        SceneNode* next = child->m_nextSibling;
+        delete child;
+        child = next;
     }
+    // Free the slot in the scene storage
+    m_scene->Remove(m_sceneIndex);
 }
 
 // Adds a child node to the current SceneNode
@@ -34,55 +50,104 @@ SceneNode::~SceneNode() {
 void SceneNode::AddChild(SceneNode* n) {
     // Set the parent of the child node to the current node
     n->m_parent = this;
+    m_scene->SetParent(n->m_sceneIndex, m_sceneIndex);
 
-    // Add the child node to the list of children
-    m_children.push_back(n);
+    // Append the child node to the list of children
+    n->m_nextSibling = nullptr;
+    if (m_lastChild != nullptr) {
+        m_lastChild->m_nextSibling = n;
+    } else {
+        m_firstChild = n;
+    }
+    m_lastChild = n;
 }
 
-// Draws the current node's object and recursively draws all child nodes
-void SceneNode::Draw() {
-    // Bind the shader for this node or series of nodes
-    m_shader.Bind();
-
-    // Render the object associated with this node
+// Hands the object's bounds to the SceneGraph for culling
+void SceneNode::RefreshBounds() {
+    AABB bounds;
     if (m_object != nullptr) {
-        m_object->Render();
+        bounds = m_object->GetBounds();
+    }
+    m_scene->SetLocalBounds(m_sceneIndex, bounds);
+    // An object without geometry yet has unknown size, never cull it
+    bool unknownBounds = (m_object != nullptr) && bounds.IsEmpty();
+    m_scene->SetCullable(m_sceneIndex, m_cullable && !unknownBounds);
+}
 
-        // Recursively draw all child nodes
-        for (int i = 0; i < m_children.size(); ++i) {
-            m_children[i]->Draw();
-        }
+// Allows or forbids culling this node
+// @param cullable: False to always draw the node
+void SceneNode::SetCullable(bool cullable) {
+    m_cullable = cullable;
+    RefreshBounds();
+}
+
+// Makes this node's mesh hide the nodes behind it, or stops doing so
+// @param occluder: True to rasterize this node into the occlusion buffer
+void SceneNode::SetOccluder(bool occluder) {
+    m_scene->SetOccluder(m_sceneIndex, occluder);
+}
+
+// Lets the RenderQueue draw this node together with the other nodes of the
+// same object in one instanced draw
+// @param instancedVertShader: Vertex shader reading the model matrix from
+//                             attributes 4 to 7 (e.g. shaders/vert_instanced.glsl)
+void SceneNode::EnableInstancing(const std::string& instancedVertShader) {
+    if (m_object == nullptr || m_fragShaderPath.empty()) {
+        return;
+    }
+    m_instancedShader.CreateShaderFromFiles(instancedVertShader, m_fragShaderPath);
+}
+
+// Lets the RenderQueue draw this node with the other meshes of its
+// object's MeshPool in one indirect draw. Needs OpenGL 4.3.
+// @param indirectVertShader: Vertex shader reading the model matrix from
+//                            storage buffer 0 (e.g. shaders/vert_indirect.glsl)
+void SceneNode::EnableIndirect(const std::string& indirectVertShader) {
+    if (m_object == nullptr || m_fragShaderPath.empty() || !GLExtensions::HasMultiDrawIndirect()) {
+        return;
     }
+    m_indirectShader.CreateShaderFromFiles(indirectVertShader, m_fragShaderPath);
 }
 
-// Updates the current node's transform and recursively updates all child nodes
-// @param projectionMatrix: The projection matrix for rendering
-// @param camera: Pointer to the camera used for rendering
-// @param renderer: Pointer to the renderer managing the scene
-void SceneNode::Update(glm::mat4 projectionMatrix, Camera* camera, Renderer* renderer) {
-    // Compute the world transform based on the parent's world transform
-    if (m_parent != nullptr) {
-        m_worldTransform = m_parent->GetWorldTransform() * m_localTransform;
+// Records the current node's object. Culling and the walk over the
+// children were done by Renderer::Update when it built the snapshot.
+// @param list: The list of the worker recording this node
+// @param world: The node's world matrix, owned by the snapshot
+void SceneNode::Submit(CommandList& list, const glm::mat4& world, const FrameSnapshot& /*snapshot*/) {
+    if (m_object == nullptr) {
+        return;
+    }
+    if (list.IsIndirectEnabled() && m_indirectShader.GetID() != 0 && m_object->GetMeshPool() != nullptr) {
+        list.PushIndirect(RenderPassOpaque, m_indirectShader.GetID(), m_object->GetDiffuseTexture(),
+                          *m_object->GetMeshPool(), m_object->GetMeshRange(), world);
     } else {
-        m_worldTransform = m_localTransform;
+        list.Push(RenderPassOpaque, m_shader.GetID(), m_instancedShader.GetID(), m_object->GetDiffuseTexture(),
+                  m_object->GetVertexArray(), m_object->GetIndexCount(), world);
     }
+}
 
-    // Recursively update all child nodes
+// Draws the current node's object with its shader
+void SceneNode::DrawCustom() {
     if (m_object != nullptr) {
-        for (int i = 0; i < m_children.size(); ++i) {
-            m_children[i]->Update(projectionMatrix, camera, renderer);
-        }
+        m_shader.Bind();
+        m_object->Render();
     }
 }
 
+// Per-frame hook of the root node, nothing to do for a plain node. World
+// transforms were already computed by SceneGraph::UpdateWorldTransforms,
+// and culling and GatherVisible walk the children.
+void SceneNode::Update(const glm::mat4& /*projectionMatrix*/, Camera* /*camera*/, Renderer* /*renderer*/, FrameSnapshot& /*snapshot*/) {
+}
+
 // Returns a reference to the local transform of this node
 // Allows for modification of the node's local transform
 Transform& SceneNode::GetLocalTransform() {
-    return m_localTransform;
+    return m_scene->GetLocalTransform(m_sceneIndex);
 }
 
 // Returns a reference to the world transform of this node
 // Allows for modification of the node's world transform
 Transform& SceneNode::GetWorldTransform() {
-    return m_worldTransform;
+    return m_scene->GetWorldTransform(m_sceneIndex);
 }
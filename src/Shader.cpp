@@ -1,24 +1,41 @@
 #include "Shader.hpp"
+#include "Profiler.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
 #include <iostream>
 #include <fstream>
 
 
+std::map<std::string, Shader::SharedProgram> Shader::s_programs;
+
 // Constructor: Initializes the Shader object
 Shader::Shader() {}
 
 // Destructor: Cleans up shader resources by deleting the program
 Shader::~Shader() {
-    glDeleteProgram(m_shaderID);
+    // Shared programs are deleted with their last user
+    if (!m_programKey.empty()) {
+        auto it = s_programs.find(m_programKey);
+        if (it != s_programs.end() && --it->second.users == 0) {
+            GLState::DeleteProgram(it->second.id);
+            s_programs.erase(it);
+        }
+        return;
+    }
+    // Nodes without a program never touched OpenGL
+    if (m_shaderID != 0) {
+        GLState::DeleteProgram(m_shaderID);
+    }
 }
 
 // Activates the shader for use in rendering
 void Shader::Bind() const {
-    glUseProgram(m_shaderID);
+    GLState::UseProgram(m_shaderID);
 }
 
 // Deactivates the currently bound shader
 void Shader::Unbind() const {
-    glUseProgram(0);
+    GLState::UseProgram(0);
 }
 
 // Logs messages with a system tag for easier debugging
@@ -51,6 +68,7 @@ std::string Shader::LoadShader(const std::string& fname) {
 // @param vertexShaderSource: The source code for the vertex shader
 // @param fragmentShaderSource: The source code for the fragment shader
 void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource) {
+    PROFILE_SCOPE("CreateShader");
     unsigned int program = glCreateProgram();
 
     // Compile the vertex and fragment shaders
@@ -76,8 +94,49 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
     m_shaderID = program;
 }
 
+// Creates the program of a vertex and fragment shader file pair, or reuses
+// the one an earlier Shader compiled from the same files
+// @param vertexPath: Path to the vertex shader file
+// @param fragmentPath: Path to the fragment shader file
+void Shader::CreateShaderFromFiles(const std::string& vertexPath, const std::string& fragmentPath) {
+    std::string key = vertexPath + "|" + fragmentPath;
+    auto it = s_programs.find(key);
+    if (it != s_programs.end()) {
+        ++it->second.users;
+        m_shaderID = it->second.id;
+        m_programKey = key;
+        return;
+    }
+
+    CreateShader(LoadShader(vertexPath), LoadShader(fragmentPath));
+    s_programs[key] = SharedProgram{ m_shaderID, 1 };
+    m_programKey = key;
+}
+
+// Creates and links a compute shader program
+// @param computeShaderSource: The source code for the compute shader
+void Shader::CreateComputeShader(const std::string& computeShaderSource) {
+    PROFILE_SCOPE("CreateComputeShader");
+    unsigned int program = glCreateProgram();
+
+    unsigned int myComputeShader = CompileShader(GL_COMPUTE_SHADER, computeShaderSource);
+
+    glAttachShader(program, myComputeShader);
+    glLinkProgram(program);
+    glValidateProgram(program);
+
+    glDetachShader(program, myComputeShader);
+    glDeleteShader(myComputeShader);
+
+    if (!CheckLinkStatus(program)) {
+        Log("CreateComputeShader", "ERROR: Shader did not link! Check for compile errors.");
+    }
+
+    m_shaderID = program;
+}
+
 // Compiles a shader from its source code
-// @param type: The type of shader (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)
+// @param type: The type of shader (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_COMPUTE_SHADER)
 // @param source: The source code of the shader
 // @return The compiled shader ID
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source) {
@@ -85,6 +144,7 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
     const char* src = source.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
+    FlightRecorder::Count(FlightCounter::ShaderCompiles);
 
     // Check for compilation errors
     int result;
@@ -99,6 +159,8 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
             Log("CompileShader ERROR", "GL_VERTEX_SHADER compilation failed!");
         } else if (type == GL_FRAGMENT_SHADER) {
             Log("CompileShader ERROR", "GL_FRAGMENT_SHADER compilation failed!");
+        } else if (type == GL_COMPUTE_SHADER) {
+            Log("CompileShader ERROR", "GL_COMPUTE_SHADER compilation failed!");
         }
         Log("CompileShader ERROR", errorMessages);
 
@@ -153,6 +215,15 @@ void Shader::SetUniform4f(const GLchar* name, float v0, float v1, float v2, floa
     glUniform4f(location, v0, v1, v2, v3);
 }
 
+// Sets a vec4 array uniform in the shader
+// @param name: Name of the uniform variable
+// @param count: Number of vec4 in the array
+// @param value: Pointer to count * 4 floats
+void Shader::SetUniform4fv(const GLchar* name, GLsizei count, const GLfloat* value) {
+    GLint location = glGetUniformLocation(m_shaderID, name);
+    glUniform4fv(location, count, value);
+}
+
 // Sets a vec3 uniform in the shader
 // @param name: Name of the uniform variable
 // @param v0, v1, v2: Values of the vec3
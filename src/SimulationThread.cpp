@@ -0,0 +1,67 @@
+#include "SimulationThread.hpp"
+#include "Renderer.hpp"
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+
+// Constructor
+// @param renderer: The renderer whose Update runs on the thread
+SimulationThread::SimulationThread(Renderer* renderer) : m_renderer(renderer) {}
+
+// Destructor: lets a kicked update finish, then stops the thread
+SimulationThread::~SimulationThread() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_kicked.notify_one();
+    m_thread.join();
+}
+
+// Starts the thread
+void SimulationThread::Start() {
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&SimulationThread::ThreadLoop, this);
+    }
+}
+
+// Starts the next update
+void SimulationThread::Kick() {
+    if (!m_thread.joinable()) {
+        m_renderer->Update();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = true;
+    }
+    m_kicked.notify_one();
+}
+
+// Waits for the kicked update to finish
+void SimulationThread::Wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return !m_pending; });
+}
+
+// Runs an update per Kick until the destructor stops it
+void SimulationThread::ThreadLoop() {
+    PROFILE_THREAD_NAME("Simulation");
+    // The update's jobs go to a queue of this thread, not the GL thread's
+    JobSystem::Get().RegisterThread();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_kicked.wait(lock, [this]() { return m_pending || m_stopping; });
+        if (m_pending) {
+            lock.unlock();
+            m_renderer->Update();
+            lock.lock();
+            m_pending = false;
+            m_done.notify_all();
+        } else {
+            return;
+        }
+    }
+}
@@ -1,5 +1,10 @@
 #include "SkyboxNode.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
 
+// Texture slot the compute path's sky image is bound to.
+// Slot 0 is taken by the object's diffuse texture in Object::Render.
+static const unsigned int s_auroraImageSlot = 1;
 
 // Constructor: Initializes the SkyboxNode with a skybox object and shaders
 // @param skyboxObject: Pointer to the object representing the skybox
@@ -10,65 +15,134 @@ SkyboxNode::SkyboxNode(Object* skyboxObject)
 // @param skyboxObject: Pointer to the object representing the skybox
 void SkyboxNode::Init(Object* skyboxObject) {
     skyboxObject->LoadOBJ("common/objects/skybox_1.obj"); // Load the skybox object
+    // The skybox surrounds the camera, it is never culled
+    SetCullable(false);
     std::cout << "SkyboxNode Initialized" << std::endl;
 }
 
-// Updates the SkyboxNode, applying transformations and updating shader uniforms
-// @param projectionMatrix: The projection matrix for rendering
-// @param camera: Pointer to the camera used for view calculations
-// @param renderer: Pointer to the renderer managing the scene
-void SkyboxNode::Update(glm::mat4 projectionMatrix, Camera* camera, Renderer* renderer) {
-    if (m_parent != nullptr) {
-        // Combine parent's world transform with local transform
-        m_worldTransform = m_parent->GetWorldTransform() * GetLocalTransform();
-    } else {
-        // No parent, so world transform is the local transform
-        m_worldTransform = m_localTransform;
+// Selects the aurora pipeline, compiling the compute path's shaders on first use
+// @param path: The pipeline to use
+void SkyboxNode::SetAuroraPath(AuroraPath path) {
+    if (path == AuroraPath::Compute && !GLExtensions::HasComputeShaders()) {
+        std::cout << "SkyboxNode: compute shaders unavailable, using the fragment aurora" << std::endl;
+        path = AuroraPath::Fragment;
     }
 
-    if (m_object != nullptr) {
-        m_shader.Bind(); // Bind the shader for the skybox
+    if (path == AuroraPath::Compute && !m_auroraCompute.IsInitialized()) {
+        m_auroraCompute.Init("shaders/aurora_comp.glsl");
 
-        // Model matrix (identity matrix as skybox does not scale/rotate)
-        glm::mat4 modelMatrix = glm::mat4(1.0f);
+        std::string vertexShader = m_compositeShader.LoadShader("shaders/skybox_vert.glsl");
+        std::string fragmentShader = m_compositeShader.LoadShader("shaders/skybox_composite_frag.glsl");
+        m_compositeShader.CreateShader(vertexShader, fragmentShader);
+        m_compositeShader.Bind();
+        m_compositeShader.SetUniform1i("u_AuroraImage", s_auroraImageSlot);
+    }
 
-        // View matrix: Remove translation to ensure the skybox stays in view
-        glm::mat4 viewMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -100.0f, -10.0f));
+    m_auroraPath = path;
+}
 
-        // Pass transformation matrices to the shader
-        m_shader.SetUniformMatrix4fv("u_ModelMatrix", &modelMatrix[0][0]);
-        m_shader.SetUniformMatrix4fv("u_ViewMatrix", &viewMatrix[0][0]);
-        m_shader.SetUniformMatrix4fv("u_Projection", &projectionMatrix[0][0]);
+// Captures the sky's inputs of this frame into the snapshot. Runs on the
+// simulation thread when pipelined, the uniforms are set by DrawCustom.
+// @param renderer: Pointer to the renderer managing the scene
+// @param snapshot: The frame being simulated
+void SkyboxNode::Update(const glm::mat4& /*projectionMatrix*/, Camera* /*camera*/, Renderer* renderer, FrameSnapshot& snapshot) {
+    if (m_object != nullptr) {
+        SkyFrame& sky = snapshot.sky;
 
-        // Pass additional uniforms to the shader
-        Uint32 currentTime = SDL_GetTicks();
-        float iTime = (currentTime - renderer->GetStartTime()) / 1000.0f; // Elapsed time in seconds
-        m_shader.SetUniform1f("iTime", iTime);
+        // Animation time in seconds, see Renderer::SetTime
+        sky.iTime = (float)renderer->GetTime();
 
         unsigned int screenWidth = renderer->GetScreenWidth();
         unsigned int screenHeight = renderer->GetScreenHeight();
-        m_shader.SetUniform3f("iResolution", (float)screenWidth, (float)screenHeight, 1.0f);
+        sky.resolutionX = (float)screenWidth;
+        sky.resolutionY = (float)screenHeight;
 
         int mouseX = renderer->GetMouseX();
         int mouseY = renderer->GetMouseY();
-        m_shader.SetUniform4f("iMouse", (float)mouseX, (float)(screenHeight - mouseY), 0.0f, 0.0f);
+        sky.mouseX = (float)mouseX;
+        sky.mouseY = (float)(screenHeight - mouseY);
 
-        // Recursively update all child nodes
-        for (int i = 0; i < m_children.size(); ++i) {
-            m_children[i]->Update(projectionMatrix, camera, renderer);
-        }
+        // Quality tier
+        sky.resolutionScale = renderer->GetSkyResolutionScale();
+        sky.auroraSteps = renderer->GetAuroraSteps();
     }
 }
 
-// Draws the SkyboxNode and its children
-void SkyboxNode::Draw() {
+// Keeps the sky inputs of the frame being drawn, and records the sky as a
+// custom packet of the background pass. DrawCustom runs on the GL thread
+// after the recording finished.
+// @param list: The list of the worker recording this node
+// @param snapshot: The frame being drawn
+void SkyboxNode::Submit(CommandList& list, const glm::mat4& /*world*/, const FrameSnapshot& snapshot) {
     if (m_object != nullptr) {
-        m_shader.Bind();      // Bind the shader for rendering
-        m_object->Render();   // Render the skybox object
+        m_sky = snapshot.sky;
+        m_projectionMatrix = snapshot.projection;
+        list.PushCustom(RenderPassBackground, this);
+    }
+}
+
+// Binds a sky shader and sets the uniforms of the frame being drawn
+// @param shader: m_shader, or the compute path's composite shader
+void SkyboxNode::BindSkyShader(Shader& shader) {
+    shader.Bind();
+
+    // Model matrix (identity matrix as skybox does not scale/rotate)
+    glm::mat4 modelMatrix = glm::mat4(1.0f);
+
+    // View matrix: Remove translation to ensure the skybox stays in view
+    glm::mat4 viewMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -100.0f, -10.0f));
 
-        // Recursively draw all child nodes
-        for (int i = 0; i < m_children.size(); ++i) {
-            m_children[i]->Draw();
+    // Pass transformation matrices to the shader
+    shader.SetUniformMatrix4fv("u_ModelMatrix", &modelMatrix[0][0]);
+    shader.SetUniformMatrix4fv("u_ViewMatrix", &viewMatrix[0][0]);
+    shader.SetUniformMatrix4fv("u_Projection", &m_projectionMatrix[0][0]);
+
+    if (&shader == &m_shader) {
+        shader.SetUniform1f("iTime", m_sky.iTime);
+        shader.SetUniform3f("iResolution", m_sky.resolutionX, m_sky.resolutionY, 1.0f);
+        shader.SetUniform4f("iMouse", m_sky.mouseX, m_sky.mouseY, 0.0f, 0.0f);
+        shader.SetUniform1i("u_AuroraSteps", m_sky.auroraSteps);
+    }
+}
+
+// Draws the sky with the selected aurora pipeline
+void SkyboxNode::DrawCustom() {
+    if (m_object != nullptr) {
+        if (m_auroraPath == AuroraPath::Compute) {
+            // One sky texel per pixel at full quality, fewer below it
+            m_auroraCompute.Resize((int)(m_sky.resolutionX * m_sky.resolutionScale),
+                                   (int)(m_sky.resolutionY * m_sky.resolutionScale));
+            m_auroraCompute.Dispatch(m_sky.iTime, m_sky.resolutionX, m_sky.resolutionY,
+                                     m_sky.mouseX, m_sky.mouseY, m_sky.auroraSteps);
+
+            BindSkyShader(m_compositeShader);
+            m_auroraCompute.BindImage(s_auroraImageSlot);
+            m_object->Render();   // Render the skybox object
+        } else if (m_sky.resolutionScale < 1.0f) {
+            DrawScaled();
+        } else {
+            BindSkyShader(m_shader); // Bind the shader for rendering
+            m_object->Render();   // Render the skybox object
         }
     }
 }
+
+// Draws the fragment path sky at a reduced resolution, then scales it up
+// into the framebuffer that was bound before
+void SkyboxNode::DrawScaled() {
+    GLuint previousFramebuffer = GLState::GetDrawFramebuffer();
+    GLint viewport[4];
+    GLState::GetViewport(viewport);
+
+    m_skyTarget.Create((int)(viewport[2] * m_sky.resolutionScale), (int)(viewport[3] * m_sky.resolutionScale));
+    m_skyTarget.Bind();
+    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+    BindSkyShader(m_shader);
+    m_object->Render();
+
+    // Only color is copied: the sky is the background, and anything drawn
+    // after it tests against the cleared depth buffer
+    m_skyTarget.BlitTo(previousFramebuffer, viewport[2], viewport[3]);
+    GLState::Viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,157 @@
+#include "StressScene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#if defined(LINUX)
+    #include <unistd.h>
+#endif
+
+// Constructor
+StressScene::StressScene() : m_root(nullptr), m_nodeCount(0), m_occluderCount(0), m_depth(0) {}
+
+// Loads a mesh of the mix the first time it is asked for
+// @param filepath: OBJ file
+// @return the shared object, nullptr if the file does not exist
+Object* StressScene::GetMesh(const std::string& filepath) {
+    for (const auto& mesh : m_meshes) {
+        if (mesh.first == filepath) {
+            return mesh.second;
+        }
+    }
+    Object* object = nullptr;
+    // LoadOBJ exits on a missing file, skip it instead
+    if (std::ifstream(filepath).good()) {
+        object = new Object();
+        object->LoadOBJ(filepath);
+        object->AddToMeshPool();
+    } else {
+        std::cout << "StressScene: mesh not found, skipped: " << filepath << std::endl;
+    }
+    m_meshes.push_back(std::make_pair(filepath, object));
+    return object;
+}
+
+// Generates the tree breadth first: the children of the oldest node that
+// has none yet are added next, until the node count or the depth is reached
+// @param settings: Shape of the scene
+// @return the root of the new scene, nullptr if no mesh could be loaded
+SceneNode* StressScene::Generate(const StressSceneSettings& settings) {
+    Clear();
+    std::vector<Object*> meshes;
+    for (const std::string& filepath : settings.meshes) {
+        Object* mesh = GetMesh(filepath);
+        if (mesh != nullptr) {
+            meshes.push_back(mesh);
+        }
+    }
+    if (meshes.empty() || settings.nodeCount == 0) {
+        return nullptr;
+    }
+
+    int branching = std::max(settings.branching, 1);
+    int depth = settings.depth;
+    if (depth <= 0) {
+        // Levels a full tree needs for the node count
+        depth = 1;
+        size_t levelNodes = 1;
+        size_t total = 1;
+        while (total < settings.nodeCount) {
+            levelNodes *= branching;
+            total += levelNodes;
+            ++depth;
+        }
+    }
+
+    std::mt19937 random(settings.seed);
+    // Its own sequence, so occluders do not change which nodes move
+    std::mt19937 occluderRandom(settings.seed + 1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    size_t meshIndex = 0;
+    auto createNode = [&]() {
+        SceneNode* node = new SceneNode(meshes[meshIndex++ % meshes.size()], "shaders/vert.glsl", "shaders/frag.glsl");
+        node->EnableInstancing("shaders/vert_instanced.glsl");
+        node->EnableIndirect("shaders/vert_indirect.glsl");
+        if (unit(random) < settings.dynamicRatio) {
+            m_dynamic.push_back(node);
+        }
+        if (unit(occluderRandom) < settings.occluderRatio) {
+            node->SetOccluder(true);
+            ++m_occluderCount;
+        }
+        return node;
+    };
+
+    // Each level holds the nodes of one depth, breadth first
+    m_root = createNode();
+    m_nodeCount = 1;
+    m_depth = 1;
+    std::vector<SceneNode*> level(1, m_root);
+    std::vector<SceneNode*> nextLevel;
+    const float twoPi = 6.2831853f;
+    for (int l = 1; l < depth && m_nodeCount < settings.nodeCount; ++l) {
+        // Children spread on a ring around their parent, closer at each level
+        float radius = settings.spacing * std::pow(2.0f, (float)(depth - 1 - l));
+        nextLevel.clear();
+        for (SceneNode* parent : level) {
+            for (int c = 0; c < branching && m_nodeCount < settings.nodeCount; ++c) {
+                float angle = twoPi * (c + 0.5f * l) / branching;
+                SceneNode* child = createNode();
+                child->GetLocalTransform().Translate(radius * std::cos(angle), (l % 2 == 0 ? 0.5f : -0.5f) * radius,
+                                                     radius * std::sin(angle));
+                parent->AddChild(child);
+                nextLevel.push_back(child);
+                ++m_nodeCount;
+            }
+        }
+        level.swap(nextLevel);
+        m_depth = l + 1;
+    }
+
+    // The rings of all levels add up to less than twice the first one, the
+    // root cell covers that with room for the meshes and the turning nodes
+    if (settings.spatialIndex) {
+        float halfSize = settings.spacing * std::pow(2.0f, (float)depth);
+        m_root->GetScene()->EnableSpatialIndex(glm::vec3(0.0f), halfSize, 8);
+    }
+
+    std::cout << "StressScene: " << m_nodeCount << " nodes, depth " << m_depth << ", branching " << branching
+              << ", " << m_dynamic.size() << " dynamic, " << m_occluderCount << " occluders, " << meshes.size() << " meshes"
+              << (settings.spatialIndex ? ", octree culling" : "") << std::endl;
+    return m_root;
+}
+
+// Turns the dynamic nodes about their vertical axis
+// @param stepSeconds: Length of the simulation step
+void StressScene::Update(double stepSeconds) {
+    float angle = (float)(0.5 * stepSeconds);
+    for (SceneNode* node : m_dynamic) {
+        node->GetLocalTransform().Rotate(angle, 0.0f, 1.0f, 0.0f);
+    }
+}
+
+// Deletes the generated nodes, the meshes are kept for the next scene
+void StressScene::Clear() {
+    delete m_root;
+    m_root = nullptr;
+    m_dynamic.clear();
+    m_nodeCount = 0;
+    m_occluderCount = 0;
+    m_depth = 0;
+}
+
+// Reads the resident set size of the process
+// @return bytes, 0 where it is unknown
+size_t StressScene::GetResidentBytes() {
+#if defined(LINUX)
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, residentPages = 0;
+    if (statm >> pages >> residentPages) {
+        return residentPages * (size_t)sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return 0;
+}
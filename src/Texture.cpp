@@ -5,6 +5,8 @@
 #endif
 
 #include "Texture.hpp"
+#include "Profiler.hpp"
+#include "GLState.hpp"
 #include <fstream>
 #include <iostream>
 #include <glad/glad.h>
@@ -17,7 +19,7 @@ Texture::Texture() {}
 
 // Destructor: Cleans up texture data from the GPU and memory
 Texture::~Texture() {
-    glDeleteTextures(1, &m_textureID); // Delete texture from GPU
+    GLState::DeleteTextures(1, &m_textureID); // Delete texture from GPU
     if (m_image != nullptr) {
         delete m_image; // Free image memory
     }
@@ -27,16 +29,15 @@ Texture::~Texture() {
 // Loads a texture from a file and sends it to the GPU
 // @param filepath: Path to the texture file
 void Texture::LoadTexture(const std::string filepath) {
+    PROFILE_SCOPE("LoadTexture");
     m_filepath = filepath; // Store the file path
     m_image = new Image(filepath); // Load image data
     m_image->LoadPPM(true); // Load the PPM file and optionally flip vertically
     std::cout << "Loading texture: " << filepath << std::endl;
 
-    glEnable(GL_TEXTURE_2D);
-
     // Generate a texture ID and bind it
     glGenTextures(1, &m_textureID);
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    GLState::BindTexture(GL_TEXTURE_2D, m_textureID);
 
     // Set texture parameters for filtering and wrapping
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -48,26 +49,26 @@ void Texture::LoadTexture(const std::string filepath) {
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
                  m_image->GetWidth(), m_image->GetHeight(),
                  0, GL_RGB, GL_UNSIGNED_BYTE, m_image->GetPixelDataPtr());
+    FlightRecorder::Count(FlightCounter::UploadBytes, (uint64_t)m_image->GetWidth() * m_image->GetHeight() * 3);
 
     // Generate mipmaps for the texture
     glGenerateMipmap(GL_TEXTURE_2D);
 
     // Unbind the texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 
 // Binds the texture to a specified slot (default slot is 0)
 // @param slot: Texture slot to bind to
 void Texture::Bind(unsigned int slot) const {
-    glEnable(GL_TEXTURE_2D);       // Enable 2D textures
-    glActiveTexture(GL_TEXTURE0 + slot); // Set the active texture slot
-    glBindTexture(GL_TEXTURE_2D, m_textureID); // Bind the texture
+    GLState::ActiveTexture(GL_TEXTURE0 + slot); // Set the active texture slot
+    GLState::BindTexture(GL_TEXTURE_2D, m_textureID); // Bind the texture
 }
 
 // Unbinds the texture from the current slot
 void Texture::Unbind() {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -112,7 +113,7 @@ bool Texture::LoadPPM(const std::string& filepath) {
 
     // Generate and bind the texture
     glGenTextures(1, &m_textureID);
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    GLState::BindTexture(GL_TEXTURE_2D, m_textureID);
 
     // Set texture parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -125,7 +126,7 @@ bool Texture::LoadPPM(const std::string& filepath) {
     glGenerateMipmap(GL_TEXTURE_2D);
 
     // Unbind the texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 
     return true;
 }
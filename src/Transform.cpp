@@ -1,6 +1,5 @@
 #include "Transform.hpp"
 
-
 // Constructor: Initializes the Transform object with an identity matrix
 Transform::Transform() {
     LoadIdentity();
@@ -13,12 +12,14 @@ Transform::~Transform() {}
 // Resets the transformation matrix to the identity matrix
 void Transform::LoadIdentity() {
     m_modelTransformMatrix = glm::mat4(1.0f); // Identity matrix
+    MarkDirty();
 }
 
 // Applies a translation transformation to the current matrix
 // @param x, y, z: Translation values along the X, Y, and Z axes
 void Transform::Translate(float x, float y, float z) {
     m_modelTransformMatrix = glm::translate(m_modelTransformMatrix, glm::vec3(x, y, z));
+    MarkDirty();
 }
 
 // Applies a rotation transformation to the current matrix
@@ -26,12 +27,14 @@ void Transform::Translate(float x, float y, float z) {
 // @param x, y, z: Axis of rotation
 void Transform::Rotate(float radians, float x, float y, float z) {
     m_modelTransformMatrix = glm::rotate(m_modelTransformMatrix, radians, glm::vec3(x, y, z));
+    MarkDirty();
 }
 
 // Applies a scaling transformation to the current matrix
 // @param x, y, z: Scaling factors along the X, Y, and Z axes
 void Transform::Scale(float x, float y, float z) {
     m_modelTransformMatrix = glm::scale(m_modelTransformMatrix, glm::vec3(x, y, z));
+    MarkDirty();
 }
 
 
@@ -51,6 +54,7 @@ glm::mat4 Transform::GetInternalMatrix() const {
 // @param t: The Transform to apply
 void Transform::ApplyTransform(Transform t) {
     m_modelTransformMatrix = t.GetInternalMatrix();
+    MarkDirty();
 }
 
 
@@ -59,6 +63,7 @@ void Transform::ApplyTransform(Transform t) {
 // @return A reference to the updated Transform
 Transform& Transform::operator*=(const Transform& t) {
     m_modelTransformMatrix = m_modelTransformMatrix * t.GetInternalMatrix();
+    MarkDirty();
     return *this;
 }
 
@@ -67,6 +72,7 @@ Transform& Transform::operator*=(const Transform& t) {
 // @return A reference to the updated Transform
 Transform& Transform::operator+=(const Transform& t) {
     m_modelTransformMatrix = m_modelTransformMatrix + t.GetInternalMatrix();
+    MarkDirty();
     return *this;
 }
 
@@ -75,6 +81,7 @@ Transform& Transform::operator+=(const Transform& t) {
 // @return A reference to the updated Transform
 Transform& Transform::operator=(const Transform& t) {
     m_modelTransformMatrix = t.GetInternalMatrix();
+    MarkDirty();
     return *this;
 }
 
@@ -1,4 +1,5 @@
 #include "VertexBufferLayout.hpp"
+#include "GLState.hpp"
 #include <iostream>
 
 
@@ -8,24 +9,23 @@ VertexBufferLayout::VertexBufferLayout() {}
 // Destructor: Cleans up GPU buffers associated with the layout
 VertexBufferLayout::~VertexBufferLayout() {
     // Delete the vertex and index buffers from the GPU
-    glDeleteBuffers(1, &m_vertexPositionBuffer);
-    glDeleteBuffers(1, &m_indexBufferObject);
+    GLState::DeleteBuffers(1, &m_vertexPositionBuffer);
+    GLState::DeleteBuffers(1, &m_indexBufferObject);
 }
 
 
-// Binds the vertex array and its associated buffers
+// Binds the vertex array. The vertex array records the attribute buffers
+// and the index buffer, so binding those again is redundant.
 void VertexBufferLayout::Bind() {
-    glBindVertexArray(m_VAOId);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    GLState::BindVertexArray(m_VAOId);
 }
 
 // Unbinds the vertex array and its associated buffers
 // Rarely used since binding another buffer automatically unbinds the current one
 void VertexBufferLayout::Unbind() {
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::BindVertexArray(0);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 // Creates a position buffer layout for vertex data (x, y, z)
@@ -41,11 +41,11 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount, unsigne
 
     // Generate and bind the vertex array
     glGenVertexArrays(1, &m_VAOId);
-    glBindVertexArray(m_VAOId);
+    GLState::BindVertexArray(m_VAOId);
 
     // Generate and bind the vertex buffer
     glGenBuffers(1, &m_vertexPositionBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
     glBufferData(GL_ARRAY_BUFFER, vcount * sizeof(float), vdata, GL_STATIC_DRAW);
 
     // Specify the layout for position data
@@ -54,7 +54,7 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount, unsigne
 
     // Generate and bind the index buffer
     glGenBuffers(1, &m_indexBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount * sizeof(unsigned int), idata, GL_STATIC_DRAW);
 }
 
@@ -69,10 +69,10 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount, unsigned
     static_assert(sizeof(GLfloat) == sizeof(float), "GLfloat and float sizes do not match");
 
     glGenVertexArrays(1, &m_VAOId);
-    glBindVertexArray(m_VAOId);
+    GLState::BindVertexArray(m_VAOId);
 
     glGenBuffers(1, &m_vertexPositionBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
     glBufferData(GL_ARRAY_BUFFER, vcount * sizeof(float), vdata, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0); // Position attribute
@@ -82,7 +82,7 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount, unsigned
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_TRUE, sizeof(float) * m_stride, (char*)(sizeof(float) * 3));
 
     glGenBuffers(1, &m_indexBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount * sizeof(unsigned int), idata, GL_STATIC_DRAW);
 }
 
@@ -97,10 +97,10 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount, unsigned
     static_assert(sizeof(GLfloat) == sizeof(float), "GLfloat and float sizes do not match");
 
     glGenVertexArrays(1, &m_VAOId);
-    glBindVertexArray(m_VAOId);
+    GLState::BindVertexArray(m_VAOId);
 
     glGenBuffers(1, &m_vertexPositionBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
     glBufferData(GL_ARRAY_BUFFER, vcount * sizeof(float), vdata, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0); // Position
@@ -119,7 +119,7 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount, unsigned
     glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(float) * m_stride, (char*)(sizeof(float) * 11));
 
     glGenBuffers(1, &m_indexBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount * sizeof(unsigned int), idata, GL_STATIC_DRAW);
 }
 
@@ -134,10 +134,10 @@ void VertexBufferLayout::CreateSkyboxBufferLayout(unsigned int vcount, unsigned
     static_assert(sizeof(GLfloat) == sizeof(float), "GLfloat and float sizes do not match");
 
     glGenVertexArrays(1, &m_VAOId);
-    glBindVertexArray(m_VAOId);
+    GLState::BindVertexArray(m_VAOId);
 
     glGenBuffers(1, &m_vertexPositionBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
     glBufferData(GL_ARRAY_BUFFER, vcount * sizeof(float), vdata, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0); // Position
@@ -153,8 +153,8 @@ void VertexBufferLayout::CreateSkyboxBufferLayout(unsigned int vcount, unsigned
     glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * m_stride, (char*)(sizeof(float) * 9));
 
     glGenBuffers(1, &m_indexBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount * sizeof(unsigned int), idata, GL_STATIC_DRAW);
 
-    glBindVertexArray(0); // Unbind vertex array
+    GLState::BindVertexArray(0); // Unbind vertex array
 }
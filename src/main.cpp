@@ -1,12 +1,240 @@
 #include "SDLGraphicsProgram.hpp"
+#include "Profiler.hpp"
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <sstream>
+#include <vector>
 
 int main(int argc, char** argv){
 
+	// Command line options
+	//   --aurora-compute  evaluate the aurora with the compute shader path
+	//   --aurora-bench    compare both aurora paths offscreen and exit
+	//   --bench           render frames offscreen in a hidden window, write
+	//                     a JSON report and exit (see the --bench-* options)
+	//   --bench-frames n  frames measured (default 300, after 30 warmup frames)
+	//   --bench-size WxH  resolution (default 1280x720)
+	//   --bench-quality q low, medium, high or ultra (default ultra)
+	//   --bench-out file  report file (default bench.json, - for stdout)
+	//   --frame-budget ms target frame time for the quality governor,
+	//                     0 keeps full quality (default 16.7)
+	//   --indirect        draw pooled meshes with glMultiDrawElementsIndirect
+	//   --gpu-culling     cull and draw the stress scene's nodes with compute
+	//                     shaders and one indirect draw
+	//   --serial          update and render one after the other instead of
+	//                     updating the next frame on a simulation thread
+	//   --sim-rate hz     fixed simulation steps per second (default 60)
+	//   --fps-cap fps     frame rate limit, 0 for none (default 60)
+	//   --vsync           pace frames with the display instead of the limiter
+	//   --frames-in-flight n  swapped frames the GPU may lag behind (default 2)
+	//   --no-late-latch   render with the camera of the update, not the latest
+	//   --record-path file  record the camera and input of every frame
+	//   --play-path file  play a recorded camera path deterministically and exit
+	//   --stress-nodes n  add a generated scene of n nodes under the skybox
+	//   --stress-branching n  children per generated node (default 8)
+	//   --stress-depth n  levels of the generated tree, 0 for as many as the
+	//                     node count needs (default 0)
+	//   --stress-meshes a.obj,b.obj  meshes the generated nodes cycle through
+	//   --stress-dynamic r  share of generated nodes that move (default 0.1)
+	//   --stress-occluders r  share of generated nodes that are occluders
+	//                     (default 0)
+	//   --stress-octree   cull the generated scene through an octree
+	//   --stress-sweep n,n,...  render generated scenes of each node count
+	//                     offscreen like --bench (--bench-frames and
+	//                     --bench-size apply), write a CSV and exit
+	//   --stress-out file CSV file of the sweep (default stress_sweep.csv,
+	//                     - for stdout)
+	//   --profile file    capture startup and the first frames as a Chrome
+	//                     trace (open in Perfetto)
+	//   --profile-frames n  frames captured (default 300, 0 until exit)
+	//   --flight-threshold ms  frame time that dumps the flight recorder,
+	//                     0 turns it off (default 100)
+	//   --flight-seconds s  seconds before the slow frame dumped (default 5)
+	//   --flight-out prefix  dumps go to <prefix>_<frame>.json (default flight)
+	AuroraPath auroraPath = AuroraPath::Fragment;
+	bool benchmarkAurora = false;
+	double frameBudgetMs = 1000.0 / 60.0;
+	bool indirectDraws = false;
+	bool gpuCulling = false;
+	bool pipelined = true;
+	double simulationRate = 60.0;
+	double frameRateCap = 60.0;
+	bool vsync = false;
+	int framesInFlight = 2;
+	bool lateLatch = true;
+	std::string recordPath;
+	std::string playPath;
+	bool bench = false;
+	int benchFrames = 300;
+	int benchWidth = 1280;
+	int benchHeight = 720;
+	std::string benchQuality = "ultra";
+	std::string benchOutput = "bench.json";
+	StressSceneSettings stress;
+	bool stressScene = false;
+	std::vector<size_t> stressSweep;
+	std::string stressOutput = "stress_sweep.csv";
+	std::string profilePath;
+	int profileFrames = 300;
+	double flightThresholdMs = 100.0;
+	double flightSeconds = 5.0;
+	std::string flightPrefix = "flight";
+	for(int i = 1; i < argc; ++i){
+		std::string arg = argv[i];
+		if(arg == "--aurora-compute"){
+			auroraPath = AuroraPath::Compute;
+		}else if(arg == "--frame-budget" && i + 1 < argc){
+			frameBudgetMs = std::atof(argv[++i]);
+		}else if(arg == "--indirect"){
+			indirectDraws = true;
+		}else if(arg == "--gpu-culling"){
+			gpuCulling = true;
+		}else if(arg == "--serial"){
+			pipelined = false;
+		}else if(arg == "--sim-rate" && i + 1 < argc){
+			simulationRate = std::atof(argv[++i]);
+		}else if(arg == "--fps-cap" && i + 1 < argc){
+			frameRateCap = std::atof(argv[++i]);
+		}else if(arg == "--vsync"){
+			vsync = true;
+		}else if(arg == "--frames-in-flight" && i + 1 < argc){
+			framesInFlight = std::atoi(argv[++i]);
+		}else if(arg == "--no-late-latch"){
+			lateLatch = false;
+		}else if(arg == "--record-path" && i + 1 < argc){
+			recordPath = argv[++i];
+		}else if(arg == "--play-path" && i + 1 < argc){
+			playPath = argv[++i];
+		}else if(arg == "--bench"){
+			bench = true;
+		}else if(arg == "--bench-frames" && i + 1 < argc){
+			benchFrames = std::max(1, std::atoi(argv[++i]));
+		}else if(arg == "--bench-size" && i + 1 < argc){
+			if(std::sscanf(argv[++i], "%dx%d", &benchWidth, &benchHeight) != 2 || benchWidth <= 0 || benchHeight <= 0){
+				std::cout << "[main.cpp]Bad --bench-size, expected WxH: " << argv[i] << std::endl;
+				return 1;
+			}
+		}else if(arg == "--bench-quality" && i + 1 < argc){
+			benchQuality = argv[++i];
+		}else if(arg == "--bench-out" && i + 1 < argc){
+			benchOutput = argv[++i];
+		}else if(arg == "--stress-nodes" && i + 1 < argc){
+			stress.nodeCount = std::strtoul(argv[++i], nullptr, 10);
+			stressScene = stress.nodeCount > 0;
+		}else if(arg == "--stress-branching" && i + 1 < argc){
+			stress.branching = std::max(1, std::atoi(argv[++i]));
+		}else if(arg == "--stress-depth" && i + 1 < argc){
+			stress.depth = std::max(0, std::atoi(argv[++i]));
+		}else if(arg == "--stress-meshes" && i + 1 < argc){
+			std::stringstream list(argv[++i]);
+			std::string mesh;
+			stress.meshes.clear();
+			while(std::getline(list, mesh, ',')){
+				if(!mesh.empty()){
+					stress.meshes.push_back(mesh);
+				}
+			}
+		}else if(arg == "--stress-dynamic" && i + 1 < argc){
+			stress.dynamicRatio = std::min(1.0f, std::max(0.0f, (float)std::atof(argv[++i])));
+		}else if(arg == "--stress-occluders" && i + 1 < argc){
+			stress.occluderRatio = std::min(1.0f, std::max(0.0f, (float)std::atof(argv[++i])));
+		}else if(arg == "--stress-octree"){
+			stress.spatialIndex = true;
+		}else if(arg == "--stress-sweep" && i + 1 < argc){
+			std::stringstream list(argv[++i]);
+			std::string count;
+			while(std::getline(list, count, ',')){
+				size_t nodes = std::strtoul(count.c_str(), nullptr, 10);
+				if(nodes > 0){
+					stressSweep.push_back(nodes);
+				}
+			}
+			std::sort(stressSweep.begin(), stressSweep.end());
+		}else if(arg == "--stress-out" && i + 1 < argc){
+			stressOutput = argv[++i];
+		}else if(arg == "--profile" && i + 1 < argc){
+			profilePath = argv[++i];
+		}else if(arg == "--profile-frames" && i + 1 < argc){
+			profileFrames = std::max(0, std::atoi(argv[++i]));
+		}else if(arg == "--flight-threshold" && i + 1 < argc){
+			flightThresholdMs = std::atof(argv[++i]);
+		}else if(arg == "--flight-seconds" && i + 1 < argc){
+			flightSeconds = std::max(0.1, std::atof(argv[++i]));
+		}else if(arg == "--flight-out" && i + 1 < argc){
+			flightPrefix = argv[++i];
+		}else if(arg == "--aurora-bench"){
+			benchmarkAurora = true;
+		}else{
+			std::cout << "[main.cpp]Unknown option: " << arg << std::endl;
+		}
+	}
+
+	int qualityTier = FrameGovernor::FindTier(benchQuality);
+	if((bench || !stressSweep.empty()) && qualityTier < 0){
+		std::cout << "[main.cpp]Unknown --bench-quality: " << benchQuality << std::endl;
+		return 1;
+	}
+
+	// Capture from startup, the program ends the capture with its frames
+	if(!profilePath.empty()){
+		Profiler::Get().BeginCapture(profilePath, profileFrames);
+	}
+
 	// Create an instance of an object for a SDLGraphicsProgram
-	SDLGraphicsProgram mySDLGraphicsProgram(1280,720);
+	bool headless = bench || !stressSweep.empty();
+	SDLGraphicsProgram mySDLGraphicsProgram(headless ? benchWidth : 1280, headless ? benchHeight : 720, headless);
 	std::cout << "[main.cpp]Created SDLGraphicsProgram" << std::endl;
+	mySDLGraphicsProgram.SetAuroraPath(auroraPath);
+	mySDLGraphicsProgram.SetFrameBudget(frameBudgetMs);
+	mySDLGraphicsProgram.SetIndirectDraws(indirectDraws);
+	mySDLGraphicsProgram.SetPipelined(pipelined);
+	if(simulationRate > 0.0){
+		mySDLGraphicsProgram.SetSimulationRate(simulationRate);
+	}
+	mySDLGraphicsProgram.SetFrameRateCap(frameRateCap);
+	mySDLGraphicsProgram.SetVsync(vsync);
+	mySDLGraphicsProgram.SetMaxFramesInFlight(framesInFlight);
+	mySDLGraphicsProgram.SetLateLatch(lateLatch);
+	if(!playPath.empty()){
+		mySDLGraphicsProgram.PlayCameraPath(playPath);
+	}else if(!recordPath.empty()){
+		mySDLGraphicsProgram.RecordCameraPath(recordPath);
+	}
+	if(gpuCulling){
+		mySDLGraphicsProgram.EnableGpuCulling();
+	}
+	if(!stressSweep.empty()){
+		if(!mySDLGraphicsProgram.IsInitialized()){
+			return 1;
+		}
+		mySDLGraphicsProgram.SetQualityTier(qualityTier);
+		bool written = mySDLGraphicsProgram.RunStressSweep(stress, stressSweep, benchFrames,
+		                                                   stressOutput == "-" ? "" : stressOutput);
+		return written ? 0 : 1;
+	}
+	if(stressScene){
+		mySDLGraphicsProgram.SetStressScene(stress);
+	}
+	if(bench){
+		if(!mySDLGraphicsProgram.IsInitialized()){
+			return 1;
+		}
+		mySDLGraphicsProgram.SetQualityTier(qualityTier);
+		bool written = mySDLGraphicsProgram.RunBenchmark(benchFrames, 30, benchOutput == "-" ? "" : benchOutput);
+		return written ? 0 : 1;
+	}
+	if(benchmarkAurora){
+		mySDLGraphicsProgram.BenchmarkAurora();
+		return 0;
+	}
+	// Keep the last seconds of zones, to see what a hitch was made of
+	if(flightThresholdMs > 0.0){
+		FlightRecorder::Get().Enable(flightThresholdMs, flightSeconds, flightPrefix);
+	}
 	// Run our program forever
 	mySDLGraphicsProgram.Loop();
 	// When our program ends, it will exit scope, the